@@ -0,0 +1,130 @@
+/** @file AABBTree.hpp
+ *  @brief A dynamic bounding volume hierarchy of axis aligned boxes.
+ *
+ *  Every leaf holds the box of one thing (a proxy), grown by a small
+ *  margin so that things moving a little do not have to be reinserted.
+ *  Inner nodes hold the box around their two children. Inserting picks
+ *  the sibling that adds the least surface area, and the path back up to
+ *  the root is kept height balanced with tree rotations, so queries only
+ *  visit O(log n) nodes on top of what they find.
+ *
+ *  For content that does not move, Rebuild builds the whole tree again
+ *  top down with the surface area heuristic (SAH), which gives tighter
+ *  boxes than inserting one at a time.
+ *
+ *  SceneNodes index their world bounds in AABBTree::Instance().
+ *
+ *  @author Mike
+ *  @bug No known bugs.
+ */
+#ifndef AABBTREE_HPP
+#define AABBTREE_HPP
+
+#include <vector>
+#include <functional>
+#include <cstdint>
+
+#include "Bounds.hpp"
+#include "Frustum.hpp"
+
+#include "glm/glm.hpp"
+
+class AABBTree{
+public:
+    // Identifies one thing in the tree
+    typedef int32_t Proxy;
+    static constexpr Proxy kNullProxy = -1;
+
+    // Return false to stop a query early
+    typedef std::function<bool(Proxy proxy)> QueryCallback;
+    // Called for each proxy whose box the ray enters within 'maxDistance'.
+    // Returns how far to keep looking: 'maxDistance' to find everything,
+    // the distance of a hit to only find closer ones, or a negative
+    // number to stop.
+    typedef std::function<float(Proxy proxy, float maxDistance)> RayCallback;
+
+    // The tree of the scene
+    static AABBTree& Instance();
+    // Constructor (for trees other than the scene's)
+    AABBTree();
+
+    // Adds 'bounds' to the tree, with 'user' to find what it belongs to
+    Proxy Insert(const Bounds& bounds, void* user);
+    // Takes a proxy out of the tree
+    void Remove(Proxy proxy);
+    // Gives a proxy new bounds. Returns true if it had to be reinserted,
+    // false if its grown box still holds the new bounds.
+    bool Move(Proxy proxy, const Bounds& bounds);
+    // Builds the tree again from its leaves with the surface area heuristic
+    void Rebuild();
+
+    // Retrieve what was passed to Insert
+    void* GetUser(Proxy proxy) const;
+    // Retrieve the grown box of a proxy
+    Bounds GetFatBounds(Proxy proxy) const;
+
+    // Every proxy whose box overlaps 'box'
+    void QueryBox(const Bounds& box, const QueryCallback& callback) const;
+    // Every proxy whose box overlaps the sphere
+    void QuerySphere(const glm::vec3& center, float radius, const QueryCallback& callback) const;
+    // Every proxy whose box is not entirely outside 'frustum'. Subtrees
+    // entirely inside are reported without testing what is below them.
+    void QueryFrustum(const Frustum& frustum, const QueryCallback& callback) const;
+    // Every proxy whose box the ray from 'origin' along 'direction' (need
+    // not be unit length; distances are in its units) enters before
+    // 'maxDistance'
+    void QueryRay(const glm::vec3& origin, const glm::vec3& direction, float maxDistance,
+                  const RayCallback& callback) const;
+
+    // Retrieve how many proxies there are
+    unsigned int GetCount() const;
+    // Retrieve the longest path from the root to a leaf (0 when empty)
+    int GetHeight() const;
+    // Retrieve the surface area of every inner node over that of the
+    // root: what a query pays, relative to the best case (lower is better)
+    float GetAreaRatio() const;
+    // Checks the links, boxes and heights of every node. Returns false
+    // (and prints what is wrong) if anything is broken.
+    bool Validate() const;
+
+private:
+    struct Node{
+        glm::vec3 min;
+        glm::vec3 max;
+        void* user;
+        // Next free node while on the free list
+        int32_t parent;
+        int32_t child1;
+        int32_t child2;
+        // Leaves are 0, free nodes -1
+        int32_t height;
+
+        bool IsLeaf() const { return child1 == kNullProxy; }
+    };
+
+    int32_t AllocateNode();
+    void FreeNode(int32_t node);
+    // Links a leaf into the tree next to the cheapest sibling
+    void InsertLeaf(int32_t leaf);
+    // Unlinks a leaf, dropping its old parent
+    void RemoveLeaf(int32_t leaf);
+    // Refits the nodes from 'node' up to the root, rotating where one
+    // side got too high
+    void FixUpwards(int32_t node);
+    // Rotates 'node' if its children differ in height by more than one.
+    // Returns the node now in its place.
+    int32_t Balance(int32_t node);
+    // Builds a subtree over leaves[begin, end) with the SAH
+    int32_t BuildSAH(std::vector<int32_t>& leaves, size_t begin, size_t end);
+    // Recomputes a node's box and height from its children
+    void Refit(int32_t node);
+    // Checks the subtree at 'node'. Returns false if it is broken.
+    bool ValidateNode(int32_t node, int32_t parent) const;
+
+    std::vector<Node> m_nodes;
+    int32_t m_root{kNullProxy};
+    int32_t m_freeList{kNullProxy};
+    unsigned int m_count{0};
+};
+
+#endif
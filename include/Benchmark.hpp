@@ -0,0 +1,34 @@
+/** @file Benchmark.hpp
+ *  @brief Command line benchmarks for the CPU side of the engine.
+ *
+ *  Run with './lab --bench'. The benchmarks do not open a window or
+ *  need OpenGL, they only exercise the mesh processing and scene graph
+ *  code on the same data the demo scene uses and print the results.
+ *
+ *  @author Mike
+ *  @bug No known bugs.
+ */
+#ifndef BENCHMARK_HPP
+#define BENCHMARK_HPP
+
+class Benchmark{
+public:
+    // Runs every benchmark. Returns 0 on success, or 1 if any
+    // benchmark found a wrong result.
+    static int Run();
+
+private:
+    // Compression ratio and decode speed of MeshCodec on the terrain, and
+    // cooked file loads from the page cache and from disk
+    static bool MeshCodecBenchmark();
+    // Parsing speed of MeshImporter on the terrain saved as OBJ and glb
+    static bool MeshImporterBenchmark();
+    // World transform updates of TransformHierarchy against a pointer
+    // linked tree, for scene graphs of up to 100k nodes
+    static bool TransformHierarchyBenchmark();
+    // Box, sphere, ray and frustum queries of AABBTree against testing
+    // every box, built incrementally and with the SAH
+    static bool AABBTreeBenchmark();
+};
+
+#endif
@@ -0,0 +1,39 @@
+/** @file Bounds.hpp
+ *  @brief An axis aligned box and a sphere around the same points.
+ *
+ *  Geometry computes the bounds of its vertices in object space; the
+ *  RenderQueue moves them into world space for culling. An empty
+ *  Bounds (no points added) has min above max and a negative radius.
+ *
+ *  @author Mike
+ *  @bug No known bugs.
+ */
+#ifndef BOUNDS_HPP
+#define BOUNDS_HPP
+
+#include "glm/glm.hpp"
+
+struct Bounds{
+    // The box
+    glm::vec3 min{1e30f};
+    glm::vec3 max{-1e30f};
+    // The sphere
+    glm::vec3 center{0.0f};
+    float radius{-1.0f};
+
+    // True until something has been added
+    bool IsEmpty() const;
+    // Half the size of the box along each axis
+    glm::vec3 GetExtents() const;
+    // Grows the box to hold 'point' (call UpdateSphere when done)
+    void Add(const glm::vec3& point);
+    // Grows the box and sphere to hold 'other' as well
+    void Add(const Bounds& other);
+    // Sets the sphere to the one around the box
+    void UpdateSphere();
+    // The bounds of these bounds after 'matrix' is applied. The box
+    // still holds every corner; the sphere grows with the largest scale.
+    Bounds Transformed(const glm::mat4& matrix) const;
+};
+
+#endif
@@ -12,6 +12,8 @@
 
 #include "glm/glm.hpp"
 
+#include "Frustum.hpp"
+
 class Camera{
 public:
 	// Constructor to create a camera
@@ -19,6 +21,15 @@ public:
     // Return a 'view' matrix with our
     // camera transformation applied.
     glm::mat4 GetWorldToViewmatrix() const;
+    // Computes the view, view-projection and frustum for 'projection'
+    // once, for everything that draws this view to share
+    void UpdateMatrices(const glm::mat4& projection);
+    // Retrieve the matrices as of the last UpdateMatrices
+    const glm::mat4& GetViewMatrix() const;
+    const glm::mat4& GetProjectionMatrix() const;
+    const glm::mat4& GetViewProjectionMatrix() const;
+    // Retrieve the world space frustum as of the last UpdateMatrices
+    const Frustum& GetFrustum() const;
     // Move the camera around
     void MouseLook(int mouseX, int mouseY);
     void MoveForward(float speed);
@@ -56,6 +67,11 @@ private:
 
     // Track the old mouse position
     glm::vec2 m_oldMousePosition;
+    // Cached by UpdateMatrices
+    glm::mat4 m_view{1.0f};
+    glm::mat4 m_projection{1.0f};
+    glm::mat4 m_viewProjection{1.0f};
+    Frustum m_frustum;
 };
 
 
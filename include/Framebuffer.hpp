@@ -15,9 +15,9 @@
 #include <memory>
 #include <string>
 
-// Each Framebuffer can have a custom shader so we
-// are forward declaring the class.
-class Shader;
+#include "GpuResource.hpp"
+// Each Framebuffer can have a custom shader
+#include "Shader.hpp"
 
 class Framebuffer{
 public:
@@ -43,18 +43,22 @@ private:
 public:
     std::shared_ptr<Shader> m_fboShader;
     // Our framebuffer also needs a texture.
-    unsigned int m_colorBuffer_id;
+    GpuResource m_colorBuffer;
     // the camera ID within the m_cameras vector that this framebuffer belongs to
     int camera_id;
 // private member variables
 private:
+    // Shown as the owner of our GL objects in GpuResources reports
+    std::string m_name;
+    // The texture sampler of m_fboShader
+    Shader::Uniform m_diffuseMapUniform;
     // Framebuffer id
-    unsigned int m_fbo_id; 
+    GpuResource m_fbo; 
     // Finally create our render buffer object
-    unsigned int m_rbo_id;
+    GpuResource m_rbo;
     // Store our screen buffer
-    unsigned int m_quadVAO;
-    unsigned int m_quadVBO;
+    GpuResource m_quadVAO;
+    GpuResource m_quadVBO;
 
 };
 
@@ -0,0 +1,49 @@
+/** @file Frustum.hpp
+ *  @brief The six planes bounding what a camera can see.
+ *
+ *  The planes are pulled out of a (projection * view * model) matrix,
+ *  so they live in whatever space that matrix starts from.
+ *
+ *  Besides the planes themselves, their components are kept one array
+ *  per component (structure of arrays), padded to eight planes, so that
+ *  TestBox can check a box against four planes per SSE instruction.
+ *
+ *  @author Mike
+ *  @bug No known bugs.
+ */
+#ifndef FRUSTUM_HPP
+#define FRUSTUM_HPP
+
+#include "glm/glm.hpp"
+
+class Frustum{
+public:
+    // Constructor (all planes accept everything until Extract is called)
+    Frustum();
+    // Builds the planes from a combined projection * view (* model) matrix
+    void Extract(const glm::mat4& matrix);
+    // Returns false if the sphere is completely outside of the frustum
+    bool IsSphereVisible(const glm::vec3& center, float radius) const;
+    // Where a box is relative to the frustum
+    enum class Containment { Outside, Intersecting, Inside };
+    // Classifies the box at 'center' reaching 'extents' along each axis.
+    // Outside and Inside are exact per plane; a box crossing the corner
+    // region just outside the frustum can report Intersecting.
+    Containment TestBox(const glm::vec3& center, const glm::vec3& extents) const;
+    // Planes are stored as (normal, distance) with the normal pointing inside.
+    // Order: left, right, bottom, top, near, far
+    glm::vec4 m_planes[6];
+
+private:
+    // Planes 6 and 7 of the padded copies accept everything
+    static const int kPaddedPlanes = 8;
+    // The planes of m_planes, one component per array
+    alignas(16) float m_normalX[kPaddedPlanes];
+    alignas(16) float m_normalY[kPaddedPlanes];
+    alignas(16) float m_normalZ[kPaddedPlanes];
+    alignas(16) float m_distance[kPaddedPlanes];
+    // Copies m_planes into the arrays above
+    void UpdatePadded();
+};
+
+#endif
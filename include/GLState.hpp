@@ -0,0 +1,88 @@
+/** @file GLState.hpp
+ *  @brief Remembers the OpenGL state we set, and skips calls that
+ *         would not change it.
+ *
+ *  Binding the same program, vertex array or texture again costs a
+ *  driver call (and often validation work inside the driver) but does
+ *  nothing. Every bind, enable and program switch in the renderer goes
+ *  through this class instead of calling OpenGL directly, so repeated
+ *  calls are filtered out here.
+ *
+ *  This only works if nothing else changes the same state behind our
+ *  back. Code that calls OpenGL directly for any of the state below
+ *  must call Invalidate afterwards.
+ *
+ *  The number of calls that were issued and filtered is counted per
+ *  frame (see EndFrame and PrintStats).
+ *
+ *  @author Mike
+ *  @bug No known bugs.
+ */
+#ifndef GLSTATE_HPP
+#define GLSTATE_HPP
+
+#include <glad/glad.h>
+
+class GLState{
+public:
+    // The kinds of calls that are counted
+    enum Call{
+        Program,
+        VertexArray,
+        Buffer,
+        Texture,
+        ActiveTexture,
+        Framebuffer,
+        Capability,
+        Viewport,
+        PolygonMode,
+        kCallCount
+    };
+
+    // Calls made during one frame
+    struct Counters{
+        unsigned int issued[kCallCount];
+        unsigned int filtered[kCallCount];
+    };
+
+    // glUseProgram
+    static void UseProgram(GLuint program);
+    // glBindVertexArray
+    static void BindVertexArray(GLuint vertexArray);
+    // glBindBuffer. GL_ELEMENT_ARRAY_BUFFER belongs to the bound vertex
+    // array, so it is forgotten whenever the vertex array changes.
+    static void BindBuffer(GLenum target, GLuint buffer);
+    // glBindBufferRange for GL_UNIFORM_BUFFER. This also binds 'buffer'
+    // to GL_UNIFORM_BUFFER itself.
+    static void BindUniformBufferRange(GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size);
+    // glActiveTexture (if needed) followed by glBindTexture
+    static void BindTexture(unsigned int unit, GLenum target, GLuint texture);
+    // glBindFramebuffer. GL_FRAMEBUFFER sets both the draw and read target.
+    static void BindFramebuffer(GLenum target, GLuint framebuffer);
+    // glEnable and glDisable
+    static void Enable(GLenum capability);
+    static void Disable(GLenum capability);
+    // glViewport
+    static void SetViewport(GLint x, GLint y, GLsizei width, GLsizei height);
+    // glPolygonMode for GL_FRONT_AND_BACK (the only face core profile allows)
+    static void SetPolygonMode(GLenum mode);
+
+    // Must be called when an object is deleted: OpenGL unbinds it and may
+    // hand its name out again, so we must not believe it is still bound
+    static void ForgetBuffer(GLuint buffer);
+    static void ForgetTexture(GLuint texture);
+    static void ForgetVertexArray(GLuint vertexArray);
+    static void ForgetFramebuffer(GLuint framebuffer);
+    static void ForgetProgram(GLuint program);
+    // Forget everything, so the next call of each kind is always issued
+    static void Invalidate();
+
+    // Closes the counters of the current frame and starts new ones
+    static void EndFrame();
+    // Counters of the last finished frame
+    static const Counters& GetLastFrame();
+    // Prints the last frame and the average over all frames
+    static void PrintStats();
+};
+
+#endif
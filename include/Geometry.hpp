@@ -12,6 +12,9 @@
 
 #include <vector>
 
+#include "Meshlet.hpp"
+#include "Bounds.hpp"
+
 // Purpose of this class is to store vertice and triangle information
 class Geometry{
 public:
@@ -26,6 +29,9 @@ public:
 	unsigned int GetBufferDataSize();
 	// Retrieve the Buffer Data Pointer
 	float* GetBufferDataPtr();
+	// Makes room for this many vertices and indices up front
+	// (useful for importers that know the final size)
+	void Reserve(unsigned int vertexCount, unsigned int indexCount);
 	// Add a new vertex 
 	void AddVertex(float x, float y, float z, float s, float t);
 	// Allows for adding one index at a time manually if 
@@ -35,9 +41,26 @@ public:
 	void Gen();
 	// Functions for working with Indices
 	// Creates a triangle from 3 indicies
-	// When a triangle is made, the tangents and bi-tangents are also
-	// computed
+	// Normals, tangents and bi-tangents are computed for the whole
+	// mesh at once in ComputeTangentSpace (called from Gen).
 	void MakeTriangle(unsigned int vert0, unsigned int vert1, unsigned int vert2);  
+	// How the face normals of the triangles around a vertex are
+	// weighted when they are averaged together.
+	enum class NormalWeighting { Area, Angle };
+	// Computes smooth normals, tangents and bi-tangents for every vertex
+	// from all of the triangles that share it. The work is split across
+	// threads. Tangents follow the MikkTSpace conventions: angle weighted,
+	// orthogonalized against the normal, and the bi-tangent is rebuilt
+	// as sign * cross(normal, tangent).
+	void ComputeTangentSpace(NormalWeighting weighting = NormalWeighting::Angle);
+	// Splits the mesh into meshlets of nearby triangles.
+	// The index list is reordered so that the triangles of each meshlet
+	// sit next to each other, so call this before uploading the indices.
+	void BuildMeshlets(unsigned int maxVertices = 64, unsigned int maxTriangles = 124);
+	// Retrieve the meshlets made by BuildMeshlets (empty if never called)
+	const std::vector<Meshlet>& GetMeshlets() const;
+	// Retrieve the box and sphere around every vertex (computed by Gen)
+	const Bounds& GetBounds() const;
     // Retrieve how many indicies there are
 	unsigned int GetIndicesSize();
     // Retrieve the pointer to the indices
@@ -57,6 +80,10 @@ private:
 
 	// The indices for a indexed-triangle mesh
 	std::vector<unsigned int> m_indices;
+	// Clusters of triangles within m_indices
+	std::vector<Meshlet> m_meshlets;
+	// Object space bounds of m_vertexPositions
+	Bounds m_bounds;
 };
 
 
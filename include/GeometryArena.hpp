@@ -0,0 +1,112 @@
+/** @file GeometryArena.hpp
+ *  @brief One shared vertex and index buffer per vertex format.
+ *
+ *  Rather than every mesh owning a vertex array, a vertex buffer and an
+ *  index buffer, all meshes of the same VertexFormat are packed into
+ *  one large pair of buffers with a single vertex array. Switching
+ *  between meshes is then only a matter of different offsets in the
+ *  draw call: indices stay relative to their own mesh and are drawn
+ *  with glDrawElementsBaseVertex.
+ *
+ *  Space is handed out by a RangeAllocator. When a mesh does not fit,
+ *  the arena first tries to pack all meshes to the front (Defragment)
+ *  and otherwise grows its buffers. Both copy data on the GPU with
+ *  glCopyBufferSubData, so nothing is read back.
+ *
+ *  Meshes refer to their data by a Handle, because defragmenting moves
+ *  the data around. Ask for the offsets when drawing, not before.
+ *
+ *  @author Mike
+ *  @bug No known bugs.
+ */
+#ifndef GEOMETRYARENA_HPP
+#define GEOMETRYARENA_HPP
+
+#include <glad/glad.h>
+
+#include <vector>
+
+#include "VertexBufferLayout.hpp"
+#include "RangeAllocator.hpp"
+#include "GpuResource.hpp"
+
+class GeometryArena{
+public:
+    // Identifies one mesh inside the arena
+    typedef unsigned int Handle;
+    static const Handle kInvalidHandle = 0xffffffff;
+
+    // Retrieve the arena for a vertex format (created on first use)
+    static GeometryArena& Get(VertexFormat format);
+    // Prints occupancy and fragmentation of every arena that is in use
+    static void PrintReports();
+    // Deletes the GL objects of every arena.
+    // Must be called while the OpenGL context still exists.
+    static void ReleaseAll();
+
+    // Destructor
+    ~GeometryArena();
+    // An arena owns GPU buffers, so it cannot be copied
+    GeometryArena(const GeometryArena&) = delete;
+    GeometryArena& operator=(const GeometryArena&) = delete;
+
+    // Copies 'vertexCount' vertices (in this arena's format) and
+    // 'indexCount' indices into the arena.
+    Handle Allocate(unsigned int vertexCount, unsigned int indexCount, const float* vdata, const unsigned int* idata);
+    // Gives the space of a mesh back
+    void Free(Handle handle);
+    // Packs every mesh to the front of the buffers, so that all free
+    // space is in one block at the end
+    void Defragment();
+    // Selects the vertex array of this arena (the index buffer is part of it)
+    void Bind();
+    // Retrieve the vertex array Bind selects
+    GLuint GetVertexArray() const;
+
+    // Value to pass as 'basevertex' when drawing the mesh
+    GLint GetBaseVertex(Handle handle) const;
+    // Position of the mesh's first index in the index buffer
+    unsigned int GetFirstIndex(Handle handle) const;
+    // Number of indices of the mesh
+    unsigned int GetIndexCount(Handle handle) const;
+    // Prints occupancy and fragmentation of this arena
+    void PrintReport() const;
+
+private:
+    // Arenas are only created by Get
+    GeometryArena(VertexFormat format);
+    // Creates buffers with room for this many vertices and indices,
+    // copying over whatever the old buffers held
+    void Reserve(unsigned int vertexCapacity, unsigned int indexCapacity);
+    // Deletes the GL objects
+    void Release();
+
+    // Where one mesh lives in the arena
+    struct Allocation{
+        unsigned int vertexOffset;
+        unsigned int vertexCount;
+        unsigned int indexOffset;
+        unsigned int indexCount;
+        bool live;
+    };
+
+    VertexFormat m_format;
+    // Bytes per vertex
+    unsigned int m_vertexSize;
+    // GL objects
+    GpuResource m_vertexArray;
+    GpuResource m_vertexBuffer;
+    GpuResource m_indexBuffer;
+    // Space in vertices and indices
+    RangeAllocator m_vertices;
+    RangeAllocator m_indices;
+    // Indexed by Handle
+    std::vector<Allocation> m_allocations;
+    // Handles of freed allocations, reused first
+    std::vector<Handle> m_freeHandles;
+    // Number of times Defragment or Reserve moved the data
+    unsigned int m_defragmentCount{0};
+    unsigned int m_growCount{0};
+};
+
+#endif
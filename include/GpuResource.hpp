@@ -0,0 +1,89 @@
+/** @file GpuResource.hpp
+ *  @brief Owns OpenGL objects and keeps count of the GPU memory they use.
+ *
+ *  A GpuResource is a handle to one buffer, texture, renderbuffer,
+ *  framebuffer or vertex array. It deletes the object when it goes
+ *  away, so classes that hold GpuResources instead of raw GLuints
+ *  cannot leak them.
+ *
+ *  Every live object is registered in GpuResources together with an
+ *  owner (what it belongs to, e.g. a file name) and a category (what
+ *  it is used for, e.g. "Mesh" or "Framebuffer"). Code that fills an
+ *  object reports its estimated size with SetBytes. PrintReport shows
+ *  the totals, and CheckLeaks lists whatever is still alive when the
+ *  program shuts down.
+ *
+ *  @author Mike
+ *  @bug No known bugs.
+ */
+#ifndef GPURESOURCE_HPP
+#define GPURESOURCE_HPP
+
+#include <glad/glad.h>
+
+#include <string>
+#include <cstddef>
+
+enum class GpuResourceType{
+    Buffer,
+    Texture,
+    Renderbuffer,
+    Framebuffer,
+    VertexArray
+};
+
+class GpuResource{
+public:
+    // Constructor. Holds nothing until Create is called.
+    GpuResource();
+    // Destructor. Deletes the GL object.
+    ~GpuResource();
+    // Ownership can be moved, but not copied
+    GpuResource(GpuResource&& other);
+    GpuResource& operator=(GpuResource&& other);
+    GpuResource(const GpuResource&) = delete;
+    GpuResource& operator=(const GpuResource&) = delete;
+
+    // Generates a new GL object, deleting the one held before
+    void Create(GpuResourceType type, const std::string& owner, const char* category);
+    // Deletes the GL object
+    void Release();
+    // Records how much GPU memory the object is expected to use
+    void SetBytes(size_t bytes);
+
+    // Retrieve the GL name (0 if there is none)
+    GLuint Get() const { return m_id; }
+    // True if a GL object is held
+    bool IsValid() const { return m_id != 0; }
+    GpuResourceType GetType() const { return m_type; }
+
+private:
+    GpuResourceType m_type{GpuResourceType::Buffer};
+    GLuint m_id{0};
+};
+
+class GpuResources{
+public:
+    // Total estimated bytes of every live object of 'type'
+    static size_t GetBytes(GpuResourceType type);
+    // Number of live objects of 'type'
+    static unsigned int GetCount(GpuResourceType type);
+    // Prints the objects and bytes per category and per type
+    static void PrintReport();
+    // Prints every object that is still alive and returns how many
+    // there are. Call after everything should have been freed.
+    static unsigned int CheckLeaks();
+
+    // Estimated size of a 'width' x 'height' image in 'internalFormat',
+    // including the smaller levels if it has 'mipmaps'
+    static size_t GetImageBytes(GLenum internalFormat, int width, int height, bool mipmaps = false);
+
+private:
+    // Used by GpuResource to keep the registry up to date
+    friend class GpuResource;
+    static void Add(GpuResourceType type, GLuint id, const std::string& owner, const char* category);
+    static void Remove(GpuResourceType type, GLuint id);
+    static void SetBytes(GpuResourceType type, GLuint id, size_t bytes);
+};
+
+#endif
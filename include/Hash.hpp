@@ -0,0 +1,48 @@
+/** @file Hash.hpp
+ *  @brief Small non-cryptographic hash functions.
+ *
+ *  Used to build keys for files and objects we cache
+ *  (cooked meshes, shader programs, etc.).
+ *
+ *  @author Mike
+ *  @bug No known bugs.
+ */
+#ifndef HASH_HPP
+#define HASH_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+// The starting value of a 64-bit FNV-1a hash
+const uint64_t kHashSeed = 14695981039346656037ULL;
+
+// 64-bit FNV-1a hash of 'size' bytes.
+// Pass the result of a previous call as 'seed' to hash several
+// pieces of data one after the other.
+inline uint64_t HashBytes(const void* data, size_t size, uint64_t seed = kHashSeed){
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    uint64_t hash = seed;
+    for(size_t i=0; i < size; ++i){
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+// Hash a string (the terminating null is not included)
+inline uint64_t HashString(const std::string& s, uint64_t seed = kHashSeed){
+    return HashBytes(s.data(), s.size(), seed);
+}
+
+// Hash the sources of a program (vertex, then fragment shader)
+inline uint64_t HashProgramSources(const std::string& vertexSource, const std::string& fragmentSource,
+                                   uint64_t seed = kHashSeed){
+    uint64_t hash = HashString(vertexSource, seed);
+    // Keep "ab" + "c" apart from "a" + "bc"
+    uint64_t separator = vertexSource.size();
+    hash = HashBytes(&separator, sizeof(separator), hash);
+    return HashString(fragmentSource, hash);
+}
+
+#endif
@@ -0,0 +1,48 @@
+/** @file MappedFile.hpp
+ *  @brief Maps a whole file into memory for reading.
+ *
+ *  On Linux and Mac the file is mapped with mmap, so no copy
+ *  is made and pages are only read from disk when touched.
+ *  Other platforms fall back to reading the file into memory.
+ *
+ *  @author Mike
+ *  @bug No known bugs.
+ */
+#ifndef MAPPEDFILE_HPP
+#define MAPPEDFILE_HPP
+
+#include <string>
+#include <vector>
+#include <cstddef>
+
+class MappedFile{
+public:
+    // Constructor
+    MappedFile();
+    // Destructor unmaps the file
+    ~MappedFile();
+    // A mapping cannot be shared between two objects
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    // Maps the file at 'path'. Returns false if the file
+    // could not be opened.
+    bool Open(const std::string& path);
+    // Unmaps the file (also done by the destructor)
+    void Close();
+    // Returns true if a file is currently mapped
+    bool IsOpen() const;
+    // Retrieve a pointer to the first byte of the file
+    const unsigned char* GetData() const;
+    // Retrieve the size of the file in bytes
+    size_t GetSize() const;
+
+private:
+    // Start of the mapped file
+    const unsigned char* m_data;
+    // Size in bytes
+    size_t m_size;
+    // Only used on platforms without mmap
+    std::vector<unsigned char> m_fallback;
+};
+
+#endif
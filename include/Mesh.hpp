@@ -0,0 +1,72 @@
+/** @file Mesh.hpp
+ *  @brief Geometry together with the GPU buffers it was uploaded to.
+ *
+ *  A Mesh can be shared by any number of Objects (see MeshCache),
+ *  so that identical shapes only exist once on the GPU.
+ *
+ *  The GPU data lives in the GeometryArena for the mesh's vertex
+ *  format, together with every other mesh of that format.
+ *
+ *  @author Mike
+ *  @bug No known bugs.
+ */
+#ifndef MESH_HPP
+#define MESH_HPP
+
+#include <vector>
+
+#include "Geometry.hpp"
+#include "GeometryArena.hpp"
+#include "Meshlet.hpp"
+
+class MeshFile;
+
+class Mesh{
+public:
+    // Constructor
+    Mesh();
+    // Destructor
+    ~Mesh();
+    // A mesh owns GPU buffers, so it cannot be copied
+    Mesh(const Mesh&) = delete;
+    Mesh& operator=(const Mesh&) = delete;
+    // Retrieve the geometry to fill in before calling Upload
+    Geometry& GetGeometry();
+    // Generates the vertex data and copies it into the GeometryArena.
+    // Any meshlets built on the geometry are kept for culling.
+    void Upload();
+    // Copies a cooked mesh file straight into the GeometryArena
+    void Upload(const MeshFile& cooked);
+    // Copies vertices already in the VertexFormat::Normal layout (see
+    // Geometry::Gen) straight into the GeometryArena. The meshlets are
+    // kept for culling.
+    void Upload(const std::vector<float>& vertexData, const std::vector<unsigned int>& indices,
+                const std::vector<Meshlet>& meshlets);
+    // Select the buffers of this mesh for drawing
+    // (shared by every mesh of the same format)
+    void Bind();
+    // Retrieve the vertex array Bind selects
+    GLuint GetVertexArray() const;
+    // Retrieve how many indices to draw
+    unsigned int GetIndexCount() const;
+    // Retrieve where the mesh's indices start in the bound index buffer
+    unsigned int GetFirstIndex() const;
+    // Retrieve the 'basevertex' for glDrawElementsBaseVertex
+    GLint GetBaseVertex() const;
+    // Retrieve the meshlets of this mesh (may be empty)
+    const std::vector<Meshlet>& GetMeshlets() const;
+    // Retrieve the object space bounds of the mesh
+    const Bounds& GetBounds() const;
+
+private:
+    // CPU side copy of the data (empty when loaded from a cooked file)
+    Geometry m_geometry;
+    // Our data inside the arena for VertexFormat::Normal
+    GeometryArena::Handle m_arenaHandle{GeometryArena::kInvalidHandle};
+    // Clusters of triangles that can be culled separately
+    std::vector<Meshlet> m_meshlets;
+    // Box and sphere around every vertex
+    Bounds m_bounds;
+};
+
+#endif
@@ -0,0 +1,42 @@
+/** @file MeshCache.hpp
+ *  @brief This Singleton class shares meshes between objects.
+ *
+ *  Meshes are stored under a key that describes how they were made
+ *  (e.g. "quad" or "sphere(30,30)"). Asking for the same key again
+ *  returns the same Mesh, and so the same GPU buffers.
+ *
+ *  The cache only holds weak references: a mesh is freed as soon
+ *  as the last object using it goes away.
+ *
+ *  @author Mike
+ *  @bug No known bugs.
+ */
+#ifndef MESHCACHE_HPP
+#define MESHCACHE_HPP
+
+#include <unordered_map>
+#include <memory>
+#include <string>
+#include <functional>
+
+#include "Mesh.hpp"
+
+class MeshCache{
+public:
+    // Singleton pattern for having one single MeshCache
+    static MeshCache& Instance();
+    // Returns the mesh stored under 'key'. If there is none, a new mesh
+    // is made, 'build' is called to fill in its geometry, and it is uploaded.
+    std::shared_ptr<Mesh> Get(const std::string& key, const std::function<void(Geometry&)>& build);
+    // Retrieve how many meshes are currently alive in the cache
+    unsigned int GetMeshCount();
+
+private:
+    // Constructor is private because we should
+    // not be able to construct any other caches
+    MeshCache();
+    // Meshes that have been made so far
+    std::unordered_map<std::string, std::weak_ptr<Mesh>> m_meshes;
+};
+
+#endif
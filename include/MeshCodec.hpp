@@ -0,0 +1,56 @@
+/** @file MeshCodec.hpp
+ *  @brief Lossless compression of index and vertex data.
+ *
+ *  Both indices and vertices are treated as streams of 32-bit words
+ *  (one word per index, stride/4 words per vertex) and go through the
+ *  same steps:
+ *
+ *  (1) Delta: each word is replaced by its difference to the same word
+ *      of the previous element (the previous index, or the same
+ *      attribute of the previous vertex).
+ *  (2) Zigzag: small negative differences become small positive numbers.
+ *  (3) Byte planes: all of the lowest bytes are stored together, then all
+ *      of the second bytes, and so on. High bytes are nearly always zero.
+ *  (4) Entropy: each byte plane is compressed with a 32-way interleaved
+ *      rANS coder, or stored as a constant, as a constant with a few
+ *      exceptions, or raw, whichever is smallest.
+ *
+ *  The rANS decoder runs 32 states in four AVX2 registers, looking up
+ *  symbols with gathers, when the CPU has AVX2 (checked at run time, so
+ *  the build needs no flags). Otherwise it decodes a symbol at a time.
+ *  Every plane is decoded a block of elements at a time, and (3), (2)
+ *  and (1) are undone on that block with SSE2 while it is in cache,
+ *  16 elements and four words of each at a time.
+ *  Indices compress best when they are in vertex cache friendly order,
+ *  which is what Geometry::BuildMeshlets produces.
+ *
+ *  @author Mike
+ *  @bug No known bugs.
+ */
+#ifndef MESHCODEC_HPP
+#define MESHCODEC_HPP
+
+#include <vector>
+#include <cstddef>
+
+class MeshCodec{
+public:
+    // Compresses 'count' indices and appends the result to 'out'
+    static void EncodeIndices(const unsigned int* indices, unsigned int count, std::vector<unsigned char>& out);
+    // Decompresses exactly 'count' indices. Returns false if the data is broken.
+    static bool DecodeIndices(const unsigned char* data, size_t size, unsigned int* indices, unsigned int count);
+
+    // Compresses 'count' vertices of 'stride' bytes each (stride must be
+    // a multiple of 4) and appends the result to 'out'
+    static void EncodeVertices(const void* vertices, unsigned int count, unsigned int stride, std::vector<unsigned char>& out);
+    // Decompresses exactly 'count' vertices of 'stride' bytes.
+    // Returns false if the data is broken.
+    static bool DecodeVertices(const unsigned char* data, size_t size, void* vertices, unsigned int count, unsigned int stride);
+
+private:
+    // Shared by the functions above: 'words' 32-bit words per element
+    static void EncodeWords(const unsigned int* input, unsigned int count, unsigned int words, std::vector<unsigned char>& out);
+    static bool DecodeWords(const unsigned char* data, size_t size, unsigned int* output, unsigned int count, unsigned int words);
+};
+
+#endif
@@ -0,0 +1,123 @@
+/** @file MeshFile.hpp
+ *  @brief Reads and writes 'cooked' binary mesh files.
+ *
+ *  A cooked mesh holds the interleaved vertex data and the index data
+ *  exactly as they are sent to OpenGL, so loading is just a matter of
+ *  mapping the file and passing the pointers to glBufferData.
+ *
+ *  Optionally the vertex and index sections are compressed with
+ *  MeshCodec (see MeshFile::kFlagCompressed). That makes the file much
+ *  smaller, at the cost of decoding it into memory when it is loaded.
+ *  It is only quicker to load when the disk reads slower than MeshCodec
+ *  decodes; './lab --bench' measures both.
+ *
+ *  File layout (little endian, every section starts on a 64 byte boundary):
+ *      MeshFileHeader      (256 bytes, includes the vertex format)
+ *      vertex data         (vertexCount * vertexStride bytes, or compressed)
+ *      index data          (indexCount * 4 bytes, or compressed)
+ *      meshlets            (meshletCount * sizeof(Meshlet) bytes, optional)
+ *
+ *  @author Mike
+ *  @bug No known bugs.
+ */
+#ifndef MESHFILE_HPP
+#define MESHFILE_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "MappedFile.hpp"
+#include "Geometry.hpp"
+
+// Describes one attribute inside the interleaved vertex data
+struct MeshFileAttribute{
+    // Attribute location in the shader
+    uint32_t location;
+    // Number of components (e.g. 3 for x,y,z)
+    uint32_t components;
+    // GL type of each component (e.g. GL_FLOAT)
+    uint32_t type;
+    // Byte offset from the start of the vertex
+    uint32_t offset;
+};
+
+// Fixed size header at the start of every cooked mesh
+struct MeshFileHeader{
+    static const uint32_t kMaxAttributes = 8;
+
+    char magic[4];
+    uint32_t version;
+    uint32_t headerSize;
+    uint32_t flags;
+    // Vertex format descriptor
+    uint32_t vertexCount;
+    uint32_t vertexStride;
+    uint32_t attributeCount;
+    uint32_t indexType;
+    uint32_t indexCount;
+    uint32_t meshletCount;
+    uint32_t reserved[2];
+    MeshFileAttribute attributes[kMaxAttributes];
+    // Object space bounding box
+    float boundsMin[3];
+    float boundsMax[3];
+    // Identifies what the mesh was cooked from, so stale files are rebuilt
+    uint64_t sourceKey;
+    // Where the data lives in the file
+    uint64_t vertexDataOffset;
+    uint64_t vertexDataSize;
+    uint64_t indexDataOffset;
+    uint64_t indexDataSize;
+    uint64_t meshletDataOffset;
+    uint64_t meshletDataSize;
+};
+
+class MeshFile{
+public:
+    // Bump this whenever the layout of the file changes
+    static const uint32_t kVersion = 4;
+    // Every section in the file starts on this boundary
+    static const uint32_t kAlignment = 64;
+    // Set in MeshFileHeader::flags when the vertex and index data are compressed
+    static const uint32_t kFlagCompressed = 1 << 0;
+
+    // Constructor
+    MeshFile();
+    // Destructor (unmaps the file)
+    ~MeshFile();
+    // Writes the geometry to 'path'. Gen() must have been called on the geometry.
+    // sourceKey should change whenever the data the mesh was built from changes.
+    // With 'compress' the vertex and index data are stored with MeshCodec.
+    static bool Cook(Geometry& geometry, const std::string& path, uint64_t sourceKey, bool compress=false);
+    // Maps a cooked mesh. Returns false if the file is missing, was written by
+    // another version, was cooked from a different source or uses a vertex
+    // format we do not know how to draw.
+    // Compressed files are decoded here; all others are used in place.
+    bool Load(const std::string& path, uint64_t sourceKey);
+    // Retrieve the header of the loaded file
+    const MeshFileHeader& GetHeader() const;
+    // Retrieve a pointer to the interleaved vertex data
+    const float* GetBufferDataPtr() const;
+    // Retrieve the number of floats in the vertex data
+    unsigned int GetBufferDataSize() const;
+    // Retrieve a pointer to the indices
+    const unsigned int* GetIndicesDataPtr() const;
+    // Retrieve how many indices there are
+    unsigned int GetIndicesSize() const;
+    // Retrieve the meshlets stored with the mesh (may be none)
+    const Meshlet* GetMeshletsPtr() const;
+    // Retrieve how many meshlets there are
+    unsigned int GetMeshletsSize() const;
+
+private:
+    // The mapping of the file on disk
+    MappedFile m_file;
+    // Points into the mapped file
+    const MeshFileHeader* m_header;
+    // Decoded data of a compressed file (empty otherwise)
+    std::vector<float> m_vertexData;
+    std::vector<unsigned int> m_indexData;
+};
+
+#endif
@@ -0,0 +1,49 @@
+/** @file MeshImporter.hpp
+ *  @brief Loads meshes from Wavefront OBJ and glTF 2.0 files.
+ *
+ *  Files are mapped into memory (see MappedFile) and parsed in place.
+ *  Numbers are parsed by hand, so the result never depends on the
+ *  current C locale (strtod and atof read "1,5" in some locales).
+ *
+ *  OBJ files are split into line ranges which are parsed on separate
+ *  threads, and are then merged in file order.
+ *
+ *  glTF files may be .gltf (JSON with external or base64 buffers) or
+ *  .glb (JSON and binary buffer in one file). Every triangle primitive
+ *  of every mesh is imported in the mesh's own space; node transforms,
+ *  materials and sparse accessors are not supported.
+ *
+ *  Only positions and texture coordinates are read. Normals and
+ *  tangents are always rebuilt by Geometry::Gen. Vertices with the
+ *  same position and texture coordinate are welded into one while the
+ *  file is read.
+ *
+ *  @author Mike
+ *  @bug No known bugs.
+ */
+#ifndef MESHIMPORTER_HPP
+#define MESHIMPORTER_HPP
+
+#include <string>
+#include <cstddef>
+
+#include "Geometry.hpp"
+
+class MeshImporter{
+public:
+    // Loads 'path' into 'geometry', picking the format from the file
+    // extension (.obj, .gltf or .glb). Returns false on failure.
+    static bool Load(const std::string& path, Geometry& geometry);
+    // Loads a Wavefront OBJ file
+    static bool LoadOBJ(const std::string& path, Geometry& geometry);
+    // Loads a glTF 2.0 file (.gltf or .glb)
+    static bool LoadGLTF(const std::string& path, Geometry& geometry);
+
+    // Parses an OBJ file that is already in memory
+    static bool ParseOBJ(const char* data, size_t size, Geometry& geometry);
+    // Parses a glTF or glb file that is already in memory.
+    // External buffers are looked up relative to 'directory'.
+    static bool ParseGLTF(const char* data, size_t size, const std::string& directory, Geometry& geometry);
+};
+
+#endif
@@ -0,0 +1,30 @@
+/** @file Meshlet.hpp
+ *  @brief A small cluster of triangles that can be culled on its own.
+ *
+ *  Large meshes are split into meshlets of up to a few hundred triangles.
+ *  The triangles of each meshlet are stored next to each other in the
+ *  index buffer, so every meshlet is a single range we can draw.
+ *
+ *  @author Mike
+ *  @bug No known bugs.
+ */
+#ifndef MESHLET_HPP
+#define MESHLET_HPP
+
+// Plain floats are used (rather than glm types) because meshlets are
+// written as-is into cooked mesh files.
+struct Meshlet{
+    // Bounding sphere in object space
+    float center[3];
+    float radius;
+    // Normal cone: every triangle faces roughly along 'coneAxis'.
+    // coneCutoff is the sine of the cone's half angle, or 1 when the
+    // triangles face too many directions for the cone to be useful.
+    float coneAxis[3];
+    float coneCutoff;
+    // First index and number of indices in the index buffer
+    unsigned int indexOffset;
+    unsigned int indexCount;
+};
+
+#endif
@@ -12,6 +12,7 @@
 #include "Geometry.hpp"
 #include "Renderer.hpp"
 #include "Object.hpp"
+#include "GpuResource.hpp"
 
 #include "glm/vec3.hpp"
 #include "glm/gtc/matrix_transform.hpp"
@@ -23,10 +24,14 @@ public:
     ~Mirror();
 
     virtual void Bind();
+    virtual GLuint GetMaterialTexture() const;
+    // Mirrors are never instanced: the texture Bind uses changes during
+    // the frame, once UpdateBuffer has drawn into our color buffer.
+    virtual bool CanInstance() const;
 
     std::shared_ptr<Shader> m_fboShader;
     // Our framebuffer also needs a texture.
-    unsigned int m_colorBuffer_id;
+    GpuResource m_colorBuffer;
     // the camera ID within the m_cameras vector that this framebuffer belongs to
     int camera_id;
 
@@ -39,10 +44,14 @@ public:
     glm::vec3 forwards;
 // private member variables
 private:
+    // Shown as the owner of our GL objects in GpuResources reports
+    std::string m_name;
+    // The texture sampler of m_fboShader
+    Shader::Uniform m_diffuseMapUniform;
     // Framebuffer id
-    unsigned int m_fbo_id; 
+    GpuResource m_fbo; 
     // Finally create our render buffer object
-    unsigned int m_rbo_id;
+    GpuResource m_rbo;
 };
 
 #endif
\ No newline at end of file
@@ -13,12 +13,15 @@
 
 #include <vector>
 #include <string>
+#include <memory>
 
 // Forward declarations
-#include "VertexBufferLayout.hpp"
+#include "Mesh.hpp"
 #include "Texture.hpp"
 #include "Transform.hpp"
 #include "Geometry.hpp"
+#include "Meshlet.hpp"
+#include "ShaderFeatures.hpp"
 
 #include "glm/vec3.hpp"
 #include "glm/gtc/matrix_transform.hpp"
@@ -36,21 +39,56 @@ public:
     // Load a texture
     void LoadTexture(std::string fileName);
     // Create a textured quad
+    // The quad mesh is shared with every other textured quad.
     void MakeTexturedQuad(std::string fileName);
+    // Use a (possibly shared) mesh for this object
+    void SetMesh(std::shared_ptr<Mesh> mesh);
+    // Retrieve the mesh this object draws
+    std::shared_ptr<Mesh> GetMesh() const;
+    // The shader variant this object needs to be drawn
+    const ShaderFeatures& GetShaderFeatures() const;
+    // Retrieve the texture Bind puts in slot 0 when nothing overrides it
+    const Texture& GetDiffuseTexture() const;
+    // Decides which meshlets are worth drawing from the current view.
+    // Meshlets outside of the frustum, or whose triangles all face away
+    // from the camera, are skipped by the next Render().
+    // Objects without meshlets are always drawn in full.
+    void Cull(const glm::mat4& model, const glm::mat4& view, const glm::mat4& projection);
     // How to draw the object
     virtual void Render();
+    // True if the object can be drawn together with others of the same
+    // mesh, program and texture in one instanced draw. Objects with
+    // meshlets (culled per object) or a detail map cannot.
+    virtual bool CanInstance() const;
+    // Draws the whole mesh 'instances' times, with instance i placed by
+    // ObjectBlock::models[i]
+    void RenderInstanced(GLsizei instances);
 	// Helper method for when we are ready to draw or update our object
 	virtual void Bind();
+    // The texture Bind puts in slot 0. Objects with the same material
+    // texture are drawn one after another.
+    virtual GLuint GetMaterialTexture() const;
 protected: // Classes that inherit from Object are intended to be overriden.
 
-    // For now we have one buffer per object.
-    VertexBufferLayout m_vertexBufferLayout;
+    // The mesh we draw. Meshes from the MeshCache are shared
+    // between objects, so they must not be modified.
+    std::shared_ptr<Mesh> m_mesh;
     // For now we have one diffuse map
     Texture m_textureDiffuse;
     // Terrains are often 'multitextured' and have multiple textures.
-    Texture m_detailMap; // NOTE: Note yet supported
-    // Store the objects Geometry
-	Geometry m_geometry;
+    Texture m_detailMap;
+    // What our shader has to do for us. Derived classes turn off
+    // whatever they do not need, so they get a cheaper variant.
+    ShaderFeatures m_shaderFeatures;
+private:
+    // Index ranges that survived the last call to Cull.
+    // Neighbouring visible meshlets are merged into one range.
+    std::vector<GLsizei> m_drawCounts;
+    std::vector<const void*> m_drawOffsets;
+    // Every range draws with our mesh's base vertex
+    std::vector<GLint> m_drawBaseVertices;
+    // True once Cull has filled in the ranges above
+    bool m_useDrawRanges{false};
 };
 
 #endif
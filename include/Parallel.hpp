@@ -0,0 +1,26 @@
+/** @file Parallel.hpp
+ *  @brief Small helpers for splitting work across CPU threads.
+ *
+ *  Used by the mesh processing code (tangent space generation,
+ *  importers, etc.) which can easily work on millions of elements.
+ *
+ *  @author Mike
+ *  @bug No known bugs.
+ */
+#ifndef PARALLEL_HPP
+#define PARALLEL_HPP
+
+#include <functional>
+
+// Returns how many worker threads we are allowed to use (at least 1).
+unsigned int GetWorkerCount();
+
+// Splits the range [0,count) into contiguous chunks and calls
+// fn(begin,end) on each chunk from a separate thread.
+// 'grain' is the smallest chunk worth handing to a thread, so
+// small ranges simply run on the calling thread.
+// The call returns once every chunk has finished.
+void ParallelFor(unsigned int count, unsigned int grain,
+                 const std::function<void(unsigned int begin, unsigned int end)>& fn);
+
+#endif
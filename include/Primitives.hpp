@@ -0,0 +1,46 @@
+/** @file Primitives.hpp
+ *  @brief Builds simple parametric shapes.
+ *
+ *  Each shape can either be written into a Geometry (Build*), or
+ *  fetched as a shared Mesh from the MeshCache. Every object asking
+ *  for the same shape with the same parameters gets the same buffers.
+ *
+ *  All shapes are centered on the origin, fit inside [-1,1] and
+ *  have their triangles wound counter-clockwise when seen from outside.
+ *
+ *  @author Mike
+ *  @bug No known bugs.
+ */
+#ifndef PRIMITIVES_HPP
+#define PRIMITIVES_HPP
+
+#include <memory>
+
+#include "Geometry.hpp"
+#include "Mesh.hpp"
+
+class Primitives{
+public:
+    // A quad in the xy plane facing +z
+    static void BuildQuad(Geometry& geometry);
+    // A plane in the xz plane facing +y
+    static void BuildPlane(Geometry& geometry);
+    // A plane in the xz plane split into xSegments by zSegments cells
+    static void BuildGrid(Geometry& geometry, unsigned int xSegments, unsigned int zSegments);
+    // A cube with its own vertices on each face (so edges stay sharp)
+    static void BuildCube(Geometry& geometry);
+    // A sphere made of latitude and longitude bands
+    static void BuildSphere(Geometry& geometry, unsigned int latitudeBands, unsigned int longitudeBands);
+    // A capped cylinder along the y axis
+    static void BuildCylinder(Geometry& geometry, unsigned int segments);
+
+    // Shared, cached versions of the shapes above
+    static std::shared_ptr<Mesh> Quad();
+    static std::shared_ptr<Mesh> Plane();
+    static std::shared_ptr<Mesh> Grid(unsigned int xSegments, unsigned int zSegments);
+    static std::shared_ptr<Mesh> Cube();
+    static std::shared_ptr<Mesh> Sphere(unsigned int latitudeBands, unsigned int longitudeBands);
+    static std::shared_ptr<Mesh> Cylinder(unsigned int segments);
+};
+
+#endif
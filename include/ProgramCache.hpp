@@ -0,0 +1,61 @@
+/** @file ProgramCache.hpp
+ *  @brief Keeps linked shader programs on disk between runs.
+ *
+ *  Compiling and linking GLSL is by far the slowest part of creating a
+ *  Shader. After a program is linked, its driver specific binary is
+ *  read back with glGetProgramBinary and written to kDirectory. The
+ *  next run hands that binary straight to glProgramBinary.
+ *
+ *  A binary only works on the driver that made it, so the key of every
+ *  entry covers the program's source as well as the GL vendor, renderer
+ *  and version strings. A driver may still reject a binary (after an
+ *  update, for example); Shader then simply compiles the program again
+ *  and the entry is replaced.
+ *
+ *  Program binaries are core in GL 4.1 (or ARB_get_program_binary).
+ *  Without them the cache does nothing.
+ *
+ *  @author Mike
+ *  @bug No known bugs.
+ */
+#ifndef PROGRAMCACHE_HPP
+#define PROGRAMCACHE_HPP
+
+#include <glad/glad.h>
+
+#include <string>
+#include <cstdint>
+
+class ProgramCache{
+public:
+    // Where cached programs are written
+    static const char* const kDirectory;
+
+    // Looks up the functions that glad (3.3) does not load for us.
+    // Call once after gladLoadGLLoader with the same loader.
+    static void LoadFunctions(GLADloadproc load);
+    // True if program binaries can be saved and loaded
+    static bool IsAvailable();
+
+    // Key for a program made on this driver from sources whose
+    // HashProgramSources is 'sourceKey'
+    static uint64_t GetKey(uint64_t sourceKey);
+    // Must be called on a new program before it is linked, so that the
+    // driver keeps a binary we can read back
+    static void PrepareProgram(GLuint program);
+    // Loads the entry for 'key' into 'program'. Returns false if there
+    // is none or the driver rejects it. 'compileMilliseconds' receives
+    // how long building the program took when it was saved.
+    static bool Load(uint64_t key, GLuint program, double& compileMilliseconds);
+    // Saves the linked 'program' under 'key'
+    static bool Save(uint64_t key, GLuint program, double compileMilliseconds);
+
+    // Counts a program that had to be compiled
+    static void CountMiss(double compileMilliseconds);
+    // Counts a program that was loaded
+    static void CountHit(double loadMilliseconds, double compileMilliseconds);
+    // Prints hits, misses and the time saved by the cache
+    static void PrintStats();
+};
+
+#endif
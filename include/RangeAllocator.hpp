@@ -0,0 +1,56 @@
+/** @file RangeAllocator.hpp
+ *  @brief Hands out ranges of a fixed size space (e.g. a GPU buffer).
+ *
+ *  The allocator only does the bookkeeping, it never touches memory.
+ *  Free space is kept as a list of blocks sorted by offset, and
+ *  neighbouring free blocks are merged when a range is given back.
+ *  Allocation picks the smallest free block that fits (best fit).
+ *
+ *  @author Mike
+ *  @bug No known bugs.
+ */
+#ifndef RANGEALLOCATOR_HPP
+#define RANGEALLOCATOR_HPP
+
+#include <map>
+
+class RangeAllocator{
+public:
+    // Returned by Allocate when no free block is large enough
+    static const unsigned int kInvalidOffset = 0xffffffff;
+
+    // Constructor (everything in [0,capacity) starts out free)
+    RangeAllocator(unsigned int capacity = 0);
+    // Reserves 'size' units. Returns the offset of the range,
+    // or kInvalidOffset if there is no free block large enough.
+    unsigned int Allocate(unsigned int size);
+    // Gives back a range returned by Allocate
+    void Free(unsigned int offset, unsigned int size);
+    // Makes the space larger. The new space at the end is free.
+    void Grow(unsigned int capacity);
+    // Marks [0,used) as allocated and everything after it as free.
+    // Used after the owner has packed all ranges to the front.
+    void Reset(unsigned int used);
+
+    // Total number of units
+    unsigned int GetCapacity() const;
+    // Units currently handed out
+    unsigned int GetUsed() const;
+    // Units currently free
+    unsigned int GetFree() const;
+    // Number of separate free blocks
+    unsigned int GetFreeBlockCount() const;
+    // Size of the largest free block
+    unsigned int GetLargestFreeBlock() const;
+    // 0 when all free space is in one block, approaching 1 as the
+    // free space is split into many small blocks
+    float GetFragmentation() const;
+
+private:
+    // Free blocks: offset -> size
+    std::map<unsigned int, unsigned int> m_freeBlocks;
+    unsigned int m_capacity;
+    unsigned int m_used;
+};
+
+#endif
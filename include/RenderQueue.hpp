@@ -0,0 +1,182 @@
+/** @file RenderQueue.hpp
+ *  @brief The list of everything to draw this frame.
+ *
+ *  The scene graph is walked once per frame to collect a DrawPacket per
+ *  drawable node. Every view (the main and rear view framebuffers, and
+ *  each mirror) then draws from that flat list, so adding a view no
+ *  longer adds a walk of the scene graph.
+ *
+ *  Packets next to each other after sorting that share a mesh, program
+ *  and texture are drawn as one instanced draw of up to
+ *  ObjectBlock::kMaxInstances. Each view streams the model matrices of
+ *  its draws, in draw order, into one ObjectBlock per draw.
+ *
+ *  Each view draws its packets ordered by a 64 bit key, radix sorted,
+ *  so that packets sharing a program, then a texture, then a mesh are
+ *  drawn together, and front to back within those:
+ *
+ *      bits 63-62  pass
+ *      bit  61     translucent (all of our objects are opaque)
+ *      bits 60-49  program
+ *      bits 48-33  material texture
+ *      bits 32-21  mesh
+ *      bits 20-0   view depth
+ *
+ *  Programs, textures and meshes are numbered in the order Build first
+ *  meets them.
+ *
+ *  Packets are in scene graph order, so the packets below a node follow
+ *  it. Build gives every packet world space bounds, and bounds holding
+ *  everything below it, which lets a view skip (or accept) a whole
+ *  subtree with one test against its frustum.
+ *
+ *  @author Mike
+ *  @bug No known bugs.
+ */
+#ifndef RENDERQUEUE_HPP
+#define RENDERQUEUE_HPP
+
+#include <glad/glad.h>
+#include <vector>
+#include <cstdint>
+
+#include "TransformHierarchy.hpp"
+#include "StreamBuffer.hpp"
+#include "Bounds.hpp"
+
+#include "glm/glm.hpp"
+
+class Object;
+class Mesh;
+class Shader;
+class SceneNode;
+class Camera;
+class Frustum;
+
+// One thing to draw
+struct DrawPacket{
+    // Mesh and material (Object::Bind binds the textures)
+    Object* object;
+    // Program to draw it with
+    Shader* shader;
+    // Where the world matrix lives in TransformHierarchy::Instance()
+    TransformHierarchy::Handle transform;
+    // Mesh the object draws (nullptr for none)
+    const Mesh* mesh;
+    // Object::CanInstance
+    bool instanceable;
+    // Everything in the sort key except the depth
+    uint64_t stateKey;
+    // State the packet selects, to count switches
+    GLuint materialTexture;
+    GLuint vertexArray;
+    // Packet of the node above (RenderQueue::kNoParent for none)
+    uint32_t parent;
+    // One past the last packet below this one
+    uint32_t subtreeEnd;
+    // World space bounds of the mesh (empty if there is no mesh)
+    Bounds bounds;
+    // World space bounds of this packet and every packet below it
+    Bounds subtreeBounds;
+};
+
+class RenderQueue{
+public:
+    // How often consecutive draws needed a different program, texture
+    // or vertex array
+    struct Switches{
+        unsigned int programs;
+        unsigned int textures;
+        unsigned int vertexArrays;
+    };
+    // What frustum culling did for one view
+    struct Culling{
+        // Bounds tested against the frustum
+        unsigned int tested;
+        // Packets skipped
+        unsigned int culled;
+        // Packets drawn
+        unsigned int visible;
+    };
+    struct Stats{
+        unsigned int views;
+        // Packets drawn
+        unsigned int draws;
+        // Draw calls they took, and how many of those were instanced
+        unsigned int drawCalls;
+        unsigned int instancedCalls;
+        // Summed over every view
+        Culling culling;
+        // In the order the packets were drawn
+        Switches sorted;
+        // Had they been drawn in scene graph order instead
+        Switches sceneOrder;
+    };
+
+    // No parent packet
+    static constexpr uint32_t kNoParent = 0xffffffff;
+
+    // Adds one packet below 'parent' (called by SceneNode::Enqueue).
+    // Returns the new packet, to be the parent of the ones below it.
+    uint32_t Add(Object* object, Shader* shader, TransformHierarchy::Handle transform, uint32_t parent);
+    // Collects the packets of the scene below 'root'. World transforms
+    // must be up to date. Views stream their ObjectBlocks into 'uniforms'.
+    // Also starts a new frame of counters.
+    void Build(SceneNode* root, StreamBuffer& uniforms);
+    // Culls the packets against the camera's frustum, then sorts and
+    // draws the rest, instanced where they allow it.
+    // Camera::UpdateMatrices must have been called, and the view's
+    // ViewBlock and LightBlock already be bound.
+    void Submit(const Camera& camera);
+
+    // Retrieve the packets of this frame
+    const std::vector<DrawPacket>& GetPackets() const;
+    // Retrieve the counters of the last complete frame
+    const Stats& GetLastFrame() const;
+    // Retrieve the culling of each view of the last complete frame
+    const std::vector<Culling>& GetLastFrameViews() const;
+    // Prints the counters of the last frame and the average per frame
+    void PrintStats() const;
+
+private:
+    // Numbers the programs, textures and meshes and fills in stateKey
+    void AssignStateKeys();
+    // Fills in the world space bounds and subtree of every packet
+    void ComputeBounds();
+    // Fills m_visible with the packets inside the frustum
+    void Cull(const Frustum& frustum, Culling& culling);
+    // Splits m_order into draws and streams their ObjectBlocks.
+    // Returns false if the stream buffer is full.
+    bool BuildDraws();
+
+    // One draw call: m_order[first, first + count)
+    struct Draw{
+        uint32_t first;
+        uint32_t count;
+        // Where its ObjectBlock starts in the stream buffer
+        GLintptr offset;
+    };
+
+    std::vector<DrawPacket> m_packets;
+    // Where views stream their ObjectBlocks (set by Build)
+    StreamBuffer* m_uniforms{nullptr};
+
+    // Scratch space for culling and sorting, kept to avoid allocating
+    // every view
+    std::vector<uint32_t> m_visible;
+    std::vector<float> m_depths;
+    std::vector<uint64_t> m_keys;
+    std::vector<uint64_t> m_keysScratch;
+    std::vector<uint32_t> m_order;
+    std::vector<uint32_t> m_orderScratch;
+    std::vector<Draw> m_draws;
+
+    Stats m_frame{};
+    Stats m_lastFrame{};
+    Stats m_total{};
+    std::vector<Culling> m_frameViews;
+    std::vector<Culling> m_lastFrameViews;
+    unsigned int m_frames{0};
+};
+
+#endif
@@ -26,6 +26,8 @@
 #include "SceneNode.hpp"
 #include "Camera.hpp"
 #include "Framebuffer.hpp"
+#include "StreamBuffer.hpp"
+#include "RenderQueue.hpp"
 
 
 class Renderer{
@@ -41,7 +43,7 @@ public:
     void Render();
     // Sets the root of our renderer to some node to
     // draw an entire scene graph
-    void setRoot(std::shared_ptr<SceneNode> startingNode);
+    void setRoot(SceneNodePool::Handle startingNode);
     // Returns the camera at an index
     Camera*& GetCamera(unsigned int index){
         if(index > m_cameras.size()-1){
@@ -59,7 +61,7 @@ public:
 // TODO: maybe write getter/setter methods
 protected:
     // Root scene node
-    std::shared_ptr<SceneNode> m_root;
+    SceneNodePool::Handle m_root;
     // One or more cameras camera per Renderer
     std::vector<Camera*> m_cameras;
     // Store the projection matrix for our camera.
@@ -67,8 +69,16 @@ protected:
     // A renderer can have any number of framebuffers
     std::vector<Framebuffer*> m_framebuffers;
     Framebuffer * active;
+    // Per frame data (such as uniforms) is written here
+    StreamBuffer m_streamBuffer;
+    // Everything to draw this frame, shared by all views
+    RenderQueue m_renderQueue;
 
 private:
+    // Writes the view and lights of 'camera' into the stream buffer
+    // and binds them for one pass
+    void UpdatePass(Camera* camera);
+
     // Screen dimension constants
     int m_screenHeight;
     int m_screenWidth;
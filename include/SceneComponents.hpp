@@ -0,0 +1,149 @@
+/** @file SceneComponents.hpp
+ *  @brief This Singleton class keeps what scene nodes are, by kind.
+ *
+ *  Each kind of component (mirrors, renderables, lights) is kept in
+ *  its own ComponentArray: a dense array of the components, with the
+ *  handle of the node each one belongs to next to it, and a sparse
+ *  array from SceneNodePool slot to dense index. Adding, removing and
+ *  finding a node's component are O(1), and removing moves the last
+ *  component into the hole, so the dense array never has gaps.
+ *
+ *  A render stage walks exactly the array it needs, front to back,
+ *  instead of walking the scene graph to find the nodes it cares
+ *  about. The order of the arrays is not the order of the scene graph.
+ *
+ *  Nodes add and remove their own components (see SceneNode); a node
+ *  that is destroyed loses all of them.
+ *
+ *  @author Mike
+ *  @bug No known bugs.
+ */
+#ifndef SCENECOMPONENTS_HPP
+#define SCENECOMPONENTS_HPP
+
+#include <vector>
+#include <cstdint>
+
+#include "SceneNodePool.hpp"
+#include "TransformHierarchy.hpp"
+#include "AABBTree.hpp"
+#include "UniformBlocks.hpp"
+
+class SceneNode;
+class Object;
+class Mirror;
+
+// Dense storage for one kind of component, indexed by node
+template <typename T>
+class ComponentArray{
+public:
+    // Gives 'node' a component (replacing the one it had). The pointer
+    // is valid until the next Add or Remove.
+    T* Add(SceneNodePool::Handle node, const T& component){
+        T* existing = Get(node);
+        if(existing != nullptr){
+            *existing = component;
+            return existing;
+        }
+        const uint32_t slot = SceneNodePool::GetSlotIndex(node);
+        if(slot >= m_sparse.size()){
+            m_sparse.resize(slot + 1, kNone);
+        }
+        m_sparse[slot] = m_dense.size();
+        m_dense.push_back(component);
+        m_owners.push_back(node);
+        return &m_dense.back();
+    }
+    // Takes a node's component away (if it has one)
+    void Remove(SceneNodePool::Handle node){
+        if(!Has(node)){
+            return;
+        }
+        const uint32_t slot = SceneNodePool::GetSlotIndex(node);
+        const uint32_t index = m_sparse[slot];
+        const uint32_t last = m_dense.size() - 1;
+        if(index != last){
+            m_dense[index] = m_dense[last];
+            m_owners[index] = m_owners[last];
+            m_sparse[SceneNodePool::GetSlotIndex(m_owners[index])] = index;
+        }
+        m_dense.pop_back();
+        m_owners.pop_back();
+        m_sparse[slot] = kNone;
+    }
+    // True if 'node' (and not an older node in its slot) has one
+    bool Has(SceneNodePool::Handle node) const{
+        const uint32_t slot = SceneNodePool::GetSlotIndex(node);
+        return slot < m_sparse.size() && m_sparse[slot] != kNone && m_owners[m_sparse[slot]] == node;
+    }
+    // Retrieve a node's component, or nullptr
+    T* Get(SceneNodePool::Handle node){
+        return Has(node) ? &m_dense[m_sparse[SceneNodePool::GetSlotIndex(node)]] : nullptr;
+    }
+
+    // Walk the components in dense order
+    unsigned int GetCount() const { return m_dense.size(); }
+    T& operator[](unsigned int index) { return m_dense[index]; }
+    const T& operator[](unsigned int index) const { return m_dense[index]; }
+    // The node the component at 'index' belongs to
+    SceneNodePool::Handle GetOwner(unsigned int index) const { return m_owners[index]; }
+    typename std::vector<T>::iterator begin() { return m_dense.begin(); }
+    typename std::vector<T>::iterator end() { return m_dense.end(); }
+
+private:
+    static constexpr uint32_t kNone = 0xffffffff;
+    std::vector<T> m_dense;
+    std::vector<SceneNodePool::Handle> m_owners;
+    std::vector<uint32_t> m_sparse;
+};
+
+// A node with an object to draw, and its world bounds in the AABBTree
+struct RenderableComponent{
+    SceneNode* node;
+    Object* object;
+    TransformHierarchy::Handle transform;
+    // Our world bounds in AABBTree::Instance(), whose user data is the node
+    AABBTree::Proxy proxy{AABBTree::kNullProxy};
+    // World transform version proxy was last moved for
+    uint32_t boundsVersion{0};
+    // Set once we have reported the node moving after being batched
+    bool reportedBatchedMove{false};
+};
+
+// A node whose object is a Mirror, drawn into before the main views
+struct MirrorComponent{
+    Mirror* mirror;
+};
+
+// A point light at the node's world position. 'light.lightPos' is
+// relative to the node.
+struct LightComponent{
+    PointLightData light;
+    TransformHierarchy::Handle transform;
+};
+
+class SceneComponents{
+public:
+    // Singleton pattern for having one set of registries for the scene
+    static SceneComponents& Instance();
+
+    // Takes every component away from 'node'
+    void RemoveAll(SceneNodePool::Handle node);
+    // Moves the AABBTree proxy of every renderable whose world transform
+    // changed (TransformHierarchy must be up to date)
+    void UpdateBounds();
+    // Fills 'lights' from the light components, and returns how many
+    // there were (at most LightBlock::kPointLightCount are written)
+    unsigned int FillLights(LightBlock& lights) const;
+
+    ComponentArray<RenderableComponent> renderables;
+    ComponentArray<MirrorComponent> mirrors;
+    ComponentArray<LightComponent> lights;
+
+private:
+    // Constructor is private because we should
+    // not be able to construct any other registries
+    SceneComponents() {}
+};
+
+#endif
@@ -7,6 +7,9 @@
  *  The traversal of the tree takes place starting from
  *  a single SceneNode (typically called root).
  *
+ *  Nodes are created and destroyed through SceneNodePool, and refer
+ *  to each other by SceneNodePool::Handle.
+ *
  *  @author Mike
  *  @bug No known bugs.
  */
@@ -16,59 +19,101 @@
 
 #include "Object.hpp"
 #include "Transform.hpp"
+#include "TransformHierarchy.hpp"
 #include "Camera.hpp"
 #include "Shader.hpp"
+#include "RenderQueue.hpp"
+#include "AABBTree.hpp"
+#include "SceneNodePool.hpp"
+#include "UniformBlocks.hpp"
 
 #include "glm/vec3.hpp"
 #include "glm/gtc/matrix_transform.hpp"
 
-class Mirror;
+class StaticBatch;
 
 class SceneNode{
 public:
-    // A SceneNode is created by taking
-    // a pointer to an object.
-    // For now, we also specify the shader paths as well (TODO: Implement a shader manager here
-    //                                                          instead for a cleaner code..
-    SceneNode(std::shared_ptr<Object> ob, std::string vertShader, std::string fragShader);
-    // Our destructor takes care of destroying
-    // all of the children within the node.
-    // Now we do not have to manage deleting
-    // each individual object.
-    ~SceneNode();
-    // Adds a child node to our current node.
-    void AddChild(SceneNode* n);
-    // Draws the current SceneNode
-    void Draw();
-    // Updates the current SceneNode
-    void Update(glm::mat4 projectionMatrix, Camera* camera);
+    // Adds a child node to our current node. A node that already had
+    // a parent is moved from it. The child is destroyed with us.
+    void AddChild(SceneNodePool::Handle child);
+    // Retrieve our handle in SceneNodePool::Instance()
+    SceneNodePool::Handle GetHandle() const;
+    // Retrieve our parent (kInvalidHandle for a root)
+    SceneNodePool::Handle GetParent() const;
+    // Adds a DrawPacket for this node, and every node below it, to 'queue'.
+    // 'parent' is the packet of the node above (its bounds hold ours).
+    void Enqueue(RenderQueue& queue, uint32_t parent = RenderQueue::kNoParent);
     // Returns the local transformation transform
     // Remember that local is local to an object, where it's center is the origin.
+    // The node assumes it is about to be modified. The transform lives
+    // in the TransformHierarchy, so do not hold on to the reference.
     Transform& GetLocalTransform();
     // Returns a SceneNode's world transform
-    Transform& GetWorldTransform();
+    const Transform& GetWorldTransform() const;
+    // Changes every time our world transform is recomputed
+    uint32_t GetWorldVersion() const;
+    // Static nodes promise never to move (nor anything above them), so
+    // StaticBatch can merge them with others of the same material
+    void SetStatic(bool isStatic);
+    bool IsStatic() const;
+    // True once StaticBatch has merged us into a batch. Our object is
+    // then drawn by the batch, and we only keep our children.
+    bool IsBatched() const;
+    // True if we moved (relative to our batch) since StaticBatch merged
+    // us, so the batch now draws us where we were
+    bool HasMovedSinceBatched() const;
+    // Retrieve our proxy in AABBTree::Instance(), whose user data is
+    // this node (kNullProxy until the renderer has seen us with a mesh)
+    AABBTree::Proxy GetProxy() const;
+    // Mirrors are drawn into before the main views. Only a node whose
+    // object is a Mirror can be one; returns false otherwise.
+    bool SetMirror(bool isMirror);
+    bool IsMirror() const;
+    // Makes us a point light ('light.lightPos' is relative to us), or
+    // stops us being one
+    void SetLight(const PointLightData& light);
+    void RemoveLight();
     // For now we have one shader per Node.
     std::shared_ptr<Shader> m_shader; 
 
-    bool is_mirror;
-    
-    void FindMirrors(std::vector<Mirror *> & mirrors);
+    // StaticBatch reads our object and transform, and marks us batched
+    friend class StaticBatch;
+    // Only the pool makes and destroys nodes
+    friend class SceneNodePool;
     // NOTE: Protected members are accessible by anything
     // that we inherit from, as well as ?
 protected:
     // Parent
-    SceneNode* m_parent;
+    SceneNodePool::Handle m_parent{SceneNodePool::kInvalidHandle};
 private:
-    // Children holds all a pointer to all of the descendents
-    // of a particular SceneNode. A pointer is used because
-    // we do not want to hold or make actual copies.
-    std::vector<SceneNode*> m_children;
+    // A SceneNode is created by taking
+    // a pointer to an object.
+    // The shader paths, with the object's ShaderFeatures, select the
+    // program ShaderManager gives us (shared with every node that asks
+    // for the same variant).
+    SceneNode(std::shared_ptr<Object> ob, std::string vertShader, std::string fragShader);
+    // The pool destroys our children before us
+    ~SceneNode();
+    // Registers our components, once the pool has given us our handle
+    void OnCreated();
+    // Our own handle (set by the pool)
+    SceneNodePool::Handle m_handle{SceneNodePool::kInvalidHandle};
+    // Our local and world transforms, in TransformHierarchy::Instance()
+    TransformHierarchy::Handle m_transform;
+
+    // Children holds a handle to all of the descendents
+    // of a particular SceneNode, in the SceneNodePool.
+    std::vector<SceneNodePool::Handle> m_children;
     // The object stored in the scene graph
     std::shared_ptr<Object> m_object;
-    // Each SceneNode nodes locals transform.
-    Transform m_localTransform;
-    // We additionally can store the world transform
-    Transform m_worldTransform;
+    // See SetStatic and IsBatched
+    bool m_static{false};
+    bool m_batched{false};
+    // The node that draws us once we are batched, and where we were
+    // relative to it then
+    SceneNodePool::Handle m_batch{SceneNodePool::kInvalidHandle};
+    glm::mat4 m_batchedTransform{1.0f};
 };
 
 #endif
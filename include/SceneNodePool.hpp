@@ -0,0 +1,83 @@
+/** @file SceneNodePool.hpp
+ *  @brief This Singleton class owns every SceneNode.
+ *
+ *  Nodes live in chunks of kChunkSize nodes that never move, so nodes
+ *  created together sit next to each other in memory. Everything else
+ *  refers to a node by a 32 bit handle:
+ *
+ *      bits 31-20  generation of the slot
+ *      bits 19-0   slot
+ *
+ *  Destroying a node bumps its slot's generation, so old handles to it
+ *  stop working (Get returns nullptr) instead of reaching whatever node
+ *  reuses the slot. Create and Destroy are O(1), with a free list of
+ *  slots.
+ *
+ *  A node owns the nodes below it: destroying it destroys them too.
+ *
+ *  @author Mike
+ *  @bug No known bugs.
+ */
+#ifndef SCENENODEPOOL_HPP
+#define SCENENODEPOOL_HPP
+
+#include <vector>
+#include <memory>
+#include <string>
+#include <cstdint>
+
+class SceneNode;
+class Object;
+
+class SceneNodePool{
+public:
+    typedef uint32_t Handle;
+    static constexpr Handle kInvalidHandle = 0xffffffff;
+
+    // Singleton pattern for having one single pool
+    static SceneNodePool& Instance();
+
+    // Creates a node for 'object', drawn with the program built from the
+    // shader files (see SceneNode)
+    Handle Create(std::shared_ptr<Object> object, const std::string& vertShader, const std::string& fragShader);
+    // Destroys a node, and every node below it, and takes it out of its
+    // parent's children
+    void Destroy(Handle node);
+    // Retrieve a node, or nullptr if the handle is stale or invalid.
+    // The pointer stays valid until the node is destroyed.
+    SceneNode* Get(Handle node) const;
+    // Retrieve how many nodes are alive
+    unsigned int GetCount() const;
+    // Retrieve how many nodes fit without allocating another chunk
+    unsigned int GetCapacity() const;
+    // Retrieve the slot part of a handle (below GetCapacity), for
+    // arrays indexed by node
+    static uint32_t GetSlotIndex(Handle node) { return node & kSlotMask; }
+
+private:
+    static const uint32_t kChunkSize = 256;
+    static const uint32_t kSlotBits = 20;
+    static const uint32_t kSlotMask = (1u << kSlotBits) - 1;
+    static const uint32_t kGenerationMask = (1u << (32 - kSlotBits)) - 1;
+    // Raw storage for kChunkSize nodes (defined where SceneNode is known)
+    struct Chunk;
+
+    // Constructor is private because we should
+    // not be able to construct any other pools
+    SceneNodePool();
+    // The storage of slot 'slot'
+    SceneNode* GetSlot(uint32_t slot) const;
+    // Destroys a node and everything below it
+    void DestroySubtree(Handle node);
+
+    // Chunks are never freed, so slots never move
+    std::vector<Chunk*> m_chunks;
+    // Per slot
+    std::vector<uint16_t> m_generations;
+    std::vector<uint8_t> m_alive;
+    // Slots that can be reused
+    std::vector<uint32_t> m_freeSlots;
+    unsigned int m_count{0};
+};
+
+#endif
@@ -3,6 +3,12 @@
  *  
  *  Additionally has functions for setting various uniforms.
  *
+ *  Once a program is linked, all of its active uniforms are read with
+ *  glGetActiveUniform. GetUniform then returns a Uniform handle holding
+ *  the location and type, so per frame code can set values without any
+ *  string lookups or driver queries. The name based setters still work,
+ *  but search the uniform table on every call.
+ *
  *  @author Mike
  *  @bug No known bugs.
  */
@@ -10,6 +16,8 @@
 #define SHADER_HPP
 
 #include <string>
+#include <vector>
+#include <cstdint>
 
 #if defined(LINUX) || defined(MINGW)
     #include <SDL2/SDL.h>
@@ -21,6 +29,14 @@
 
 class Shader{
 public:
+    // A uniform that was looked up once (see GetUniform).
+    // Setting an invalid Uniform does nothing, like location -1 in OpenGL.
+    struct Uniform{
+        GLint location{-1};
+        GLenum type{0};
+        bool IsValid() const { return location >= 0; }
+    };
+
     // Shader constructor
     Shader();
     // Shader Destructor
@@ -30,18 +46,40 @@ public:
     // Remove shader from our pipeline
     void Unbind() const;
     // Load a shader
-    std::string LoadShader(const std::string& fname);
-    // Create a Shader from a loaded vertex and fragment shader
-    void CreateShader(const std::string& vertexShaderSource, const std::string& fragmentShaderSource);
+    static std::string LoadShader(const std::string& fname);
+    // Create a Shader from a loaded vertex and fragment shader.
+    // 'sourceKey' is HashProgramSources of the two sources.
+    void CreateShader(const std::string& vertexShaderSource, const std::string& fragmentShaderSource, uint64_t sourceKey);
     // return the shader id
     GLuint GetID() const;
+    // Finds the active uniform 'name', which must be of GL type 'type'
+    // (e.g. GL_FLOAT_VEC3; GL_INT also matches bools and samplers).
+    // Returns an invalid Uniform if it is missing (the compiler removes
+    // unused uniforms) or has another type.
+    Uniform GetUniform(const char* name, GLenum type) const;
     // Set our uniforms for our shader.
     void SetUniformMatrix4fv(const GLchar* name, const GLfloat* value);
 	void SetUniform3f(const GLchar* name, float v0, float v1, float v2);
     void SetUniform1i(const GLchar* name, int value);
     void SetUniform1f(const GLchar* name, float value);
+    // The same, using a Uniform from GetUniform. The shader must be bound.
+    void SetUniformMatrix4fv(Uniform uniform, const GLfloat* value);
+    void SetUniform3f(Uniform uniform, float v0, float v1, float v2);
+    void SetUniform1i(Uniform uniform, int value);
+    void SetUniform1f(Uniform uniform, float value);
 
 private:
+    // One active uniform of the linked program
+    struct UniformInfo{
+        std::string name;
+        GLint location;
+        GLenum type;
+    };
+    // Reads every active uniform of the linked program into m_uniforms
+    void ReadUniforms();
+    // Connects the uniform blocks the program uses (see UniformBlocks.hpp)
+    // to their binding points
+    void BindUniformBlocks();
     // Compiles loaded shaders
     unsigned int CompileShader(unsigned int type, const std::string& source);
     // Makes sure shaders 'linked' successfully
@@ -50,9 +88,11 @@ private:
     void PrintProgramLog( GLuint program );
     void PrintShaderLog( GLuint shader );
     // Logs an error message 
-    void Log(const char* system, const char* message);
+    static void Log(const char* system, const char* message);
     // The unique shaderID
-    GLuint m_shaderID;
+    GLuint m_shaderID{0};
+    // Active uniforms, sorted by name
+    std::vector<UniformInfo> m_uniforms;
 };
 
 #endif
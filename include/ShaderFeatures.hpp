@@ -0,0 +1,49 @@
+/** @file ShaderFeatures.hpp
+ *  @brief The optional parts of our lighting shader an object asks for.
+ *
+ *  frag.glsl is written once, with every feature behind a #define.
+ *  Each Object describes which of them it actually needs, and the
+ *  ShaderManager builds (and shares) the variant with exactly those
+ *  defines. Loops over the lights are unrolled by the compiler because
+ *  their bound is a constant, and disabled features cost nothing at
+ *  all instead of a branch per fragment.
+ *
+ *  @author Mike
+ *  @bug No known bugs.
+ */
+#ifndef SHADERFEATURES_HPP
+#define SHADERFEATURES_HPP
+
+#include <string>
+#include <vector>
+
+#include "UniformBlocks.hpp"
+
+struct ShaderFeatures{
+    // How many of the LightBlock's lights are applied (LIGHT_COUNT).
+    // Clamped to LightBlock::kPointLightCount, the size of the array.
+    int lightCount{LightBlock::kPointLightCount};
+    // Modulate the diffuse map with u_DetailMap (DETAIL_MAP)
+    bool detailMap{false};
+    // Add specular highlights (SPECULAR)
+    bool specular{true};
+
+    // The defines that select this variant, for ShaderManager::Get
+    std::vector<std::string> GetDefines() const{
+        std::vector<std::string> defines;
+        int count = lightCount < 0 ? 0 : lightCount;
+        if(count > LightBlock::kPointLightCount){
+            count = LightBlock::kPointLightCount;
+        }
+        defines.push_back("LIGHT_COUNT=" + std::to_string(count));
+        if(detailMap){
+            defines.push_back("DETAIL_MAP");
+        }
+        if(specular){
+            defines.push_back("SPECULAR");
+        }
+        return defines;
+    }
+};
+
+#endif
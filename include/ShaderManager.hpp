@@ -2,8 +2,14 @@
  *  @brief This Singleton class manages all of the shaders that have been created
  *
  *  The shader manager handles all of the shaders that have been loaded.
- *  
+ *  Asking for the same vertex and fragment shader (with the same
+ *  defines) again returns the same Shader, so every program is only
+ *  compiled and linked once, no matter how many nodes use it.
  *
+ *  Programs are found by a hash of their final source, after the
+ *  defines have been added. Like the MeshCache, the manager only holds
+ *  weak references: a program is deleted as soon as the last user of
+ *  it goes away.
  *
  *  @author Mike
  *  @bug No known bugs.
@@ -13,17 +19,41 @@
 
 #include <unordered_map>
 #include <memory>
+#include <string>
+#include <vector>
+#include <cstdint>
 
 #include "Shader.hpp"
 
 class ShaderManager{
 public:
-      
+    // Singleton pattern for having one single ShaderManager
+    static ShaderManager& Instance();
+    // Returns the program made from these two files, with a
+    // '#define NAME' (or '#define NAME VALUE') line added to both for
+    // every entry of 'defines'. It is compiled only if no one is using
+    // an identical program already.
+    std::shared_ptr<Shader> Get(const std::string& vertexPath, const std::string& fragmentPath,
+                                const std::vector<std::string>& defines = {});
+    // Retrieve how many programs are currently alive
+    unsigned int GetProgramCount();
+    // Prints how many programs were asked for and how many were built
+    void PrintStats();
+
+    // Adds the defines to 'source', right after its #version line
+    static std::string Preprocess(const std::string& source, const std::vector<std::string>& defines);
+
 private:
     // ShaderManager Constructor
     ShaderManager() {}
     // ShaderManager Destructor
     ~ShaderManager() {}
+
+    // Programs that have been made so far, by source hash
+    std::unordered_map<uint64_t, std::weak_ptr<Shader>> m_programs;
+    // Number of calls to Get, and how many of them compiled a program
+    unsigned int m_requests{0};
+    unsigned int m_compiles{0};
 };
 
 #endif
@@ -0,0 +1,54 @@
+/** @file StaticBatch.hpp
+ *  @brief Merges scene nodes that never move into a few large meshes.
+ *
+ *  Nodes marked static (SceneNode::SetStatic) that share a program and
+ *  a diffuse texture are merged at load time: their vertices are moved
+ *  by their transforms once, and appended to one mesh per material.
+ *  Only positions are moved. Normals, tangents and bi-tangents are
+ *  copied as they are, because vert.glsl does not move normals by the
+ *  model matrix either: a batched node is shaded exactly as it was
+ *  unbatched (including a rotated node, whose normals stay in its
+ *  object space).
+ *  The batch is then drawn in place of the nodes, with one draw and no
+ *  per node matrices. Each merged node keeps its own index range in the
+ *  batch as a meshlet, so ranges outside the view are still skipped.
+ *
+ *  Only plain textured objects whose mesh kept its CPU copy are merged:
+ *  mirrors (whose texture changes), cooked meshes, and objects with
+ *  meshlets or a detail map are left as they are.
+ *
+ *  @author Mike
+ *  @bug No known bugs.
+ */
+#ifndef STATICBATCH_HPP
+#define STATICBATCH_HPP
+
+#include <string>
+#include <vector>
+
+class SceneNode;
+
+class StaticBatch{
+public:
+    // What Build merged
+    struct Stats{
+        unsigned int nodes;
+        unsigned int batches;
+        unsigned int vertices;
+        unsigned int indices;
+    };
+
+    // Merges the static nodes below 'root' into batches, which are added
+    // as children of 'root' (in its space, so they follow it as the
+    // nodes did). The batches' nodes are created with 'vertShader' and
+    // 'fragShader', and draw with the program of the nodes they replace.
+    static Stats Build(SceneNode* root, const std::string& vertShader, const std::string& fragShader);
+    // Prints what Build merged
+    static void PrintStats(const Stats& stats);
+
+private:
+    // Adds the nodes at and below 'node' that can be merged to 'nodes'
+    static void Collect(SceneNode* node, std::vector<SceneNode*>& nodes);
+};
+
+#endif
@@ -0,0 +1,122 @@
+/** @file StreamBuffer.hpp
+ *  @brief Ring buffer for data that changes every frame.
+ *
+ *  The buffer is split into kRegionCount regions and every frame writes
+ *  into the next one, so the CPU fills region N while the GPU may still
+ *  be reading regions N-1 and N-2. A fence is placed at the end of each
+ *  frame; before a region is reused the fence tells us whether the GPU
+ *  is done with it. If it is not, the CPU has to wait, which is counted
+ *  as a stall (there should be none).
+ *
+ *  How the memory is written depends on what the driver offers:
+ *  - Persistent:     GL 4.4 / ARB_buffer_storage. The buffer is mapped
+ *                    once (persistent and coherent) and written directly.
+ *  - Unsynchronized: GL 3.3. Each allocation maps its own range with
+ *                    GL_MAP_UNSYNCHRONIZED_BIT; the fences make it safe.
+ *  - Orphan:         GL 3.3. The whole buffer is orphaned with
+ *                    glBufferData(NULL) whenever the ring wraps, and the
+ *                    driver keeps the old storage alive for the GPU.
+ *
+ *  Usage, once per frame:
+ *      BeginFrame();
+ *      void* p = Map(size, alignment, offset); ...write...; Unmap();
+ *      (draw using GetBuffer() at 'offset')
+ *      EndFrame();
+ *
+ *  @author Mike
+ *  @bug No known bugs.
+ */
+#ifndef STREAMBUFFER_HPP
+#define STREAMBUFFER_HPP
+
+#include <glad/glad.h>
+
+#include "GpuResource.hpp"
+
+class StreamBuffer{
+public:
+    // Number of frames that can be in flight at once
+    static const unsigned int kRegionCount = 3;
+
+    enum class Mode { Persistent, Unsynchronized, Orphan };
+
+    // Counters for the lifetime of the buffer
+    struct Stats{
+        unsigned int frames;
+        // Frames that had to wait on the GPU before writing
+        unsigned int stalls;
+        double stallMilliseconds;
+        double longestStallMilliseconds;
+        // Allocations that did not fit into their region
+        unsigned int overflows;
+        // Most bytes used by a single frame
+        unsigned int peakBytes;
+    };
+
+    // Looks up the functions that glad (3.3) does not load for us.
+    // Call once after gladLoadGLLoader with the same loader.
+    static void LoadFunctions(GLADloadproc load);
+    // True if glBufferStorage is available (GL 4.4 or ARB_buffer_storage)
+    static bool HasBufferStorage();
+
+    // Constructor. Nothing is created until Create is called.
+    StreamBuffer();
+    // Destructor
+    ~StreamBuffer();
+    // A stream buffer owns GPU memory, so it cannot be copied
+    StreamBuffer(const StreamBuffer&) = delete;
+    StreamBuffer& operator=(const StreamBuffer&) = delete;
+
+    // Creates the buffer with 'regionSize' bytes per frame.
+    // Uses the best mode the driver supports, unless 'allowPersistent'
+    // is false, in which case 'fallback' is used.
+    void Create(unsigned int regionSize, bool allowPersistent = true, Mode fallback = Mode::Unsynchronized);
+    // Moves on to the next region, waiting for the GPU only if it is
+    // still using it
+    void BeginFrame();
+    // Marks the end of the commands that read this frame's region
+    void EndFrame();
+    // Reserves 'size' bytes at an offset that is a multiple of 'alignment'
+    // and returns where to write them. 'offset' receives the position in
+    // the buffer to use when drawing. Returns nullptr if the region is full.
+    void* Map(unsigned int size, unsigned int alignment, GLintptr& offset);
+    // Map for data read as a uniform block, aligned as the driver requires
+    void* MapUniforms(unsigned int size, GLintptr& offset);
+    // The alignment MapUniforms uses. Uniform blocks packed into one
+    // Map must each start at a multiple of it.
+    unsigned int GetUniformAlignment() const;
+    // Finishes writing the range returned by Map
+    void Unmap();
+
+    // Retrieve the GL buffer
+    GLuint GetBuffer() const;
+    // Retrieve the mode in use
+    Mode GetMode() const;
+    // Retrieve the counters
+    const Stats& GetStats() const;
+    // Prints the counters
+    void PrintStats(const char* name) const;
+
+private:
+    // Deletes the buffer and fences
+    void Release();
+
+    Mode m_mode{Mode::Unsynchronized};
+    GpuResource m_buffer;
+    unsigned int m_regionSize{0};
+    // Region written by the current frame
+    unsigned int m_region{0};
+    // Bytes used in the current region
+    unsigned int m_used{0};
+    // GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT
+    unsigned int m_uniformAlignment{256};
+    // Fence placed at the end of the last frame that used each region
+    GLsync m_fences[kRegionCount]{};
+    // Start of the persistent mapping (Persistent mode only)
+    unsigned char* m_persistent{nullptr};
+    // True between Map and Unmap in the non persistent modes
+    bool m_mapped{false};
+    Stats m_stats{};
+};
+
+#endif
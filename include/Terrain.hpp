@@ -17,6 +17,7 @@
 
 #include <vector>
 #include <string>
+#include <cstdint>
 
 class Terrain : public Object {
 public:
@@ -29,10 +30,24 @@ public:
     // Loads a heightmap based on a PPM image
     // This then sets the heights of the terrain.
     void LoadHeightMap(Image image);
-    // Load textures
-    void LoadTextures(std::string colormap, std::string detailmap);
+    // Load textures. The detail map is only sampled if 'sampleDetailMap'
+    // is set; it multiplies the color map by twice its value, so it
+    // should be centered on grey (0.5).
+    void LoadTextures(std::string colormap, std::string detailmap, bool sampleDetailMap = false);
+
+    // Reads a PPM heightmap into 'heightData' (xSegs*zSegs values)
+    static void LoadHeights(const std::string& fileName, unsigned int xSegs, unsigned int zSegs, int* heightData);
+    // Fills 'geometry' with the terrain grid for the given heights.
+    // Does not touch OpenGL.
+    static void BuildGeometry(Geometry& geometry, const int* heightData, unsigned int xSegs, unsigned int zSegs);
 
 private:
+    // Builds the key that identifies what a cooked terrain was made from
+    uint64_t GetSourceKey(const std::string& fileName) const;
+    // Tries to load a previously cooked terrain mesh.
+    // Returns false if there is none or it is out of date.
+    bool LoadCooked(const std::string& cookedPath, uint64_t sourceKey);
+
     // data
     unsigned int m_xSegments;
     unsigned int m_zSegments;
@@ -1,7 +1,9 @@
 /** @file Texture.hpp
  *  @brief Loads an image and creates an OpenGL texture on the GPU..
  *  
- *  More...
+ *  Textures loaded from the same file share one GL texture (for as long
+ *  as any of them is alive), so objects using the same image can be
+ *  drawn together.
  *
  *  @author Mike
  *  @bug No known bugs.
@@ -10,9 +12,11 @@
 #define TEXTURE_HPP
 
 #include "Image.hpp"
+#include "GpuResource.hpp"
 
 #include <glad/glad.h>
 #include <string>
+#include <memory>
 
 class Texture{
 public:
@@ -28,13 +32,17 @@ public:
     void Bind(unsigned int slot=0) const;
     // Be done with our texture
     void Unbind();
+    // Retrieve the GL texture (0 if nothing was loaded)
+    GLuint GetId() const;
+    // Retrieve the file the texture was loaded from (empty if none)
+    const std::string& GetFilePath() const;
 private:
-    // Store a unique ID for the texture
-    GLuint m_textureID;
+    // The texture on the GPU (shared with every Texture of the same file)
+    std::shared_ptr<GpuResource> m_texture;
 	// Filepath to the image loaded
     std::string m_filepath;
     // Store whatever image data inside of our texture class.
-    Image* m_image;
+    Image* m_image{nullptr};
 };
 
 
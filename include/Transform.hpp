@@ -10,12 +10,15 @@
 #define TRANSFORM_HPP
 
 #include <glad/glad.h>
+#include <cstdint>
 #include "glm/vec3.hpp"
 #include "glm/gtc/matrix_transform.hpp"
 
 // The purpose of this class is to store
 // transformations of 3D entities (cameras, objects, etc.)
-class Transform{
+// The matrix is 16 byte aligned so it can be loaded straight into SSE
+// registers (see TransformHierarchy).
+class alignas(16) Transform{
 public:
 
     // Constructor for a new transform
@@ -31,13 +34,19 @@ public:
     // Perform rotation about an axis
     void Scale(float x, float y, float z);
     // Returns the transformation matrix
+    // (writing through the pointer counts as a change)
     GLfloat* GetTransformMatrix();
     // Apply Transform
     // Takes in a transform and sets internal
     // matrix.
     void ApplyTransform(Transform t);
     // Returns the transformation matrix
-    glm::mat4 GetInternalMatrix() const;
+    const glm::mat4& GetInternalMatrix() const;
+    // Changes every time the matrix is modified, so others can tell
+    // whether anything they computed from it is out of date
+    uint32_t GetVersion() const{
+        return m_version;
+    }
 
     // Transform multiplication t1 *= t2 (t1 is multiplied and a new result stored)
 	Transform& operator*=(const Transform& t);
@@ -57,6 +66,10 @@ public:
 private:
     // Stores the actual transformation matrix
     glm::mat4 m_modelTransformMatrix;
+    // See GetVersion
+    uint32_t m_version{0};
+    // Stores 'matrix', counting a change only if it is different
+    void SetMatrix(const glm::mat4& matrix);
 };
 
 
@@ -0,0 +1,98 @@
+/** @file TransformHierarchy.hpp
+ *  @brief Stores the transforms of a whole scene graph in flat arrays.
+ *
+ *  Every node has a slot in a set of parallel arrays: its parent's
+ *  slot, its local transform and its world transform. Slots are kept
+ *  in topological order (a parent always comes before its children),
+ *  so all world transforms are brought up to date by one linear pass,
+ *  world[i] = world[parent[i]] * local[i], with SSE matrix multiplies.
+ *  No pointers are followed and the matrices are read in memory order.
+ *
+ *  Only nodes that moved (and everything below them) are recomputed.
+ *  The pass starts at the first slot that changed, so a frame in which
+ *  nothing moved costs nothing.
+ *
+ *  Nodes are referred to by handles that stay valid while slots are
+ *  reordered. SceneNode keeps one handle into the shared Instance().
+ *
+ *  @author Mike
+ *  @bug No known bugs.
+ */
+#ifndef TRANSFORMHIERARCHY_HPP
+#define TRANSFORMHIERARCHY_HPP
+
+#include <vector>
+#include <cstdint>
+
+#include "Transform.hpp"
+
+class TransformHierarchy{
+public:
+    typedef uint32_t Handle;
+    static constexpr Handle kInvalidHandle = 0xffffffff;
+
+    // The hierarchy every SceneNode lives in
+    static TransformHierarchy& Instance();
+
+    // An empty hierarchy (the benchmarks make their own)
+    TransformHierarchy() {}
+
+    // Adds a node with an identity transform and no parent
+    Handle Create();
+    // Removes a node. Its children become roots.
+    void Destroy(Handle node);
+    // Makes 'node' a child of 'parent' (or a root if parent is
+    // kInvalidHandle). Refused if it would create a cycle.
+    void SetParent(Handle node, Handle parent);
+    // The node's transform relative to its parent. The node is assumed
+    // to be modified, and the reference is only valid until the next
+    // Create or Update.
+    Transform& GetLocal(Handle node);
+    // The node's transform in world space, as of the last Update.
+    // Its version changes every time it is recomputed.
+    const Transform& GetWorld(Handle node) const;
+
+    // Recomputes every world transform that is out of date
+    void Update();
+
+    // Number of nodes
+    unsigned int GetCount() const;
+    // Number of world transforms the last Update recomputed
+    unsigned int GetLastUpdateCount() const;
+
+private:
+    // Puts the slots back in topological order (parents first),
+    // dropping the slots of destroyed nodes
+    void Sort();
+    // Remembers that the pass must start at 'slot' or earlier
+    void MarkDirty(uint32_t slot);
+
+    static constexpr uint32_t kNoParent = 0xffffffff;
+
+    // Per slot, in topological order once sorted
+    std::vector<uint32_t> m_parents;
+    std::vector<Transform> m_locals;
+    std::vector<Transform> m_worlds;
+    // Version of m_locals[i] that m_worlds[i] was built from
+    std::vector<uint32_t> m_localVersions;
+    // Slot must be recomputed whatever the versions say
+    std::vector<uint8_t> m_dirty;
+    // Scratch for Update: slot was recomputed this pass
+    std::vector<uint8_t> m_changed;
+    // Slot belongs to a node that still exists
+    std::vector<uint8_t> m_alive;
+    std::vector<Handle> m_handles;
+
+    // Per handle
+    std::vector<uint32_t> m_slots;
+    std::vector<Handle> m_freeHandles;
+
+    // First slot the next Update has to look at
+    uint32_t m_firstDirty{0};
+    // Some child comes before its parent, or a slot is free
+    bool m_needsSort{false};
+    unsigned int m_count{0};
+    unsigned int m_lastUpdateCount{0};
+};
+
+#endif
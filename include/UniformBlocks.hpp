@@ -0,0 +1,70 @@
+/** @file UniformBlocks.hpp
+ *  @brief C++ copies of the uniform blocks shared by our shaders.
+ *
+ *  Data that is the same for every object drawn from one camera (the
+ *  view and the lights) is written once per pass into a uniform buffer,
+ *  instead of being set on every program. Each draw only writes the
+ *  model matrices of the objects it draws into an ObjectBlock.
+ *
+ *  The blocks use the std140 layout, so these structs must match the
+ *  GLSL declarations in shaders/vert.glsl and shaders/frag.glsl byte for
+ *  byte: a vec3 takes 16 bytes unless a float follows it, and arrays of
+ *  structs are padded to multiples of 16 bytes.
+ *
+ *  @author Mike
+ *  @bug No known bugs.
+ */
+#ifndef UNIFORMBLOCKS_HPP
+#define UNIFORMBLOCKS_HPP
+
+#include "glm/glm.hpp"
+
+// The binding point every program uses for each block
+enum UniformBlockBinding{
+    kViewBlockBinding = 0,
+    kLightBlockBinding = 1,
+    kObjectBlockBinding = 2
+};
+
+// layout(std140) uniform ViewBlock
+struct ViewBlock{
+    glm::mat4 view;
+    glm::mat4 projection;
+    glm::mat4 viewProjection;
+    // xyz: camera position in world space
+    glm::vec4 eyePosition;
+};
+
+// One element of PointLight pointLights[] in LightBlock
+struct PointLightData{
+    glm::vec3 lightColor;
+    float ambientIntensity;
+    glm::vec3 lightPos;
+    float specularStrength;
+    float constant;
+    float linear;
+    float quadratic;
+    float padding;
+};
+
+// layout(std140) uniform LightBlock
+struct LightBlock{
+    static const int kPointLightCount = 2;
+    PointLightData pointLights[kPointLightCount];
+};
+
+// layout(std140) uniform ObjectBlock
+// Instance i of a draw reads models[i] (gl_InstanceID). Only as many
+// matrices as instances are written, but the whole block must be in
+// the buffer past the bound offset.
+struct ObjectBlock{
+    static const int kMaxInstances = 64;
+    glm::mat4 models[kMaxInstances];
+};
+
+static_assert(sizeof(ViewBlock) == 208, "ViewBlock does not match std140");
+static_assert(sizeof(PointLightData) == 48, "PointLightData does not match std140");
+static_assert(sizeof(LightBlock) == 96, "LightBlock does not match std140");
+static_assert(sizeof(ObjectBlock) == 64*ObjectBlock::kMaxInstances, "ObjectBlock does not match std140");
+
+#endif
@@ -12,6 +12,17 @@
 // The glad library helps setup OpenGL extensions.
 #include <glad/glad.h>
 
+#include "GpuResource.hpp"
+
+// The interleaved vertex formats we know how to draw
+enum class VertexFormat{
+    // x,y,z
+    Position,
+    // x,y,z, s,t
+    Texture,
+    // x,y,z, nx,ny,nz, s,t, tx,ty,tz, bx,by,bz (see Geometry::Gen)
+    Normal
+};
 
 class VertexBufferLayout{ 
 public:
@@ -34,11 +45,11 @@ public:
     // idata: A pointer to an array of data for indices
     // NOTE: Works only for floats--could support other formats.
     //       
-    void CreatePositionBufferLayout(unsigned int vcount,unsigned int icount, float* vdata, unsigned int* idata );
+    void CreatePositionBufferLayout(unsigned int vcount,unsigned int icount, const float* vdata, const unsigned int* idata );
 
     // Creates a vertex and index buffer object
     // Format is: x,y,z, s,t
-    void CreateTextureBufferLayout(unsigned int vcount,unsigned int icount, float* vdata, unsigned int* idata );
+    void CreateTextureBufferLayout(unsigned int vcount,unsigned int icount, const float* vdata, const unsigned int* idata );
 
     // A normal map layout needs the following attributes
     //
@@ -47,17 +58,31 @@ public:
     // texcoords: s,t
     // tangent: t_x,t_y,t_z
     // bitangent b_x,b_y,b_z
-    void CreateNormalBufferLayout(unsigned int vcount,unsigned int icount, float* vdata, unsigned int* idata );
+    void CreateNormalBufferLayout(unsigned int vcount,unsigned int icount, const float* vdata, const unsigned int* idata );
+    // Retrieve how many indices were placed in the index buffer
+    unsigned int GetIndexCount() const;
+
+    // Number of floats per vertex in 'format'
+    static unsigned int GetStride(VertexFormat format);
+    // Sets up the attributes of 'format' on the bound vertex array,
+    // reading from the buffer bound to GL_ARRAY_BUFFER.
+    // Shared with GeometryArena, which keeps many meshes in one buffer.
+    static void SetAttributes(VertexFormat format);
 
 private:
+    // Shared by the Create*BufferLayout functions
+    void Create(VertexFormat format, unsigned int vcount,unsigned int icount, const float* vdata, const unsigned int* idata );
+
     // Vertex Array Object
-    GLuint m_VAOId;
+    GpuResource m_vertexArray;
     // Vertex Buffer
-    GLuint m_vertexPositionBuffer;
+    GpuResource m_vertexPositionBuffer;
     // Index Buffer Object
-    GLuint m_indexBufferObject;
+    GpuResource m_indexBufferObject;
     // Stride of data (how do I get to the next vertex)
     unsigned int m_stride{0};
+    // Number of indices in the index buffer
+    unsigned int m_indexCount{0};
 };
 
 
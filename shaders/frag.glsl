@@ -1,30 +1,39 @@
 // ==================================================================
 #version 330 core
 
+// Variants are selected by the ShaderManager with these defines
+// (see ShaderFeatures.hpp):
+//   LIGHT_COUNT  how many of the pointLights to apply
+//   DETAIL_MAP   modulate the diffuse map with u_DetailMap
+//   SPECULAR     add specular highlights
+#ifndef LIGHT_COUNT
+#define LIGHT_COUNT 2
+#endif
+#if LIGHT_COUNT > 2
+#error LIGHT_COUNT is larger than the pointLights in LightBlock
+#endif
+
 // The final output color of each 'fragment' from our fragment shader.
 out vec4 FragColor;
 
 // Our light source data structure
+// The order matters: every vec3 is followed by a float, so the std140
+// layout has no holes (see PointLightData in UniformBlocks.hpp)
 struct PointLight{
     vec3 lightColor;
-    vec3 lightPos;
     float ambientIntensity;
-
+    vec3 lightPos;
     float specularStrength;
 
     float constant;
     float linear;
     float quadratic;
-
-    vec3 ambient;
-    vec3 diffuse;
-    vec3 specular;
 };
 
-uniform PointLight pointLights[2];
-
-// Used for our specular highlights
-uniform mat4 view;
+// The lights are the same for every object in a pass
+layout(std140) uniform LightBlock{
+    PointLight pointLights[2];
+};
 
 
 // Import our normal data
@@ -36,8 +45,10 @@ in vec3 FragPos;
 
 // If we have texture coordinates, they are stored in this sampler.
 uniform sampler2D u_DiffuseMap; 
+#ifdef DETAIL_MAP
 // Load in an additional detail map
-//uniform sampler2D u_DetailMap; 
+uniform sampler2D u_DetailMap; 
+#endif
 
 void main()
 {
@@ -46,13 +57,17 @@ void main()
     
     // Store our final texture color
     vec3 diffuseColor   = texture(u_DiffuseMap, v_texCoord).rgb;
-//    vec3 detailColor    = texture(u_DetailMap,  v_texCoord).rgb;
+#ifdef DETAIL_MAP
+    // A detail map centered on grey (0.5) darkens and lightens
+    vec3 detailColor    = texture(u_DetailMap,  v_texCoord).rgb;
+    diffuseColor *= detailColor * 2.0;
+#endif
 
 	// Store our final lighting computation
 	vec3 Lighting = vec3(0.0,0.0,0.0);
 
 	// TODO: (Optional) You should refactor this into a separate function :)
-	for(int i=0; i < 1; i++){
+	for(int i=0; i < LIGHT_COUNT; i++){
 		// (1) Compute ambient light
 		vec3 ambient = pointLights[i].ambientIntensity * pointLights[i].lightColor;
 
@@ -66,12 +81,16 @@ void main()
 		vec3 diffuseLight = diffImpact * pointLights[i].lightColor;
 
 		// (3) Compute Specular lighting
+#ifdef SPECULAR
 		vec3 viewPos = vec3(0.0,0.0,0.0);
 		vec3 viewDir = normalize(viewPos - FragPos);
 		vec3 reflectDir = reflect(-lightDir, norm);
 
 		float spec = pow(max(dot(viewDir, reflectDir), 0.0), 32);
 		vec3 specular = pointLights[i].specularStrength * spec * pointLights[i].lightColor;
+#else
+		vec3 specular = vec3(0.0,0.0,0.0);
+#endif
 
 		// Calculate Attenuation here
 		// distance and lighting... 
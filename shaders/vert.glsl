@@ -11,9 +11,20 @@ layout(location=4)in vec3 bitangents; // Our third attribute - texture coordinat
 
 // If we are applying our camera, then we need to add some uniforms.
 // Note that the syntax nicely matches glm's mat4!
-uniform mat4 model; // Object space
-uniform mat4 view; // Object space
-uniform mat4 projection; // Object space
+// The camera is the same for every object in a pass, so it lives in a
+// uniform block that is filled once per pass (see UniformBlocks.hpp).
+layout(std140) uniform ViewBlock{
+    mat4 view;
+    mat4 projection;
+    mat4 viewProjection;
+    vec4 eyePosition;
+};
+// The model matrix of every instance of this draw (objects that share
+// a mesh, program and texture are drawn together). The size must match
+// ObjectBlock::kMaxInstances.
+layout(std140) uniform ObjectBlock{
+    mat4 models[64]; // Object space
+};
 
 // Export our normal data, and read it into our frag shader
 out vec3 myNormal;
@@ -24,8 +35,9 @@ out vec2 v_texCoord;
 
 void main()
 {
+    mat4 model = models[gl_InstanceID];
 
-    gl_Position = projection * view * model * vec4(position, 1.0f);
+    gl_Position = viewProjection * model * vec4(position, 1.0f);
 
     myNormal = normals;
     // Transform normal into world space
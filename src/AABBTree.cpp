@@ -0,0 +1,563 @@
+#include "AABBTree.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+
+namespace{
+    // How far leaf boxes reach past the bounds they were given
+    const float kMargin = 0.1f;
+    // Buckets along an axis when looking for the cheapest SAH split
+    const int kSAHBins = 12;
+
+    float SurfaceArea(const glm::vec3& min, const glm::vec3& max){
+        glm::vec3 size = max - min;
+        return 2.0f * (size.x*size.y + size.y*size.z + size.z*size.x);
+    }
+
+    bool Overlaps(const glm::vec3& minA, const glm::vec3& maxA, const glm::vec3& minB, const glm::vec3& maxB){
+        return minA.x <= maxB.x && minA.y <= maxB.y && minA.z <= maxB.z
+            && minB.x <= maxA.x && minB.y <= maxA.y && minB.z <= maxA.z;
+    }
+
+    bool Contains(const glm::vec3& outerMin, const glm::vec3& outerMax, const glm::vec3& min, const glm::vec3& max){
+        return outerMin.x <= min.x && outerMin.y <= min.y && outerMin.z <= min.z
+            && max.x <= outerMax.x && max.y <= outerMax.y && max.z <= outerMax.z;
+    }
+
+    // Nodes still to visit during a query. The first few live on the
+    // stack; a balanced tree of a million proxies is about 30 deep.
+    class NodeStack{
+    public:
+        void Push(int32_t node){
+            if(m_size < kFixed){
+                m_fixed[m_size] = node;
+            }else{
+                m_spill.push_back(node);
+            }
+            ++m_size;
+        }
+        int32_t Pop(){
+            --m_size;
+            if(m_size < kFixed){
+                return m_fixed[m_size];
+            }
+            int32_t node = m_spill.back();
+            m_spill.pop_back();
+            return node;
+        }
+        bool IsEmpty() const{
+            return m_size == 0;
+        }
+    private:
+        static const size_t kFixed = 64;
+        int32_t m_fixed[kFixed];
+        std::vector<int32_t> m_spill;
+        size_t m_size{0};
+    };
+}
+
+AABBTree& AABBTree::Instance(){
+    static AABBTree* instance = new AABBTree();
+    return *instance;
+}
+
+AABBTree::AABBTree(){
+}
+
+AABBTree::Proxy AABBTree::Insert(const Bounds& bounds, void* user){
+    int32_t leaf = AllocateNode();
+    Node& node = m_nodes[leaf];
+    node.min = bounds.min - glm::vec3(kMargin);
+    node.max = bounds.max + glm::vec3(kMargin);
+    node.user = user;
+    node.height = 0;
+    InsertLeaf(leaf);
+    ++m_count;
+    return leaf;
+}
+
+void AABBTree::Remove(Proxy proxy){
+    if(proxy < 0 || proxy >= (Proxy)m_nodes.size() || !m_nodes[proxy].IsLeaf() || m_nodes[proxy].height != 0){
+        std::cout << "(AABBTree.cpp) ERROR, removing a proxy that does not exist\n";
+        return;
+    }
+    RemoveLeaf(proxy);
+    FreeNode(proxy);
+    --m_count;
+}
+
+bool AABBTree::Move(Proxy proxy, const Bounds& bounds){
+    Node& node = m_nodes[proxy];
+    if(Contains(node.min, node.max, bounds.min, bounds.max)){
+        return false;
+    }
+    RemoveLeaf(proxy);
+    m_nodes[proxy].min = bounds.min - glm::vec3(kMargin);
+    m_nodes[proxy].max = bounds.max + glm::vec3(kMargin);
+    InsertLeaf(proxy);
+    return true;
+}
+
+// The leaves keep their slots, so proxies stay valid; only the inner
+// nodes are thrown away and built again
+void AABBTree::Rebuild(){
+    std::vector<int32_t> leaves;
+    leaves.reserve(m_count);
+    for(size_t i=0; i < m_nodes.size(); ++i){
+        if(m_nodes[i].height < 0){
+            continue;
+        }
+        if(m_nodes[i].IsLeaf()){
+            leaves.push_back(i);
+        }else{
+            FreeNode(i);
+        }
+    }
+    m_root = leaves.empty() ? kNullProxy : BuildSAH(leaves, 0, leaves.size());
+    if(m_root != kNullProxy){
+        m_nodes[m_root].parent = kNullProxy;
+    }
+}
+
+void* AABBTree::GetUser(Proxy proxy) const{
+    return m_nodes[proxy].user;
+}
+
+Bounds AABBTree::GetFatBounds(Proxy proxy) const{
+    Bounds bounds;
+    bounds.min = m_nodes[proxy].min;
+    bounds.max = m_nodes[proxy].max;
+    bounds.UpdateSphere();
+    return bounds;
+}
+
+void AABBTree::QueryBox(const Bounds& box, const QueryCallback& callback) const{
+    if(m_root == kNullProxy){
+        return;
+    }
+    NodeStack stack;
+    stack.Push(m_root);
+    while(!stack.IsEmpty()){
+        const Node& node = m_nodes[stack.Pop()];
+        if(!Overlaps(node.min, node.max, box.min, box.max)){
+            continue;
+        }
+        if(node.IsLeaf()){
+            if(!callback(&node - m_nodes.data())){
+                return;
+            }
+        }else{
+            stack.Push(node.child1);
+            stack.Push(node.child2);
+        }
+    }
+}
+
+// The box is hit if its closest point to the center is within 'radius'
+void AABBTree::QuerySphere(const glm::vec3& center, float radius, const QueryCallback& callback) const{
+    if(m_root == kNullProxy){
+        return;
+    }
+    const float radiusSquared = radius * radius;
+    NodeStack stack;
+    stack.Push(m_root);
+    while(!stack.IsEmpty()){
+        const Node& node = m_nodes[stack.Pop()];
+        glm::vec3 offset = glm::clamp(center, node.min, node.max) - center;
+        if(glm::dot(offset, offset) > radiusSquared){
+            continue;
+        }
+        if(node.IsLeaf()){
+            if(!callback(&node - m_nodes.data())){
+                return;
+            }
+        }else{
+            stack.Push(node.child1);
+            stack.Push(node.child2);
+        }
+    }
+}
+
+// Nodes on the stack with their sign bit flipped (~node) are known to be
+// inside, and only need their leaves collected
+void AABBTree::QueryFrustum(const Frustum& frustum, const QueryCallback& callback) const{
+    if(m_root == kNullProxy){
+        return;
+    }
+    NodeStack stack;
+    stack.Push(m_root);
+    while(!stack.IsEmpty()){
+        int32_t entry = stack.Pop();
+        bool inside = entry < 0;
+        const Node& node = m_nodes[inside ? ~entry : entry];
+        if(!inside){
+            Frustum::Containment containment = frustum.TestBox((node.min + node.max) * 0.5f, (node.max - node.min) * 0.5f);
+            if(containment == Frustum::Containment::Outside){
+                continue;
+            }
+            inside = containment == Frustum::Containment::Inside;
+        }
+        if(node.IsLeaf()){
+            if(!callback(&node - m_nodes.data())){
+                return;
+            }
+        }else if(inside){
+            stack.Push(~node.child1);
+            stack.Push(~node.child2);
+        }else{
+            stack.Push(node.child1);
+            stack.Push(node.child2);
+        }
+    }
+}
+
+// Slab test: the ray is inside the box between the latest distance it
+// enters a pair of planes and the earliest it leaves one
+void AABBTree::QueryRay(const glm::vec3& origin, const glm::vec3& direction, float maxDistance,
+                        const RayCallback& callback) const{
+    if(m_root == kNullProxy){
+        return;
+    }
+    const glm::vec3 inverse = 1.0f / direction;
+    NodeStack stack;
+    stack.Push(m_root);
+    while(!stack.IsEmpty()){
+        const Node& node = m_nodes[stack.Pop()];
+        glm::vec3 t0 = (node.min - origin) * inverse;
+        glm::vec3 t1 = (node.max - origin) * inverse;
+        glm::vec3 entries = glm::min(t0, t1);
+        glm::vec3 exits = glm::max(t0, t1);
+        float enter = std::max(std::max(entries.x, entries.y), std::max(entries.z, 0.0f));
+        float exit = std::min(std::min(exits.x, exits.y), std::min(exits.z, maxDistance));
+        if(enter > exit){
+            continue;
+        }
+        if(node.IsLeaf()){
+            maxDistance = callback(&node - m_nodes.data(), maxDistance);
+            if(maxDistance < 0.0f){
+                return;
+            }
+        }else{
+            stack.Push(node.child1);
+            stack.Push(node.child2);
+        }
+    }
+}
+
+unsigned int AABBTree::GetCount() const{
+    return m_count;
+}
+
+int AABBTree::GetHeight() const{
+    return m_root == kNullProxy ? 0 : m_nodes[m_root].height;
+}
+
+float AABBTree::GetAreaRatio() const{
+    if(m_root == kNullProxy){
+        return 0.0f;
+    }
+    float total = 0.0f;
+    for(const Node& node : m_nodes){
+        if(node.height > 0){
+            total += SurfaceArea(node.min, node.max);
+        }
+    }
+    float rootArea = SurfaceArea(m_nodes[m_root].min, m_nodes[m_root].max);
+    return rootArea > 0.0f ? total / rootArea : 0.0f;
+}
+
+bool AABBTree::Validate() const{
+    if(m_root == kNullProxy){
+        return m_count == 0;
+    }
+    if(m_nodes[m_root].parent != kNullProxy){
+        std::cout << "(AABBTree.cpp) ERROR, the root has a parent\n";
+        return false;
+    }
+    unsigned int leaves = 0;
+    for(const Node& node : m_nodes){
+        leaves += node.height == 0;
+    }
+    if(leaves != m_count){
+        std::cout << "(AABBTree.cpp) ERROR, " << leaves << " leaves for " << m_count << " proxies\n";
+        return false;
+    }
+    return ValidateNode(m_root, kNullProxy);
+}
+
+int32_t AABBTree::AllocateNode(){
+    int32_t index;
+    if(m_freeList != kNullProxy){
+        index = m_freeList;
+        m_freeList = m_nodes[index].parent;
+    }else{
+        index = m_nodes.size();
+        m_nodes.emplace_back();
+    }
+    Node& node = m_nodes[index];
+    node.user = nullptr;
+    node.parent = kNullProxy;
+    node.child1 = kNullProxy;
+    node.child2 = kNullProxy;
+    node.height = 0;
+    return index;
+}
+
+void AABBTree::FreeNode(int32_t node){
+    m_nodes[node].parent = m_freeList;
+    m_nodes[node].child1 = kNullProxy;
+    m_nodes[node].height = -1;
+    m_freeList = node;
+}
+
+// Walks down from the root towards whichever child is cheaper to put the
+// leaf under, stopping where a new parent at this level is cheaper than
+// either. Every node on the way grows to hold the leaf (the
+// 'inheritance' cost) whichever way we go.
+void AABBTree::InsertLeaf(int32_t leaf){
+    if(m_root == kNullProxy){
+        m_root = leaf;
+        m_nodes[leaf].parent = kNullProxy;
+        return;
+    }
+    const glm::vec3 leafMin = m_nodes[leaf].min;
+    const glm::vec3 leafMax = m_nodes[leaf].max;
+    int32_t index = m_root;
+    while(!m_nodes[index].IsLeaf()){
+        const Node& node = m_nodes[index];
+        float area = SurfaceArea(node.min, node.max);
+        float combinedArea = SurfaceArea(glm::min(node.min, leafMin), glm::max(node.max, leafMax));
+        // Making a new parent for this node and the leaf
+        float cost = 2.0f * combinedArea;
+        float inheritance = 2.0f * (combinedArea - area);
+
+        float childCosts[2];
+        const int32_t children[2] = {node.child1, node.child2};
+        for(int c=0; c < 2; ++c){
+            const Node& child = m_nodes[children[c]];
+            float grown = SurfaceArea(glm::min(child.min, leafMin), glm::max(child.max, leafMax));
+            childCosts[c] = (child.IsLeaf() ? grown : grown - SurfaceArea(child.min, child.max)) + inheritance;
+        }
+        if(cost < childCosts[0] && cost < childCosts[1]){
+            break;
+        }
+        index = childCosts[0] < childCosts[1] ? node.child1 : node.child2;
+    }
+
+    const int32_t sibling = index;
+    const int32_t oldParent = m_nodes[sibling].parent;
+    const int32_t newParent = AllocateNode();
+    m_nodes[newParent].parent = oldParent;
+    m_nodes[newParent].child1 = sibling;
+    m_nodes[newParent].child2 = leaf;
+    m_nodes[sibling].parent = newParent;
+    m_nodes[leaf].parent = newParent;
+    if(oldParent == kNullProxy){
+        m_root = newParent;
+    }else if(m_nodes[oldParent].child1 == sibling){
+        m_nodes[oldParent].child1 = newParent;
+    }else{
+        m_nodes[oldParent].child2 = newParent;
+    }
+    FixUpwards(newParent);
+}
+
+void AABBTree::RemoveLeaf(int32_t leaf){
+    if(leaf == m_root){
+        m_root = kNullProxy;
+        return;
+    }
+    const int32_t parent = m_nodes[leaf].parent;
+    const int32_t grandParent = m_nodes[parent].parent;
+    const int32_t sibling = m_nodes[parent].child1 == leaf ? m_nodes[parent].child2 : m_nodes[parent].child1;
+    FreeNode(parent);
+    if(grandParent == kNullProxy){
+        m_root = sibling;
+        m_nodes[sibling].parent = kNullProxy;
+        return;
+    }
+    if(m_nodes[grandParent].child1 == parent){
+        m_nodes[grandParent].child1 = sibling;
+    }else{
+        m_nodes[grandParent].child2 = sibling;
+    }
+    m_nodes[sibling].parent = grandParent;
+    FixUpwards(grandParent);
+}
+
+void AABBTree::FixUpwards(int32_t node){
+    while(node != kNullProxy){
+        node = Balance(node);
+        Refit(node);
+        node = m_nodes[node].parent;
+    }
+}
+
+// If one child (C) of A is more than one higher than the other (B), C
+// takes A's place, A takes the lower of C's children, and C keeps the
+// higher one:
+//
+//     before:  A = (B, C)   C = (F, G)
+//     after:   C = (A, F)   A = (B, G)   when F is higher than G
+//
+// and the mirror image of that when B is the higher child.
+int32_t AABBTree::Balance(int32_t a){
+    if(m_nodes[a].IsLeaf() || m_nodes[a].height < 2){
+        return a;
+    }
+    int32_t b = m_nodes[a].child1;
+    int32_t c = m_nodes[a].child2;
+    int balance = m_nodes[c].height - m_nodes[b].height;
+    if(balance >= -1 && balance <= 1){
+        return a;
+    }
+    const bool rightHigh = balance > 1;
+    const int32_t high = rightHigh ? c : b;
+    const int32_t f = m_nodes[high].child1;
+    const int32_t g = m_nodes[high].child2;
+
+    // 'high' goes up into a's place
+    m_nodes[high].child1 = a;
+    m_nodes[high].parent = m_nodes[a].parent;
+    m_nodes[a].parent = high;
+    const int32_t above = m_nodes[high].parent;
+    if(above == kNullProxy){
+        m_root = high;
+    }else if(m_nodes[above].child1 == a){
+        m_nodes[above].child1 = high;
+    }else{
+        m_nodes[above].child2 = high;
+    }
+
+    // a keeps its other child and takes the lower of f and g
+    const bool keepF = m_nodes[f].height > m_nodes[g].height;
+    const int32_t kept = keepF ? f : g;
+    const int32_t given = keepF ? g : f;
+    m_nodes[high].child2 = kept;
+    if(rightHigh){
+        m_nodes[a].child2 = given;
+    }else{
+        m_nodes[a].child1 = given;
+    }
+    m_nodes[given].parent = a;
+    Refit(a);
+    Refit(high);
+    return high;
+}
+
+// Splits along the axis the centers spread out most on, at whichever
+// bucket boundary gives the lowest area * count on both sides. Falls
+// back to the median when every center lands in one bucket.
+int32_t AABBTree::BuildSAH(std::vector<int32_t>& leaves, size_t begin, size_t end){
+    if(end - begin == 1){
+        return leaves[begin];
+    }
+    glm::vec3 centerMin(1e30f);
+    glm::vec3 centerMax(-1e30f);
+    for(size_t i=begin; i < end; ++i){
+        const Node& node = m_nodes[leaves[i]];
+        glm::vec3 center = (node.min + node.max) * 0.5f;
+        centerMin = glm::min(centerMin, center);
+        centerMax = glm::max(centerMax, center);
+    }
+    const glm::vec3 spread = centerMax - centerMin;
+    const int axis = spread.x >= spread.y && spread.x >= spread.z ? 0 : (spread.y >= spread.z ? 1 : 2);
+
+    size_t middle = begin;
+    if(spread[axis] > 0.0f){
+        const float scale = kSAHBins / spread[axis];
+        auto binOf = [&](int32_t leaf){
+            const Node& node = m_nodes[leaf];
+            int bin = (int)(((node.min[axis] + node.max[axis]) * 0.5f - centerMin[axis]) * scale);
+            return std::min(bin, kSAHBins - 1);
+        };
+        unsigned int counts[kSAHBins] = {0};
+        glm::vec3 binMin[kSAHBins];
+        glm::vec3 binMax[kSAHBins];
+        std::fill(binMin, binMin + kSAHBins, glm::vec3(1e30f));
+        std::fill(binMax, binMax + kSAHBins, glm::vec3(-1e30f));
+        for(size_t i=begin; i < end; ++i){
+            int bin = binOf(leaves[i]);
+            ++counts[bin];
+            binMin[bin] = glm::min(binMin[bin], m_nodes[leaves[i]].min);
+            binMax[bin] = glm::max(binMax[bin], m_nodes[leaves[i]].max);
+        }
+        // Cost of everything left of each boundary, then add the right
+        float costs[kSAHBins - 1];
+        glm::vec3 sideMin(1e30f);
+        glm::vec3 sideMax(-1e30f);
+        unsigned int sideCount = 0;
+        for(int bin=0; bin < kSAHBins - 1; ++bin){
+            sideMin = glm::min(sideMin, binMin[bin]);
+            sideMax = glm::max(sideMax, binMax[bin]);
+            sideCount += counts[bin];
+            costs[bin] = sideCount > 0 ? SurfaceArea(sideMin, sideMax) * sideCount : 0.0f;
+        }
+        sideMin = glm::vec3(1e30f);
+        sideMax = glm::vec3(-1e30f);
+        sideCount = 0;
+        int best = -1;
+        for(int bin=kSAHBins - 1; bin > 0; --bin){
+            sideMin = glm::min(sideMin, binMin[bin]);
+            sideMax = glm::max(sideMax, binMax[bin]);
+            sideCount += counts[bin];
+            if(sideCount > 0){
+                costs[bin - 1] += SurfaceArea(sideMin, sideMax) * sideCount;
+            }
+            if(sideCount > 0 && sideCount < end - begin && (best < 0 || costs[bin - 1] <= costs[best])){
+                best = bin - 1;
+            }
+        }
+        if(best >= 0){
+            middle = std::partition(leaves.begin() + begin, leaves.begin() + end,
+                                    [&](int32_t leaf){ return binOf(leaf) <= best; }) - leaves.begin();
+        }
+    }
+    if(middle == begin || middle == end){
+        middle = begin + (end - begin) / 2;
+        std::nth_element(leaves.begin() + begin, leaves.begin() + middle, leaves.begin() + end,
+                         [&](int32_t x, int32_t y){
+                             return m_nodes[x].min[axis] + m_nodes[x].max[axis] < m_nodes[y].min[axis] + m_nodes[y].max[axis];
+                         });
+    }
+
+    const int32_t child1 = BuildSAH(leaves, begin, middle);
+    const int32_t child2 = BuildSAH(leaves, middle, end);
+    const int32_t node = AllocateNode();
+    m_nodes[node].child1 = child1;
+    m_nodes[node].child2 = child2;
+    m_nodes[child1].parent = node;
+    m_nodes[child2].parent = node;
+    Refit(node);
+    return node;
+}
+
+void AABBTree::Refit(int32_t index){
+    Node& node = m_nodes[index];
+    const Node& child1 = m_nodes[node.child1];
+    const Node& child2 = m_nodes[node.child2];
+    node.min = glm::min(child1.min, child2.min);
+    node.max = glm::max(child1.max, child2.max);
+    node.height = 1 + std::max(child1.height, child2.height);
+}
+
+bool AABBTree::ValidateNode(int32_t index, int32_t parent) const{
+    const Node& node = m_nodes[index];
+    if(node.parent != parent || node.height < 0){
+        std::cout << "(AABBTree.cpp) ERROR, node " << index << " is not linked to its parent\n";
+        return false;
+    }
+    if(node.IsLeaf()){
+        return node.height == 0;
+    }
+    const Node& child1 = m_nodes[node.child1];
+    const Node& child2 = m_nodes[node.child2];
+    if(node.height != 1 + std::max(child1.height, child2.height)
+       || !Contains(node.min, node.max, child1.min, child1.max)
+       || !Contains(node.min, node.max, child2.min, child2.max)){
+        std::cout << "(AABBTree.cpp) ERROR, node " << index << " has the wrong height or box\n";
+        return false;
+    }
+    return ValidateNode(node.child1, index) && ValidateNode(node.child2, index);
+}
@@ -0,0 +1,621 @@
+#include "Benchmark.hpp"
+#include "Terrain.hpp"
+#include "Geometry.hpp"
+#include "MeshCodec.hpp"
+#include "MeshFile.hpp"
+#include "MeshImporter.hpp"
+#include "TransformHierarchy.hpp"
+#include "AABBTree.hpp"
+
+#include "glm/gtc/matrix_transform.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#if defined(LINUX)
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
+
+namespace{
+    // The terrain used by the demo scene
+    const char* kTerrainFile = "terrain3.ppm";
+    const unsigned int kTerrainSegments = 512;
+    // Every timing is the best of this many runs
+    const int kRepeats = 10;
+    // Reads are written here so the compiler cannot skip them
+    volatile unsigned char s_touched = 0;
+
+    // Seconds since some fixed point in time
+    double Now(){
+        using Clock = std::chrono::high_resolution_clock;
+        return std::chrono::duration<double>(Clock::now().time_since_epoch()).count();
+    }
+
+    // Megabytes per second for 'bytes' handled in 'seconds'
+    double MegabytesPerSecond(double bytes, double seconds){
+        return seconds > 0.0 ? bytes / seconds / (1024.0*1024.0) : 0.0;
+    }
+
+    // Read speeds (MB/s) of typical disks, to compare decoding against
+    // when the disk of this machine cannot be measured
+    struct DiskRate{
+        const char* name;
+        double megabytesPerSecond;
+    };
+    const DiskRate kDiskRates[] = {{"hard disk", 150.0}, {"SATA SSD", 550.0}, {"NVMe SSD", 3500.0}};
+
+    // Drops a file from the page cache, so the next read comes from the
+    // disk. Returns false where that is not possible.
+    bool EvictFromCache(const char* path){
+#if defined(LINUX)
+        int fd = open(path, O_RDONLY);
+        if(fd < 0){
+            return false;
+        }
+        // Dirty pages cannot be dropped, so write them out first
+        bool evicted = fdatasync(fd) == 0 && posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED) == 0;
+        close(fd);
+        return evicted;
+#else
+        (void)path;
+        return false;
+#endif
+    }
+
+    // Builds the demo terrain exactly as Terrain does, without OpenGL
+    void BuildTerrain(Geometry& geometry){
+        std::vector<int> heights(kTerrainSegments*kTerrainSegments);
+        Terrain::LoadHeights(kTerrainFile, kTerrainSegments, kTerrainSegments, heights.data());
+        Terrain::BuildGeometry(geometry, heights.data(), kTerrainSegments, kTerrainSegments);
+        geometry.Gen();
+    }
+
+    // Writes 'contents' to 'path'. Returns false on failure.
+    bool WriteFile(const std::string& path, const std::string& contents){
+        std::ofstream file(path.c_str(), std::ios::binary | std::ios::trunc);
+        file.write(contents.data(), contents.size());
+        return file.good();
+    }
+
+    // Saves positions, texture coordinates and triangles of a generated
+    // geometry as OBJ text. Every corner uses the same v and vt index.
+    std::string MakeOBJ(Geometry& geometry){
+        std::string text;
+        char line[128];
+        const float* data = geometry.GetBufferDataPtr();
+        const unsigned int vertexCount = geometry.GetBufferDataSize() / 14;
+        for(unsigned int i=0; i < vertexCount; ++i){
+            const float* v = data + i*14;
+            text.append(line, std::snprintf(line, sizeof(line), "v %.6f %.6f %.6f\n", v[0], v[1], v[2]));
+        }
+        for(unsigned int i=0; i < vertexCount; ++i){
+            const float* v = data + i*14;
+            text.append(line, std::snprintf(line, sizeof(line), "vt %.6f %.6f\n", v[6], v[7]));
+        }
+        const unsigned int* indices = geometry.GetIndicesDataPtr();
+        for(unsigned int i=0; i + 2 < geometry.GetIndicesSize(); i += 3){
+            unsigned int a = indices[i]+1, b = indices[i+1]+1, c = indices[i+2]+1;
+            text.append(line, std::snprintf(line, sizeof(line), "f %u/%u %u/%u %u/%u\n", a, a, b, b, c, c));
+        }
+        return text;
+    }
+
+    // Appends the raw bytes of 'value' to 'out'
+    template<typename T>
+    void AppendBytes(std::string& out, const T* values, size_t count){
+        out.append(reinterpret_cast<const char*>(values), sizeof(T)*count);
+    }
+
+    // A scene graph node the way SceneNode used to store one: its own
+    // transforms, and pointers to children allocated one by one
+    struct TreeNode{
+        Transform local;
+        Transform world;
+        std::vector<TreeNode*> children;
+    };
+
+    void UpdateTree(TreeNode* node, const Transform& parentWorld){
+        node->world = parentWorld * node->local;
+        for(size_t i=0; i < node->children.size(); ++i){
+            UpdateTree(node->children[i], node->world);
+        }
+    }
+
+    // Small deterministic random numbers, so every run builds the same tree
+    uint32_t s_random = 12345;
+    uint32_t NextRandom(){
+        s_random = s_random*1664525u + 1013904223u;
+        return s_random >> 8;
+    }
+    float RandomFloat(float low, float high){
+        return low + (high - low)*(NextRandom() & 0xffff)/65535.0f;
+    }
+
+    // Saves a generated geometry as a single mesh .glb file
+    std::string MakeGLB(Geometry& geometry){
+        const float* data = geometry.GetBufferDataPtr();
+        const unsigned int vertexCount = geometry.GetBufferDataSize() / 14;
+        const unsigned int indexCount = geometry.GetIndicesSize();
+        std::string binary;
+        for(unsigned int i=0; i < vertexCount; ++i){
+            AppendBytes(binary, data + i*14, 3);
+        }
+        for(unsigned int i=0; i < vertexCount; ++i){
+            // glTF texture space starts at the top left
+            float st[2] = {data[i*14+6], 1.0f - data[i*14+7]};
+            AppendBytes(binary, st, 2);
+        }
+        AppendBytes(binary, geometry.GetIndicesDataPtr(), indexCount);
+        const size_t positionBytes = vertexCount*12, texcoordBytes = vertexCount*8, indexBytes = indexCount*4;
+
+        char json[1024];
+        int length = std::snprintf(json, sizeof(json),
+            "{\"asset\":{\"version\":\"2.0\"},"
+            "\"buffers\":[{\"byteLength\":%zu}],"
+            "\"bufferViews\":[{\"buffer\":0,\"byteOffset\":0,\"byteLength\":%zu},"
+                            "{\"buffer\":0,\"byteOffset\":%zu,\"byteLength\":%zu},"
+                            "{\"buffer\":0,\"byteOffset\":%zu,\"byteLength\":%zu}],"
+            "\"accessors\":[{\"bufferView\":0,\"componentType\":5126,\"count\":%u,\"type\":\"VEC3\"},"
+                          "{\"bufferView\":1,\"componentType\":5126,\"count\":%u,\"type\":\"VEC2\"},"
+                          "{\"bufferView\":2,\"componentType\":5125,\"count\":%u,\"type\":\"SCALAR\"}],"
+            "\"meshes\":[{\"primitives\":[{\"attributes\":{\"POSITION\":0,\"TEXCOORD_0\":1},\"indices\":2}]}]}",
+            binary.size(), positionBytes, positionBytes, texcoordBytes,
+            positionBytes + texcoordBytes, indexBytes, vertexCount, vertexCount, indexCount);
+        std::string jsonChunk(json, length);
+        // Chunks are padded to 4 bytes (JSON with spaces)
+        while(jsonChunk.size() % 4 != 0){
+            jsonChunk += ' ';
+        }
+        while(binary.size() % 4 != 0){
+            binary += '\0';
+        }
+        const uint32_t header[3] = {0x46546C67, 2, (uint32_t)(12 + 8 + jsonChunk.size() + 8 + binary.size())};
+        const uint32_t jsonHeader[2] = {(uint32_t)jsonChunk.size(), 0x4E4F534A};
+        const uint32_t binaryHeader[2] = {(uint32_t)binary.size(), 0x004E4942};
+        std::string glb;
+        AppendBytes(glb, header, 3);
+        AppendBytes(glb, jsonHeader, 2);
+        glb += jsonChunk;
+        AppendBytes(glb, binaryHeader, 2);
+        glb += binary;
+        return glb;
+    }
+}
+
+int Benchmark::Run(){
+    bool ok = true;
+    ok = MeshCodecBenchmark() && ok;
+    ok = MeshImporterBenchmark() && ok;
+    ok = TransformHierarchyBenchmark() && ok;
+    ok = AABBTreeBenchmark() && ok;
+    std::cout << (ok ? "(Benchmark.cpp) All benchmarks passed\n"
+                     : "(Benchmark.cpp) ERROR, some benchmarks failed\n");
+    return ok ? 0 : 1;
+}
+
+// Builds the demo terrain exactly as Terrain does (meshlet order included,
+// since that is what gets cooked), then compresses and decompresses it.
+bool Benchmark::MeshCodecBenchmark(){
+    std::cout << "(Benchmark.cpp) MeshCodec on " << kTerrainFile << "\n";
+    Geometry geometry;
+    BuildTerrain(geometry);
+
+    const unsigned int stride = sizeof(float)*14;
+    const unsigned int vertexCount = geometry.GetBufferDataSize() / 14;
+    const unsigned int indexCount = geometry.GetIndicesSize();
+    const double vertexBytes = double(vertexCount) * stride;
+    const double indexBytes = double(indexCount) * sizeof(unsigned int);
+
+    std::vector<unsigned char> encodedVertices;
+    std::vector<unsigned char> encodedIndices;
+    double start = Now();
+    MeshCodec::EncodeVertices(geometry.GetBufferDataPtr(), vertexCount, stride, encodedVertices);
+    double vertexEncode = Now() - start;
+    start = Now();
+    MeshCodec::EncodeIndices(geometry.GetIndicesDataPtr(), indexCount, encodedIndices);
+    double indexEncode = Now() - start;
+
+    std::vector<float> vertices(geometry.GetBufferDataSize());
+    std::vector<unsigned int> indices(indexCount);
+    double vertexDecode = 1e30;
+    double indexDecode = 1e30;
+    bool ok = true;
+    for(int run=0; run < kRepeats; ++run){
+        start = Now();
+        ok = MeshCodec::DecodeVertices(encodedVertices.data(), encodedVertices.size(),
+                                       vertices.data(), vertexCount, stride) && ok;
+        vertexDecode = std::min(vertexDecode, Now() - start);
+        start = Now();
+        ok = MeshCodec::DecodeIndices(encodedIndices.data(), encodedIndices.size(),
+                                      indices.data(), indexCount) && ok;
+        indexDecode = std::min(indexDecode, Now() - start);
+    }
+    // The codec is lossless, so the data must match bit for bit
+    ok = ok && std::memcmp(vertices.data(), geometry.GetBufferDataPtr(), vertexBytes) == 0
+            && std::memcmp(indices.data(), geometry.GetIndicesDataPtr(), indexBytes) == 0;
+
+    std::printf("    vertices: %u x %u bytes, %.2f MB -> %.2f MB (ratio %.2f)\n",
+                vertexCount, stride, vertexBytes/(1024.0*1024.0),
+                encodedVertices.size()/(1024.0*1024.0), vertexBytes/encodedVertices.size());
+    std::printf("              encode %.1f MB/s, decode %.1f MB/s\n",
+                MegabytesPerSecond(vertexBytes, vertexEncode), MegabytesPerSecond(vertexBytes, vertexDecode));
+    std::printf("    indices:  %u, %.2f MB -> %.2f MB (ratio %.2f, %.2f bits per triangle)\n",
+                indexCount, indexBytes/(1024.0*1024.0), encodedIndices.size()/(1024.0*1024.0),
+                indexBytes/encodedIndices.size(), encodedIndices.size()*8.0/(indexCount/3));
+    std::printf("              encode %.1f MB/s, decode %.1f MB/s\n",
+                MegabytesPerSecond(indexBytes, indexEncode), MegabytesPerSecond(indexBytes, indexDecode));
+
+    // Loading a cooked file both ways: with the file in the page cache
+    // (decoding against memory speed), and with it dropped from the cache
+    // first, so it is read from the disk (decoding against disk speed).
+    const char* paths[2] = {"bench_raw.mesh", "bench_compressed.mesh"};
+    double warm[2] = {0.0, 0.0};
+    double cold[2] = {0.0, 0.0};
+    bool measuredCold = true;
+    for(int compressed=0; compressed < 2; ++compressed){
+        if(!MeshFile::Cook(geometry, paths[compressed], 0, compressed != 0)){
+            ok = false;
+            continue;
+        }
+        uint64_t fileSize = 0;
+        warm[compressed] = 1e30;
+        cold[compressed] = 1e30;
+        for(int run=0; run < kRepeats; ++run){
+            // Every other run starts from the disk
+            const bool fromDisk = run % 2 == 0 && EvictFromCache(paths[compressed]);
+            measuredCold = measuredCold && (run % 2 != 0 || fromDisk);
+            MeshFile cooked;
+            start = Now();
+            bool loaded = cooked.Load(paths[compressed], 0);
+            // Touch every page so mapped files pay for their reads too
+            if(loaded){
+                const unsigned char* bytes = reinterpret_cast<const unsigned char*>(cooked.GetBufferDataPtr());
+                for(size_t i=0; i < (size_t)vertexBytes; i += 4096){
+                    s_touched = bytes[i];
+                }
+                fileSize = cooked.GetHeader().vertexDataSize + cooked.GetHeader().indexDataSize;
+            }
+            double& best = fromDisk ? cold[compressed] : warm[compressed];
+            best = std::min(best, Now() - start);
+            ok = ok && loaded;
+        }
+        std::printf("    %s load: %.2f MB on disk, %.2f ms from the page cache", compressed ? "compressed" : "raw       ",
+                    fileSize/(1024.0*1024.0), warm[compressed]*1000.0);
+        if(measuredCold){
+            std::printf(", %.2f ms from disk (%.1f MB/s of mesh data)", cold[compressed]*1000.0,
+                        MegabytesPerSecond(vertexBytes + indexBytes, cold[compressed]));
+        }
+        std::printf("\n");
+        std::remove(paths[compressed]);
+    }
+    if(measuredCold){
+        std::printf("    from this disk, compressed loads are %.2fx as fast as raw\n", cold[0] / cold[1]);
+    }else{
+        std::printf("    (the page cache cannot be dropped here, so nothing was read from disk)\n");
+    }
+
+    // Decoding only pays off if it produces the mesh faster than the disk
+    // could read it raw. Compare against disks this machine may not have.
+    const double meshBytes = vertexBytes + indexBytes;
+    const double decodeSeconds = vertexDecode + indexDecode;
+    const double compressedBytes = encodedVertices.size() + encodedIndices.size();
+    std::printf("    decode: %.1f MB/s of mesh data\n", MegabytesPerSecond(meshBytes, decodeSeconds));
+    for(const DiskRate& disk : kDiskRates){
+        const double bytesPerSecond = disk.megabytesPerSecond * 1024.0 * 1024.0;
+        const double raw = meshBytes / bytesPerSecond;
+        const double compressed = compressedBytes / bytesPerSecond + decodeSeconds;
+        std::printf("    %-9s at %4.0f MB/s: raw %.2f ms, compressed %.2f ms (read, then decode): %s\n",
+                    disk.name, disk.megabytesPerSecond, raw*1000.0, compressed*1000.0,
+                    compressed < raw ? "compressed is faster" : "raw is faster");
+    }
+    std::cout << (ok ? "    round trip: OK\n" : "    round trip: FAILED\n");
+    return ok;
+}
+
+// Saves the terrain as OBJ text and as a glb, then imports both from
+// files (mapped) and from memory. The welded result must have exactly
+// as many vertices and indices as the terrain it came from.
+bool Benchmark::MeshImporterBenchmark(){
+    std::cout << "(Benchmark.cpp) MeshImporter on " << kTerrainFile << "\n";
+    Geometry terrain;
+    BuildTerrain(terrain);
+    const unsigned int vertexCount = terrain.GetBufferDataSize() / 14;
+    const unsigned int indexCount = terrain.GetIndicesSize();
+
+    const char* names[2] = {"OBJ", "glb"};
+    const char* paths[2] = {"bench_terrain.obj", "bench_terrain.glb"};
+    const std::string contents[2] = {MakeOBJ(terrain), MakeGLB(terrain)};
+    // Parsing is slow compared to the codec, so fewer repeats are enough
+    const int repeats = 3;
+    bool ok = true;
+    for(int format=0; format < 2; ++format){
+        if(!WriteFile(paths[format], contents[format])){
+            std::cout << "    could not write " << paths[format] << "\n";
+            ok = false;
+            continue;
+        }
+        double fromFile = 1e30;
+        double fromMemory = 1e30;
+        for(int run=0; run < repeats; ++run){
+            Geometry geometry;
+            double start = Now();
+            bool loaded = MeshImporter::Load(paths[format], geometry);
+            fromFile = std::min(fromFile, Now() - start);
+            ok = ok && loaded && geometry.GetIndicesSize() == indexCount;
+
+            Geometry inMemory;
+            start = Now();
+            loaded = format == 0 ? MeshImporter::ParseOBJ(contents[format].data(), contents[format].size(), inMemory)
+                                 : MeshImporter::ParseGLTF(contents[format].data(), contents[format].size(), "", inMemory);
+            fromMemory = std::min(fromMemory, Now() - start);
+            ok = ok && loaded && inMemory.GetIndicesSize() == indexCount;
+            // Welding must find every shared vertex again
+            inMemory.Gen();
+            ok = ok && inMemory.GetBufferDataSize() / 14 == vertexCount;
+        }
+        std::printf("    %s: %.2f MB, file %.1f MB/s (%.1f ms), memory %.1f MB/s (%.1f ms)\n", names[format],
+                    contents[format].size()/(1024.0*1024.0),
+                    MegabytesPerSecond(contents[format].size(), fromFile), fromFile*1000.0,
+                    MegabytesPerSecond(contents[format].size(), fromMemory), fromMemory*1000.0);
+        std::remove(paths[format]);
+    }
+    std::cout << (ok ? "    import: OK\n" : "    import: FAILED\n");
+    return ok;
+}
+
+// Builds random trees (every node hangs off a random earlier one) both
+// as a pointer linked tree and in a TransformHierarchy, checks that
+// they agree, then times updating every node, 1% of the nodes, and
+// nothing at all.
+bool Benchmark::TransformHierarchyBenchmark(){
+    std::cout << "(Benchmark.cpp) TransformHierarchy\n";
+    const unsigned int sizes[3] = {1000, 10000, 100000};
+    bool ok = true;
+    for(unsigned int size : sizes){
+        s_random = 12345;
+        std::vector<std::unique_ptr<TreeNode>> tree;
+        TransformHierarchy hierarchy;
+        std::vector<TransformHierarchy::Handle> handles;
+        for(unsigned int i=0; i < size; ++i){
+            tree.emplace_back(new TreeNode());
+            handles.push_back(hierarchy.Create());
+            float x = RandomFloat(-2.0f, 2.0f), y = RandomFloat(-2.0f, 2.0f), z = RandomFloat(-2.0f, 2.0f);
+            float angle = RandomFloat(0.0f, 6.28f);
+            float scale = RandomFloat(0.9f, 1.1f);
+            Transform* locals[2] = {&tree[i]->local, &hierarchy.GetLocal(handles[i])};
+            for(Transform* local : locals){
+                local->Translate(x, y, z);
+                local->Rotate(angle, 0, 1, 0);
+                local->Scale(scale, scale, scale);
+            }
+            if(i > 0){
+                unsigned int parent = NextRandom() % i;
+                tree[parent]->children.push_back(tree[i].get());
+                hierarchy.SetParent(handles[i], handles[parent]);
+            }
+        }
+
+        // Both must produce the same world transforms
+        Transform identity;
+        UpdateTree(tree[0].get(), identity);
+        hierarchy.Update();
+        float worst = 0.0f;
+        for(unsigned int i=0; i < size; ++i){
+            const glm::mat4& a = tree[i]->world.GetInternalMatrix();
+            const glm::mat4& b = hierarchy.GetWorld(handles[i]).GetInternalMatrix();
+            for(int c=0; c < 4; ++c){
+                for(int r=0; r < 4; ++r){
+                    float error = std::fabs(a[c][r] - b[c][r]) / std::max(1.0f, std::fabs(a[c][r]));
+                    worst = std::max(worst, error);
+                }
+            }
+        }
+        ok = ok && worst < 1e-4f && hierarchy.GetLastUpdateCount() == size;
+
+        double treeTime = 1e30;
+        double fullTime = 1e30;
+        double partialTime = 1e30;
+        double staticTime = 1e30;
+        unsigned int partialCount = 0;
+        for(int run=0; run < kRepeats; ++run){
+            double start = Now();
+            UpdateTree(tree[0].get(), identity);
+            treeTime = std::min(treeTime, Now() - start);
+
+            // Moving the root moves everything
+            hierarchy.GetLocal(handles[0]).Rotate(0.01f, 0, 1, 0);
+            start = Now();
+            hierarchy.Update();
+            fullTime = std::min(fullTime, Now() - start);
+            ok = ok && hierarchy.GetLastUpdateCount() == size;
+
+            for(unsigned int i=0; i < size/100; ++i){
+                hierarchy.GetLocal(handles[1 + NextRandom() % (size - 1)]).Translate(0.01f, 0, 0);
+            }
+            start = Now();
+            hierarchy.Update();
+            partialTime = std::min(partialTime, Now() - start);
+            partialCount = hierarchy.GetLastUpdateCount();
+
+            start = Now();
+            hierarchy.Update();
+            staticTime = std::min(staticTime, Now() - start);
+            ok = ok && hierarchy.GetLastUpdateCount() == 0;
+        }
+        std::printf("    %6u nodes: pointer tree %.3f ms, flat %.3f ms (%.1fx), 1%% moved %.3f ms (%u updated), static %.3f ms\n",
+                    size, treeTime*1000.0, fullTime*1000.0, fullTime > 0.0 ? treeTime/fullTime : 0.0,
+                    partialTime*1000.0, partialCount, staticTime*1000.0);
+        if(worst >= 1e-4f){
+            std::printf("    results differ by up to %g\n", worst);
+        }
+    }
+    std::cout << (ok ? "    world transforms: OK\n" : "    world transforms: FAILED\n");
+    return ok;
+}
+
+// Scatters boxes of different sizes over a terrain sized area, then
+// runs the same queries against the tree and against every box, which
+// must find the same things. The tree is timed as built one insert at a
+// time, after moving 10% of the boxes, and after a SAH rebuild.
+bool Benchmark::AABBTreeBenchmark(){
+    std::cout << "(Benchmark.cpp) AABBTree\n";
+    const unsigned int sizes[2] = {10000, 100000};
+    const unsigned int kQueries = 1000;
+    const float kWorld = 512.0f;
+    bool ok = true;
+    for(unsigned int size : sizes){
+        s_random = 12345;
+        std::vector<Bounds> boxes(size);
+        for(Bounds& box : boxes){
+            glm::vec3 center(RandomFloat(0.0f, kWorld), RandomFloat(0.0f, 32.0f), RandomFloat(0.0f, kWorld));
+            glm::vec3 extents(RandomFloat(0.2f, 2.0f), RandomFloat(0.2f, 2.0f), RandomFloat(0.2f, 2.0f));
+            box.min = center - extents;
+            box.max = center + extents;
+        }
+        std::vector<Bounds> queries(kQueries);
+        std::vector<glm::vec3> rayOrigins(kQueries);
+        std::vector<glm::vec3> rayDirections(kQueries);
+        for(unsigned int i=0; i < kQueries; ++i){
+            glm::vec3 center(RandomFloat(0.0f, kWorld), RandomFloat(0.0f, 32.0f), RandomFloat(0.0f, kWorld));
+            queries[i].min = center - glm::vec3(8.0f);
+            queries[i].max = center + glm::vec3(8.0f);
+            rayOrigins[i] = glm::vec3(RandomFloat(0.0f, kWorld), 16.0f, RandomFloat(0.0f, kWorld));
+            rayDirections[i] = glm::normalize(glm::vec3(RandomFloat(-1.0f, 1.0f), RandomFloat(-0.2f, 0.2f), RandomFloat(-1.0f, 1.0f)));
+        }
+
+        double start = Now();
+        AABBTree tree;
+        std::vector<AABBTree::Proxy> proxies(size);
+        for(unsigned int i=0; i < size; ++i){
+            proxies[i] = tree.Insert(boxes[i], reinterpret_cast<void*>((uintptr_t)i));
+        }
+        double buildTime = Now() - start;
+        ok = tree.Validate() && ok;
+
+        // What every query should find, by testing every (grown) box
+        unsigned int expectedBoxes = 0;
+        unsigned int expectedSpheres = 0;
+        std::vector<float> expectedRays(kQueries, 1e30f);
+        start = Now();
+        for(unsigned int q=0; q < kQueries; ++q){
+            glm::vec3 center = (queries[q].min + queries[q].max) * 0.5f;
+            for(unsigned int i=0; i < size; ++i){
+                Bounds fat = tree.GetFatBounds(proxies[i]);
+                expectedBoxes += fat.min.x <= queries[q].max.x && fat.min.y <= queries[q].max.y && fat.min.z <= queries[q].max.z
+                              && queries[q].min.x <= fat.max.x && queries[q].min.y <= fat.max.y && queries[q].min.z <= fat.max.z;
+                glm::vec3 offset = glm::clamp(center, fat.min, fat.max) - center;
+                expectedSpheres += glm::dot(offset, offset) <= 64.0f;
+            }
+        }
+        double bruteTime = Now() - start;
+
+        // Times the box and sphere queries, and the closest hit of each
+        // ray, checking the counts along the way
+        auto runQueries = [&](const AABBTree& queried, double& boxTime, double& rayTime, unsigned int& hits){
+            unsigned int foundBoxes = 0;
+            unsigned int foundSpheres = 0;
+            double begin = Now();
+            for(unsigned int q=0; q < kQueries; ++q){
+                queried.QueryBox(queries[q], [&](AABBTree::Proxy){ ++foundBoxes; return true; });
+                queried.QuerySphere((queries[q].min + queries[q].max) * 0.5f, 8.0f,
+                                    [&](AABBTree::Proxy){ ++foundSpheres; return true; });
+            }
+            boxTime = Now() - begin;
+            begin = Now();
+            hits = 0;
+            for(unsigned int q=0; q < kQueries; ++q){
+                bool hit = false;
+                // The boxes are the objects, so entering one is a hit
+                queried.QueryRay(rayOrigins[q], rayDirections[q], 1000.0f, [&](AABBTree::Proxy proxy, float maxDistance){
+                    Bounds fat = queried.GetFatBounds(proxy);
+                    glm::vec3 t0 = (fat.min - rayOrigins[q]) / rayDirections[q];
+                    glm::vec3 t1 = (fat.max - rayOrigins[q]) / rayDirections[q];
+                    glm::vec3 entries = glm::min(t0, t1);
+                    float enter = std::max(std::max(entries.x, entries.y), std::max(entries.z, 0.0f));
+                    hit = true;
+                    return std::min(enter, maxDistance);
+                });
+                hits += hit;
+            }
+            rayTime = Now() - begin;
+            return foundBoxes == expectedBoxes && foundSpheres == expectedSpheres;
+        };
+
+        double boxTime = 0.0, rayTime = 0.0;
+        unsigned int hits = 0;
+        ok = runQueries(tree, boxTime, rayTime, hits) && ok;
+        std::printf("    %6u boxes: inserted in %.2f ms, height %d, area ratio %.1f\n",
+                    size, buildTime*1000.0, tree.GetHeight(), tree.GetAreaRatio());
+        std::printf("        %u box + sphere queries: tree %.2f ms, every box %.2f ms (%.0fx); %u rays %.2f ms (%u hit)\n",
+                    kQueries, boxTime*1000.0, bruteTime*1000.0, boxTime > 0.0 ? bruteTime/boxTime : 0.0, kQueries, rayTime*1000.0, hits);
+
+        // Move a tenth of the boxes by up to a few units
+        unsigned int reinserted = 0;
+        start = Now();
+        for(unsigned int i=0; i < size; i += 10){
+            glm::vec3 offset(RandomFloat(-0.15f, 0.15f), 0.0f, RandomFloat(-3.0f, 3.0f));
+            boxes[i].min += offset;
+            boxes[i].max += offset;
+            reinserted += tree.Move(proxies[i], boxes[i]);
+        }
+        double moveTime = Now() - start;
+        ok = tree.Validate() && ok;
+        std::printf("        moved %u boxes in %.2f ms (%u reinserted), height %d, area ratio %.1f\n",
+                    size/10, moveTime*1000.0, reinserted, tree.GetHeight(), tree.GetAreaRatio());
+
+        start = Now();
+        tree.Rebuild();
+        double rebuildTime = Now() - start;
+        ok = tree.Validate() && ok;
+        // Moving changed the boxes, so the brute force answers are stale;
+        // the same queries on the rebuilt tree must match the moved one
+        expectedBoxes = 0;
+        expectedSpheres = 0;
+        for(unsigned int q=0; q < kQueries; ++q){
+            for(unsigned int i=0; i < size; ++i){
+                Bounds fat = tree.GetFatBounds(proxies[i]);
+                glm::vec3 center = (queries[q].min + queries[q].max) * 0.5f;
+                expectedBoxes += fat.min.x <= queries[q].max.x && fat.min.y <= queries[q].max.y && fat.min.z <= queries[q].max.z
+                              && queries[q].min.x <= fat.max.x && queries[q].min.y <= fat.max.y && queries[q].min.z <= fat.max.z;
+                glm::vec3 offset = glm::clamp(center, fat.min, fat.max) - center;
+                expectedSpheres += glm::dot(offset, offset) <= 64.0f;
+            }
+        }
+        ok = runQueries(tree, boxTime, rayTime, hits) && ok;
+        std::printf("        SAH rebuild %.2f ms, height %d, area ratio %.1f; queries %.2f ms, rays %.2f ms\n",
+                    rebuildTime*1000.0, tree.GetHeight(), tree.GetAreaRatio(), boxTime*1000.0, rayTime*1000.0);
+
+        // The frustum query must agree with testing every box
+        Frustum frustum;
+        frustum.Extract(glm::perspective(45.0f, 1.0f, 0.1f, 512.0f)
+                        * glm::lookAt(glm::vec3(0.0f, 16.0f, 0.0f), glm::vec3(kWorld, 0.0f, kWorld), glm::vec3(0.0f, 1.0f, 0.0f)));
+        unsigned int expectedVisible = 0;
+        for(unsigned int i=0; i < size; ++i){
+            Bounds fat = tree.GetFatBounds(proxies[i]);
+            expectedVisible += frustum.TestBox((fat.min + fat.max) * 0.5f, fat.GetExtents()) != Frustum::Containment::Outside;
+        }
+        unsigned int visible = 0;
+        start = Now();
+        tree.QueryFrustum(frustum, [&](AABBTree::Proxy){ ++visible; return true; });
+        double frustumTime = Now() - start;
+        ok = ok && visible == expectedVisible;
+        std::printf("        frustum: %u of %u visible in %.3f ms\n", visible, size, frustumTime*1000.0);
+
+        for(unsigned int i=0; i < size; i += 2){
+            tree.Remove(proxies[i]);
+        }
+        ok = tree.Validate() && tree.GetCount() == size - (size + 1)/2 && ok;
+    }
+    std::cout << (ok ? "    queries: OK\n" : "    queries: FAILED\n");
+    return ok;
+}
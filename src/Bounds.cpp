@@ -0,0 +1,79 @@
+#include "Bounds.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+bool Bounds::IsEmpty() const{
+    return min.x > max.x;
+}
+
+glm::vec3 Bounds::GetExtents() const{
+    return IsEmpty() ? glm::vec3(0.0f) : (max - min) * 0.5f;
+}
+
+void Bounds::Add(const glm::vec3& point){
+    min = glm::min(min, point);
+    max = glm::max(max, point);
+}
+
+// The sphere around the union of two spheres is the smallest sphere
+// holding both; if one already holds the other it is kept as it is
+void Bounds::Add(const Bounds& other){
+    if(other.IsEmpty()){
+        return;
+    }
+    if(IsEmpty()){
+        *this = other;
+        return;
+    }
+    min = glm::min(min, other.min);
+    max = glm::max(max, other.max);
+
+    glm::vec3 offset = other.center - center;
+    float distance = glm::length(offset);
+    if(distance + other.radius <= radius){
+        return;
+    }
+    if(distance + radius <= other.radius){
+        center = other.center;
+        radius = other.radius;
+        return;
+    }
+    float newRadius = (distance + radius + other.radius) * 0.5f;
+    center += offset * ((newRadius - radius) / distance);
+    radius = newRadius;
+}
+
+void Bounds::UpdateSphere(){
+    if(IsEmpty()){
+        center = glm::vec3(0.0f);
+        radius = -1.0f;
+        return;
+    }
+    center = (min + max) * 0.5f;
+    radius = glm::length(max - center);
+}
+
+// The new box is centered on the moved center, and reaches as far along
+// each axis as the moved extents can (Arvo's method)
+Bounds Bounds::Transformed(const glm::mat4& matrix) const{
+    if(IsEmpty()){
+        return *this;
+    }
+    const glm::vec3 boxCenter = (min + max) * 0.5f;
+    const glm::vec3 extents = GetExtents();
+    const glm::mat3 linear(matrix);
+    const glm::mat3 absolute(glm::abs(linear[0]), glm::abs(linear[1]), glm::abs(linear[2]));
+
+    Bounds result;
+    const glm::vec3 newCenter = glm::vec3(matrix * glm::vec4(boxCenter, 1.0f));
+    const glm::vec3 newExtents = absolute * extents;
+    result.min = newCenter - newExtents;
+    result.max = newCenter + newExtents;
+
+    const float scale = std::sqrt(std::max(glm::dot(linear[0], linear[0]),
+                                  std::max(glm::dot(linear[1], linear[1]), glm::dot(linear[2], linear[2]))));
+    result.center = glm::vec3(matrix * glm::vec4(center, 1.0f));
+    result.radius = radius * scale;
+    return result;
+}
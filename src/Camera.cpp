@@ -148,3 +148,26 @@ glm::mat4 Camera::GetWorldToViewmatrix() const{
                         m_eyePosition + m_viewDirection,
                         m_upVector);
 }
+
+void Camera::UpdateMatrices(const glm::mat4& projection){
+    m_view = GetWorldToViewmatrix();
+    m_projection = projection;
+    m_viewProjection = projection * m_view;
+    m_frustum.Extract(m_viewProjection);
+}
+
+const glm::mat4& Camera::GetViewMatrix() const{
+    return m_view;
+}
+
+const glm::mat4& Camera::GetProjectionMatrix() const{
+    return m_projection;
+}
+
+const glm::mat4& Camera::GetViewProjectionMatrix() const{
+    return m_viewProjection;
+}
+
+const Frustum& Camera::GetFrustum() const{
+    return m_frustum;
+}
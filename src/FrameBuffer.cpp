@@ -6,19 +6,18 @@
 
 
 #include "Framebuffer.hpp"
+#include "GLState.hpp"
 #include "Shader.hpp"
+#include "ShaderManager.hpp"
 
 #include <glad/glad.h>
 #include <iostream>
 
-Framebuffer::Framebuffer(std::string frag_name, float x, float y, float w, float h, int camera){
+Framebuffer::Framebuffer(std::string frag_name, float x, float y, float w, float h, int camera) : m_name(frag_name){
     // (1) ======= Setup shader
-    m_fboShader = std::make_shared<Shader>();
-    // Setup shaders for the Framebuffer Object
-    std::string fboVertexShader = m_fboShader->LoadShader("./shaders/fboVert.glsl");
-    std::string fboFragmentShader = m_fboShader->LoadShader(frag_name);
-    // Actually create our shader
-    m_fboShader->CreateShader(fboVertexShader,fboFragmentShader);       
+    // Framebuffers and mirrors with the same fragment shader share one program
+    m_fboShader = ShaderManager::Instance().Get("./shaders/fboVert.glsl", frag_name);
+    m_diffuseMapUniform = m_fboShader->GetUniform("u_DiffuseMap", GL_INT);
     // (2) ======= Setup quad to draw to
     // Setup the screen quad
     SetupScreenQuad(x,y,w,h);
@@ -26,10 +25,9 @@ Framebuffer::Framebuffer(std::string frag_name, float x, float y, float w, float
 }
 
 // Destructor
+// The framebuffer, its attachments and the quad are GpuResources,
+// which delete themselves
 Framebuffer::~Framebuffer(){
-    glDeleteFramebuffers(1,&m_fbo_id); 
-    glDeleteVertexArrays(1,&m_quadVAO);
-    glDeleteBuffers(1,&m_quadVBO);
 }
 
 
@@ -41,27 +39,30 @@ Framebuffer::~Framebuffer(){
 void Framebuffer::Create(int width, int height){
 
     // Generate a framebuffer
-    glGenFramebuffers(1, &m_fbo_id);
+    // (Creating it again replaces the old objects)
+    m_fbo.Create(GpuResourceType::Framebuffer, m_name, "Framebuffer");
     // Select the buffer we have just generated
     Bind();
     // Create a color attachement texture
-    glGenTextures(1, &m_colorBuffer_id);
-    glBindTexture(GL_TEXTURE_2D, m_colorBuffer_id);
+    m_colorBuffer.Create(GpuResourceType::Texture, m_name, "Framebuffer");
+    GLState::BindTexture(0, GL_TEXTURE_2D, m_colorBuffer.Get());
     glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, NULL); // texture size
+    m_colorBuffer.SetBytes(GpuResources::GetImageBytes(GL_RGB, width, height));
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glFramebufferTexture2D(GL_FRAMEBUFFER,GL_COLOR_ATTACHMENT0,GL_TEXTURE_2D,m_colorBuffer_id,0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER,GL_COLOR_ATTACHMENT0,GL_TEXTURE_2D,m_colorBuffer.Get(),0);
     // Create our render buffer object
-    glGenRenderbuffers(1,&m_rbo_id);
-    glBindRenderbuffer(GL_RENDERBUFFER,m_rbo_id);
+    m_rbo.Create(GpuResourceType::Renderbuffer, m_name, "Framebuffer");
+    glBindRenderbuffer(GL_RENDERBUFFER,m_rbo.Get());
     glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8,width,height);
-    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, m_rbo_id);
+    m_rbo.SetBytes(GpuResources::GetImageBytes(GL_DEPTH24_STENCIL8, width, height));
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, m_rbo.Get());
     // Deselect our buffers
     Unbind();
 }
 // Select our framebuffer
 void Framebuffer::Bind(){
-    glBindFramebuffer(GL_FRAMEBUFFER, m_fbo_id);
+    GLState::BindFramebuffer(GL_FRAMEBUFFER, m_fbo.Get());
 }
 
 // Update our framebuffer once per frame for any
@@ -74,20 +75,20 @@ void Framebuffer::Update(){
     // For our object, we apply the texture in the following way
     // Note that we set the value to 0, because we have bound
     // our texture to slot 0.
-    m_fboShader->SetUniform1i("u_DiffuseMap",0);  
+    m_fboShader->SetUniform1i(m_diffuseMapUniform,0);  
 }
 
 // Done with our framebuffer
 void Framebuffer::Unbind(){
-    glBindFramebuffer(GL_FRAMEBUFFER,0);
+    GLState::BindFramebuffer(GL_FRAMEBUFFER,0);
 }
 
 // Draws the screen quad
 // This is the actual rendering of our FBO to the screen.
 // Typically this would be called after 'update'
 void Framebuffer::DrawFBO(){
-    glBindVertexArray(m_quadVAO);
-    glBindTexture(GL_TEXTURE_2D, m_colorBuffer_id);   // use the color attachment texture as the texture of the quad plane
+    GLState::BindVertexArray(m_quadVAO.Get());
+    GLState::BindTexture(0, GL_TEXTURE_2D, m_colorBuffer.Get());   // use the color attachment texture as the texture of the quad plane
     glDrawArrays(GL_TRIANGLES, 0, 6);
 }
 
@@ -114,12 +115,13 @@ void Framebuffer::SetupScreenQuad(float x,float y, float w, float h){
     };
 
 // screen quad VAO
-    glGenVertexArrays(1, &m_quadVAO);
-    glGenBuffers(1, &m_quadVBO);
-    glBindVertexArray(m_quadVAO);
+    m_quadVAO.Create(GpuResourceType::VertexArray, m_name, "Framebuffer");
+    m_quadVBO.Create(GpuResourceType::Buffer, m_name, "Framebuffer");
+    GLState::BindVertexArray(m_quadVAO.Get());
 
-    glBindBuffer(GL_ARRAY_BUFFER, m_quadVBO);
+    GLState::BindBuffer(GL_ARRAY_BUFFER, m_quadVBO.Get());
     glBufferData(GL_ARRAY_BUFFER, sizeof(quad), &quad, GL_STATIC_DRAW);
+    m_quadVBO.SetBytes(sizeof(quad));
     glEnableVertexAttribArray(0);
     glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
     glEnableVertexAttribArray(1);
@@ -0,0 +1,109 @@
+#include "Frustum.hpp"
+
+#include <cmath>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define FRUSTUM_SSE 1
+#endif
+
+// Constructor
+Frustum::Frustum(){
+    for(int i=0; i < 6; ++i){
+        m_planes[i] = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+    }
+    UpdatePadded();
+}
+
+// Extract the planes (Gribb & Hartmann).
+// A point p is inside when dot(plane, vec4(p,1)) >= 0 for every plane.
+// glm matrices are column major, so row i is (m[0][i], m[1][i], m[2][i], m[3][i]).
+void Frustum::Extract(const glm::mat4& m){
+    glm::vec4 row0(m[0][0], m[1][0], m[2][0], m[3][0]);
+    glm::vec4 row1(m[0][1], m[1][1], m[2][1], m[3][1]);
+    glm::vec4 row2(m[0][2], m[1][2], m[2][2], m[3][2]);
+    glm::vec4 row3(m[0][3], m[1][3], m[2][3], m[3][3]);
+
+    m_planes[0] = row3 + row0; // left
+    m_planes[1] = row3 - row0; // right
+    m_planes[2] = row3 + row1; // bottom
+    m_planes[3] = row3 - row1; // top
+    m_planes[4] = row3 + row2; // near
+    m_planes[5] = row3 - row2; // far
+
+    // Normalize so that the plane equation gives real distances
+    for(int i=0; i < 6; ++i){
+        float len = glm::length(glm::vec3(m_planes[i]));
+        if(len > 0.0f){
+            m_planes[i] /= len;
+        }
+    }
+    UpdatePadded();
+}
+
+// A sphere is outside if it is entirely behind any one plane
+bool Frustum::IsSphereVisible(const glm::vec3& center, float radius) const{
+    for(int i=0; i < 6; ++i){
+        if(glm::dot(glm::vec3(m_planes[i]), center) + m_planes[i].w < -radius){
+            return false;
+        }
+    }
+    return true;
+}
+
+// For each plane, the box's center is 'distance' in front of it and the
+// box reaches 'reach' towards it. All of the box is behind the plane if
+// distance + reach < 0, and all of it in front if distance - reach >= 0.
+Frustum::Containment Frustum::TestBox(const glm::vec3& center, const glm::vec3& extents) const{
+    bool intersecting = false;
+#ifdef FRUSTUM_SSE
+    const __m128 cx = _mm_set1_ps(center.x);
+    const __m128 cy = _mm_set1_ps(center.y);
+    const __m128 cz = _mm_set1_ps(center.z);
+    const __m128 ex = _mm_set1_ps(extents.x);
+    const __m128 ey = _mm_set1_ps(extents.y);
+    const __m128 ez = _mm_set1_ps(extents.z);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 signBit = _mm_set1_ps(-0.0f);
+    for(int i=0; i < kPaddedPlanes; i += 4){
+        const __m128 nx = _mm_load_ps(m_normalX + i);
+        const __m128 ny = _mm_load_ps(m_normalY + i);
+        const __m128 nz = _mm_load_ps(m_normalZ + i);
+        __m128 distance = _mm_add_ps(_mm_mul_ps(nx, cx), _mm_load_ps(m_distance + i));
+        distance = _mm_add_ps(distance, _mm_mul_ps(ny, cy));
+        distance = _mm_add_ps(distance, _mm_mul_ps(nz, cz));
+        __m128 reach = _mm_mul_ps(_mm_andnot_ps(signBit, nx), ex);
+        reach = _mm_add_ps(reach, _mm_mul_ps(_mm_andnot_ps(signBit, ny), ey));
+        reach = _mm_add_ps(reach, _mm_mul_ps(_mm_andnot_ps(signBit, nz), ez));
+        if(_mm_movemask_ps(_mm_cmplt_ps(_mm_add_ps(distance, reach), zero)) != 0){
+            return Containment::Outside;
+        }
+        if(_mm_movemask_ps(_mm_cmplt_ps(_mm_sub_ps(distance, reach), zero)) != 0){
+            intersecting = true;
+        }
+    }
+#else
+    for(int i=0; i < kPaddedPlanes; ++i){
+        float distance = m_normalX[i]*center.x + m_normalY[i]*center.y + m_normalZ[i]*center.z + m_distance[i];
+        float reach = std::fabs(m_normalX[i])*extents.x + std::fabs(m_normalY[i])*extents.y + std::fabs(m_normalZ[i])*extents.z;
+        if(distance + reach < 0.0f){
+            return Containment::Outside;
+        }
+        if(distance - reach < 0.0f){
+            intersecting = true;
+        }
+    }
+#endif
+    return intersecting ? Containment::Intersecting : Containment::Inside;
+}
+
+void Frustum::UpdatePadded(){
+    for(int i=0; i < kPaddedPlanes; ++i){
+        // A plane with no normal that is far in front of everything
+        glm::vec4 plane = i < 6 ? m_planes[i] : glm::vec4(0.0f, 0.0f, 0.0f, 1e30f);
+        m_normalX[i] = plane.x;
+        m_normalY[i] = plane.y;
+        m_normalZ[i] = plane.z;
+        m_distance[i] = plane.w;
+    }
+}
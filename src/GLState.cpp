@@ -0,0 +1,317 @@
+#include "GLState.hpp"
+
+#include <cstdio>
+
+namespace{
+    // Marks state we do not know, so the next call is always issued
+    const GLuint kUnknown = 0xffffffff;
+
+    // Texture units we keep track of. Higher units are never filtered.
+    const unsigned int kTextureUnits = 32;
+    // Buffer targets we keep track of. Other targets are never filtered.
+    const GLenum kBufferTargets[] = {GL_ARRAY_BUFFER, GL_ELEMENT_ARRAY_BUFFER, GL_COPY_READ_BUFFER,
+                                     GL_COPY_WRITE_BUFFER, GL_UNIFORM_BUFFER};
+    const int kBufferTargetCount = sizeof(kBufferTargets)/sizeof(kBufferTargets[0]);
+    const int kElementArrayTarget = 1;
+    const int kUniformTarget = 4;
+    // Uniform buffer binding points we keep track of
+    const GLuint kUniformBindings = 16;
+    // Capabilities we keep track of (filled in as they are used)
+    const int kCapabilityCount = 16;
+
+    const char* kCallNames[GLState::kCallCount] = {"programs", "vertex arrays", "buffers", "textures",
+                                                   "active texture", "framebuffers", "enable/disable",
+                                                   "viewport", "polygon mode"};
+
+    struct Capability{
+        GLenum capability;
+        GLuint enabled;
+    };
+
+    struct BufferRange{
+        GLuint buffer;
+        GLintptr offset;
+        GLsizeiptr size;
+    };
+
+    struct State{
+        GLuint program;
+        GLuint vertexArray;
+        GLuint buffers[kBufferTargetCount];
+        BufferRange uniformRanges[kUniformBindings];
+        GLuint activeTexture;
+        GLuint textures[kTextureUnits];
+        GLuint drawFramebuffer;
+        GLuint readFramebuffer;
+        Capability capabilities[kCapabilityCount];
+        int capabilityCount;
+        GLint viewport[4];
+        GLuint polygonMode;
+    };
+
+    State& GetState(){
+        static State s_state;
+        static bool s_initialized = false;
+        if(!s_initialized){
+            s_initialized = true;
+            GLState::Invalidate();
+        }
+        return s_state;
+    }
+
+    // Counters of the frame in progress, the last frame and all frames
+    GLState::Counters s_frame{};
+    GLState::Counters s_lastFrame{};
+    GLState::Counters s_total{};
+    unsigned int s_frames = 0;
+
+    // Returns true (and counts the call as issued) if 'current' differs
+    // from 'value', in which case 'current' becomes 'value'
+    bool Changes(GLuint& current, GLuint value, GLState::Call call){
+        if(current == value){
+            ++s_frame.filtered[call];
+            return false;
+        }
+        current = value;
+        ++s_frame.issued[call];
+        return true;
+    }
+
+    int GetBufferTarget(GLenum target){
+        for(int i=0; i < kBufferTargetCount; ++i){
+            if(kBufferTargets[i] == target){
+                return i;
+            }
+        }
+        return -1;
+    }
+
+    // Returns the slot for 'capability', adding it if there is room
+    Capability* GetCapability(GLenum capability){
+        State& state = GetState();
+        for(int i=0; i < state.capabilityCount; ++i){
+            if(state.capabilities[i].capability == capability){
+                return &state.capabilities[i];
+            }
+        }
+        if(state.capabilityCount == kCapabilityCount){
+            return nullptr;
+        }
+        Capability* slot = &state.capabilities[state.capabilityCount++];
+        slot->capability = capability;
+        slot->enabled = kUnknown;
+        return slot;
+    }
+
+    void SetCapability(GLenum capability, GLuint enabled){
+        Capability* slot = GetCapability(capability);
+        GLuint unknown = kUnknown;
+        if(Changes(slot != nullptr ? slot->enabled : unknown, enabled, GLState::Capability)){
+            if(enabled){
+                glEnable(capability);
+            }else{
+                glDisable(capability);
+            }
+        }
+    }
+
+    void Forget(GLuint& current, GLuint name){
+        if(current == name){
+            current = kUnknown;
+        }
+    }
+}
+
+// ============== Calls ==============
+
+void GLState::UseProgram(GLuint program){
+    if(Changes(GetState().program, program, Program)){
+        glUseProgram(program);
+    }
+}
+
+void GLState::BindVertexArray(GLuint vertexArray){
+    State& state = GetState();
+    if(Changes(state.vertexArray, vertexArray, VertexArray)){
+        glBindVertexArray(vertexArray);
+        state.buffers[kElementArrayTarget] = kUnknown;
+    }
+}
+
+void GLState::BindBuffer(GLenum target, GLuint buffer){
+    int index = GetBufferTarget(target);
+    GLuint unknown = kUnknown;
+    if(Changes(index >= 0 ? GetState().buffers[index] : unknown, buffer, Buffer)){
+        glBindBuffer(target, buffer);
+    }
+}
+
+void GLState::BindUniformBufferRange(GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size){
+    State& state = GetState();
+    if(index < kUniformBindings){
+        BufferRange& range = state.uniformRanges[index];
+        if(range.buffer == buffer && range.offset == offset && range.size == size){
+            ++s_frame.filtered[Buffer];
+            return;
+        }
+        range.buffer = buffer;
+        range.offset = offset;
+        range.size = size;
+    }
+    ++s_frame.issued[Buffer];
+    glBindBufferRange(GL_UNIFORM_BUFFER, index, buffer, offset, size);
+    state.buffers[kUniformTarget] = buffer;
+}
+
+void GLState::BindTexture(unsigned int unit, GLenum target, GLuint texture){
+    State& state = GetState();
+    if(Changes(state.activeTexture, unit, ActiveTexture)){
+        glActiveTexture(GL_TEXTURE0 + unit);
+    }
+    GLuint unknown = kUnknown;
+    bool tracked = unit < kTextureUnits && target == GL_TEXTURE_2D;
+    if(Changes(tracked ? state.textures[unit] : unknown, texture, Texture)){
+        glBindTexture(target, texture);
+    }
+}
+
+void GLState::BindFramebuffer(GLenum target, GLuint framebuffer){
+    State& state = GetState();
+    if(target == GL_FRAMEBUFFER){
+        if(state.drawFramebuffer == framebuffer && state.readFramebuffer == framebuffer){
+            ++s_frame.filtered[Framebuffer];
+            return;
+        }
+        state.drawFramebuffer = framebuffer;
+        state.readFramebuffer = framebuffer;
+        ++s_frame.issued[Framebuffer];
+        glBindFramebuffer(target, framebuffer);
+        return;
+    }
+    if(Changes(target == GL_DRAW_FRAMEBUFFER ? state.drawFramebuffer : state.readFramebuffer, framebuffer, Framebuffer)){
+        glBindFramebuffer(target, framebuffer);
+    }
+}
+
+void GLState::Enable(GLenum capability){
+    SetCapability(capability, 1);
+}
+
+void GLState::Disable(GLenum capability){
+    SetCapability(capability, 0);
+}
+
+void GLState::SetViewport(GLint x, GLint y, GLsizei width, GLsizei height){
+    GLint* viewport = GetState().viewport;
+    if(viewport[0] == x && viewport[1] == y && viewport[2] == width && viewport[3] == height){
+        ++s_frame.filtered[Viewport];
+        return;
+    }
+    viewport[0] = x;
+    viewport[1] = y;
+    viewport[2] = width;
+    viewport[3] = height;
+    ++s_frame.issued[Viewport];
+    glViewport(x, y, width, height);
+}
+
+void GLState::SetPolygonMode(GLenum mode){
+    if(Changes(GetState().polygonMode, mode, PolygonMode)){
+        glPolygonMode(GL_FRONT_AND_BACK, mode);
+    }
+}
+
+// ============== Deleted objects ==============
+
+void GLState::ForgetBuffer(GLuint buffer){
+    State& state = GetState();
+    for(int i=0; i < kBufferTargetCount; ++i){
+        Forget(state.buffers[i], buffer);
+    }
+    for(GLuint i=0; i < kUniformBindings; ++i){
+        Forget(state.uniformRanges[i].buffer, buffer);
+    }
+}
+
+void GLState::ForgetTexture(GLuint texture){
+    State& state = GetState();
+    for(unsigned int i=0; i < kTextureUnits; ++i){
+        Forget(state.textures[i], texture);
+    }
+}
+
+void GLState::ForgetVertexArray(GLuint vertexArray){
+    State& state = GetState();
+    if(state.vertexArray == vertexArray){
+        state.vertexArray = kUnknown;
+        state.buffers[kElementArrayTarget] = kUnknown;
+    }
+}
+
+void GLState::ForgetFramebuffer(GLuint framebuffer){
+    State& state = GetState();
+    Forget(state.drawFramebuffer, framebuffer);
+    Forget(state.readFramebuffer, framebuffer);
+}
+
+void GLState::ForgetProgram(GLuint program){
+    Forget(GetState().program, program);
+}
+
+void GLState::Invalidate(){
+    State& state = GetState();
+    state.program = kUnknown;
+    state.vertexArray = kUnknown;
+    for(int i=0; i < kBufferTargetCount; ++i){
+        state.buffers[i] = kUnknown;
+    }
+    for(GLuint i=0; i < kUniformBindings; ++i){
+        state.uniformRanges[i].buffer = kUnknown;
+    }
+    state.activeTexture = kUnknown;
+    for(unsigned int i=0; i < kTextureUnits; ++i){
+        state.textures[i] = kUnknown;
+    }
+    state.drawFramebuffer = kUnknown;
+    state.readFramebuffer = kUnknown;
+    for(int i=0; i < state.capabilityCount; ++i){
+        state.capabilities[i].enabled = kUnknown;
+    }
+    // A zero sized viewport is never set on purpose
+    for(int i=0; i < 4; ++i){
+        state.viewport[i] = 0;
+    }
+    state.polygonMode = kUnknown;
+}
+
+// ============== Counters ==============
+
+void GLState::EndFrame(){
+    for(int i=0; i < kCallCount; ++i){
+        s_total.issued[i] += s_frame.issued[i];
+        s_total.filtered[i] += s_frame.filtered[i];
+    }
+    ++s_frames;
+    s_lastFrame = s_frame;
+    s_frame = Counters();
+}
+
+const GLState::Counters& GLState::GetLastFrame(){
+    return s_lastFrame;
+}
+
+void GLState::PrintStats(){
+    unsigned int frames = s_frames > 0 ? s_frames : 1;
+    unsigned int issued = 0;
+    unsigned int filtered = 0;
+    std::printf("(GLState.cpp) State changes over %u frames (last frame, then average per frame):\n", s_frames);
+    for(int i=0; i < kCallCount; ++i){
+        std::printf("    %-15s issued %5u (%8.1f)  filtered %5u (%8.1f)\n", kCallNames[i],
+                    s_lastFrame.issued[i], (double)s_total.issued[i]/frames,
+                    s_lastFrame.filtered[i], (double)s_total.filtered[i]/frames);
+        issued += s_lastFrame.issued[i];
+        filtered += s_lastFrame.filtered[i];
+    }
+    double saved = issued + filtered > 0 ? 100.0*filtered/(issued + filtered) : 0.0;
+    std::printf("    last frame: %u calls issued, %u filtered (%.1f%% saved)\n", issued, filtered, saved);
+}
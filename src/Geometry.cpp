@@ -1,9 +1,56 @@
 #include "Geometry.hpp"
 #include <assert.h>
 #include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
 #include "glm/vec3.hpp"
 #include "glm/vec2.hpp"
 #include "glm/glm.hpp"
+#include "Parallel.hpp"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+
+// SSE helpers used when orthonormalizing four vertices at a time.
+namespace{
+	// Loads four packed x,y,z vectors (12 floats) and transposes them
+	// so that x, y and z each hold one component of all four vectors.
+	inline void LoadSoA(const float* p, __m128& x, __m128& y, __m128& z){
+		__m128 a = _mm_loadu_ps(p+0); // x0 y0 z0 x1
+		__m128 b = _mm_loadu_ps(p+4); // y1 z1 x2 y2
+		__m128 c = _mm_loadu_ps(p+8); // z2 x3 y3 z3
+		__m128 bc = _mm_shuffle_ps(b, c, _MM_SHUFFLE(1,0,3,2));
+		x = _mm_shuffle_ps(a, bc, _MM_SHUFFLE(3,0,3,0));
+		y = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(0,0,1,1)),
+		                   _mm_shuffle_ps(b, c, _MM_SHUFFLE(2,2,3,3)), _MM_SHUFFLE(2,0,2,0));
+		z = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(1,1,2,2)),
+		                   _mm_shuffle_ps(c, c, _MM_SHUFFLE(3,3,0,0)), _MM_SHUFFLE(2,0,2,0));
+	}
+
+	// The inverse of LoadSoA
+	inline void StoreSoA(float* p, __m128 x, __m128 y, __m128 z){
+		__m128 a = _mm_shuffle_ps(_mm_shuffle_ps(x, y, _MM_SHUFFLE(0,0,0,0)),
+		                          _mm_shuffle_ps(z, x, _MM_SHUFFLE(1,1,0,0)), _MM_SHUFFLE(2,0,2,0));
+		__m128 b = _mm_shuffle_ps(_mm_shuffle_ps(y, z, _MM_SHUFFLE(1,1,1,1)),
+		                          _mm_shuffle_ps(x, y, _MM_SHUFFLE(2,2,2,2)), _MM_SHUFFLE(2,0,2,0));
+		__m128 c = _mm_shuffle_ps(_mm_shuffle_ps(z, x, _MM_SHUFFLE(3,3,2,2)),
+		                          _mm_shuffle_ps(y, z, _MM_SHUFFLE(3,3,3,3)), _MM_SHUFFLE(2,0,2,0));
+		_mm_storeu_ps(p+0, a);
+		_mm_storeu_ps(p+4, b);
+		_mm_storeu_ps(p+8, c);
+	}
+
+	inline __m128 Dot3(__m128 ax, __m128 ay, __m128 az, __m128 bx, __m128 by, __m128 bz){
+		return _mm_add_ps(_mm_add_ps(_mm_mul_ps(ax, bx), _mm_mul_ps(ay, by)), _mm_mul_ps(az, bz));
+	}
+
+	// Per lane: mask ? a : b
+	inline __m128 Select(__m128 mask, __m128 a, __m128 b){
+		return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+	}
+}
+#endif
 
 // Constructor
 Geometry::Geometry(){
@@ -16,6 +63,16 @@ Geometry::~Geometry(){
 }
 
 
+// Reserves memory in every vertex attribute and the index list
+void Geometry::Reserve(unsigned int vertexCount, unsigned int indexCount){
+	m_vertexPositions.reserve(vertexCount*3);
+	m_textureCoords.reserve(vertexCount*2);
+	m_normals.reserve(vertexCount*3);
+	m_tangents.reserve(vertexCount*3);
+	m_biTangents.reserve(vertexCount*3);
+	m_indices.reserve(indexCount);
+}
+
 // Adds a vertex and associated texture coordinate.
 // Will also add a and a normal
 void Geometry::AddVertex(float x, float y, float z, float s, float t){
@@ -73,6 +130,27 @@ unsigned int Geometry::GetBufferSizeInBytes(){
 void Geometry::Gen(){
 	assert((m_vertexPositions.size()/3) == (m_textureCoords.size()/2));
 
+	// Smooth normals and tangent space for the whole mesh
+	ComputeTangentSpace();
+	// The box first, then the sphere around its center that reaches
+	// the farthest vertex (tighter than the one around the box)
+	m_bounds = Bounds();
+	for(size_t i=0; i < m_vertexPositions.size(); i += 3){
+		m_bounds.Add(glm::vec3(m_vertexPositions[i], m_vertexPositions[i+1], m_vertexPositions[i+2]));
+	}
+	m_bounds.UpdateSphere();
+	float farthest = 0.0f;
+	for(size_t i=0; i < m_vertexPositions.size(); i += 3){
+		glm::vec3 offset = glm::vec3(m_vertexPositions[i], m_vertexPositions[i+1], m_vertexPositions[i+2]) - m_bounds.center;
+		farthest = std::max(farthest, glm::dot(offset, offset));
+	}
+	if(!m_bounds.IsEmpty()){
+		m_bounds.radius = std::sqrt(farthest);
+	}
+	// Calling Gen again should rebuild rather than append
+	m_bufferData.clear();
+	m_bufferData.reserve((m_vertexPositions.size()/3)*14);
+
 	int coordsPos =0;
 	for(int i =0; i < m_vertexPositions.size()/3; ++i){
 	// First vertex
@@ -102,68 +180,467 @@ void Geometry::Gen(){
 	}
 }
 
-// The big trick here, is that when we make a triangle
-// We also need to update our m_normals, tangents, and bi-tangents.
+// Records the three indices of a triangle.
+// Normals, tangents and bi-tangents depend on every triangle that
+// touches a vertex, so they are computed for the whole mesh at once
+// in ComputeTangentSpace rather than one triangle at a time here.
 void Geometry::MakeTriangle(unsigned int vert0, unsigned int vert1, unsigned int vert2){
 	m_indices.push_back(vert0);	
 	m_indices.push_back(vert1);	
 	m_indices.push_back(vert2);	
+}
+
+// Helpers for ComputeTangentSpace
+namespace{
+	// Smallest length we treat as a valid direction
+	const float kEpsilon = 1e-12f;
+
+	// Reads element i from a tightly packed x,y,z array
+	inline glm::vec3 LoadVec3(const std::vector<float>& data, unsigned int i){
+		return glm::vec3(data[i*3+0], data[i*3+1], data[i*3+2]);
+	}
+
+	// Writes element i into a tightly packed x,y,z array
+	inline void StoreVec3(std::vector<float>& data, unsigned int i, const glm::vec3& v){
+		data[i*3+0] = v.x; data[i*3+1] = v.y; data[i*3+2] = v.z;
+	}
+
+	// The angle between two edges leaving the same corner
+	inline float CornerAngle(const glm::vec3& edge0, const glm::vec3& edge1){
+		float len = glm::length(edge0) * glm::length(edge1);
+		if(len <= kEpsilon){
+			return 0.0f;
+		}
+		return glm::acos(glm::clamp(glm::dot(edge0, edge1) / len, -1.0f, 1.0f));
+	}
+
+	// Scalar version of the final per-vertex orthonormalization.
+	// Used for the last few vertices and when SSE is not available.
+	inline void OrthonormalizeVertex(glm::vec3& n, glm::vec3& t, glm::vec3& b){
+		float nLen = glm::length(n);
+		n = nLen > kEpsilon ? n / nLen : glm::vec3(0.0f, 0.0f, 1.0f);
+		// Gram-Schmidt: remove the part of the tangent along the normal
+		t = t - n * glm::dot(n, t);
+		float tLen = glm::length(t);
+		if(tLen > kEpsilon){
+			t = t / tLen;
+		}else{
+			// No usable texture coordinates, pick any perpendicular direction
+			t = glm::abs(n.x) < 0.9f ? glm::vec3(0.0f, n.z, -n.y) : glm::vec3(-n.z, 0.0f, n.x);
+			t = glm::normalize(t);
+		}
+		// The bi-tangent only keeps its handedness (MikkTSpace sign)
+		glm::vec3 c = glm::cross(n, t);
+		b = glm::dot(c, b) < 0.0f ? -c : c;
+	}
+}
+
+// Computes smooth normals, tangents and bi-tangents for the whole mesh.
+//
+// The mesh is processed from the point of view of each vertex: we first
+// build a list of the triangle corners that touch every vertex, then each
+// vertex gathers the contribution of its own corners. Because no two
+// threads ever write to the same vertex the passes need no locking, and
+// the result is the same no matter how many threads are used.
+//
+// (1) Normals are the face normals of the surrounding triangles weighted
+//     by the corner angle (or triangle area).
+// (2) Tangents and bi-tangents come from the texture coordinate derivatives
+//     of each triangle, projected into the plane of the vertex normal,
+//     normalized and angle weighted (as MikkTSpace does).
+// (3) Finally every vertex is orthonormalized, four at a time with SSE.
+//
+// NOTE: MikkTSpace also splits vertices that sit on a UV mirror seam.
+//       We never create new vertices here, so vertices shared across a
+//       seam get the averaged frame.
+void Geometry::ComputeTangentSpace(NormalWeighting weighting){
+	const unsigned int vertexCount = m_vertexPositions.size()/3;
+	const unsigned int cornerCount = (m_indices.size()/3)*3;
+	if(vertexCount == 0 || cornerCount == 0){
+		return;
+	}
+	assert(m_textureCoords.size()/2 == vertexCount);
+
+	// (0) Build the vertex -> corner lists.
+	// cornerStart[v] .. cornerStart[v+1] are the corners that use vertex v.
+	std::vector<unsigned int> cornerStart(vertexCount+1, 0);
+	for(unsigned int i=0; i < cornerCount; ++i){
+		if(m_indices[i] < vertexCount){
+			++cornerStart[m_indices[i]+1];
+		}
+	}
+	for(unsigned int v=0; v < vertexCount; ++v){
+		cornerStart[v+1] += cornerStart[v];
+	}
+	std::vector<unsigned int> corners(cornerStart[vertexCount]);
+	{
+		std::vector<unsigned int> cursor(cornerStart.begin(), cornerStart.end()-1);
+		for(unsigned int i=0; i < cornerCount; ++i){
+			if(m_indices[i] < vertexCount){
+				corners[cursor[m_indices[i]]++] = i;
+			}
+		}
+	}
 
-	// Look up the actual vertex positions
-	glm::vec3 pos0(m_vertexPositions[vert0*3 +0], m_vertexPositions[vert0*3 + 1], m_vertexPositions[vert0*3 + 2]); 
-	glm::vec3 pos1(m_vertexPositions[vert1*3 +0], m_vertexPositions[vert1*3 + 1], m_vertexPositions[vert1*3 + 2]); 
-	glm::vec3 pos2(m_vertexPositions[vert2*3 +0], m_vertexPositions[vert2*3 + 1], m_vertexPositions[vert2*3 + 2]); 
+	// Looks up the three vertices of a corner's triangle, starting at the
+	// corner itself so that the winding (and therefore the normal) is kept.
+	auto cornerVertices = [&](unsigned int corner, unsigned int out[3]) -> bool{
+		unsigned int first = corner - corner%3;
+		for(unsigned int k=0; k < 3; ++k){
+			out[k] = m_indices[first + (corner%3 + k)%3];
+			if(out[k] >= vertexCount){
+				return false;
+			}
+		}
+		return true;
+	};
 
-	// Look up the texture coordinates
-	glm::vec2 tex0(m_textureCoords[vert0*2 +0], m_textureCoords[vert0*2 + 1]); 
-	glm::vec2 tex1(m_textureCoords[vert1*2 +0], m_textureCoords[vert1*2 + 1]); 
-	glm::vec2 tex2(m_textureCoords[vert2*2 +0], m_textureCoords[vert2*2 + 1]); 
+	const unsigned int grain = 4096;
+	// The angle at every corner is needed by both passes, so the first
+	// pass stores it. Each corner belongs to exactly one vertex, which
+	// means only one thread ever writes a given entry.
+	std::vector<float> cornerAngles(cornerCount, 0.0f);
 
-	// Now create an edge
-	// With two edges
+	// (1) Accumulate the normals
+	ParallelFor(vertexCount, grain, [&](unsigned int begin, unsigned int end){
+		for(unsigned int v=begin; v < end; ++v){
+			glm::vec3 normal(0.0f);
+			for(unsigned int c=cornerStart[v]; c < cornerStart[v+1]; ++c){
+				unsigned int vert[3];
+				if(!cornerVertices(corners[c], vert)){
+					continue;
+				}
+				glm::vec3 p0 = LoadVec3(m_vertexPositions, vert[0]);
+				glm::vec3 edge0 = LoadVec3(m_vertexPositions, vert[1]) - p0;
+				glm::vec3 edge1 = LoadVec3(m_vertexPositions, vert[2]) - p0;
+				// The length of the cross product is twice the triangle area.
+				glm::vec3 faceNormal = glm::cross(edge0, edge1);
+				float angle = CornerAngle(edge0, edge1);
+				cornerAngles[corners[c]] = angle;
+				if(weighting == NormalWeighting::Area){
+					normal += faceNormal;
+				}else{
+					// Skip slivers: their normal is mostly rounding error, yet
+					// the corner angle can be large enough to swamp the others.
+					float len = glm::length(faceNormal);
+					if(len > kEpsilon && len > 1e-6f * glm::length(edge0) * glm::length(edge1)){
+						normal += (faceNormal / len) * angle;
+					}
+				}
+			}
+			StoreVec3(m_normals, v, normal);
+		}
+	});
+
+	// (2) Accumulate the tangents and bi-tangents
 	// This section is inspired by: https://learnopengl.com/Advanced-Lighting/Normal-Mapping
-	glm::vec3 edge0 = pos1 - pos0;
-	glm::vec3 edge1 = pos2 - pos0;
-	// Question to ask yourself is what is going on here?
-    // The difference of y's and x's? Hmm.
-	glm::vec2 deltaUV0 = tex1-tex0;
-	glm::vec2 deltaUV1 = tex2-tex0;
-
-	float f = 1.0f / (deltaUV0.x * deltaUV1.y - deltaUV1.x * deltaUV0.y);
-
-	glm::vec3 tangent;
-	glm::vec3 bitangent;
-
-	tangent.x = f * (deltaUV1.y * edge0.x - deltaUV0.y* edge1.x);
-	tangent.y = f * (deltaUV1.y * edge0.y - deltaUV0.y* edge1.y);
-	tangent.z = f * (deltaUV1.y * edge0.z - deltaUV0.y* edge1.z);
-	tangent = glm::normalize(tangent);
-
-	bitangent.x = f * (-deltaUV1.x * edge0.x + deltaUV0.x* edge1.x);
-	bitangent.y = f * (-deltaUV1.x * edge0.y + deltaUV0.x* edge1.y);
-	bitangent.z = f * (-deltaUV1.x * edge0.z + deltaUV0.x* edge1.z);
-	bitangent = glm::normalize(bitangent);
-	
-	// Compute a normal
-	// For now we sort of 'cheat' since this is a quad the 'z' axis points straight out
-    glm::vec3 normal1{m_normals[vert0*3+0] ,m_normals[vert0*3+1], m_normals[vert0*3+2]};
-    glm::vec3 normal2{m_normals[vert1*3+0] ,m_normals[vert1*3+1], m_normals[vert1*3+2]};
-    glm::vec3 normal3{m_normals[vert2*3+0] ,m_normals[vert2*3+1], m_normals[vert2*3+2]};
-
-
-	m_normals[vert0*3+0] = 0.0f;	m_normals[vert0*3+1] = 0.0f;	m_normals[vert0*3+2] = 1.0f;	
-	m_normals[vert1*3+0] = 0.0f;	m_normals[vert1*3+1] = 0.0f;	m_normals[vert1*3+2] = 1.0f;	
-	m_normals[vert2*3+0] = 0.0f;	m_normals[vert2*3+1] = 0.0f;	m_normals[vert2*3+2] = 1.0f;	
-		
-	// Compute a tangent
-	m_tangents[vert0*3+0] = tangent.x; m_tangents[vert0*3+1] = tangent.y; m_tangents[vert0*3+2] = tangent.z;	
-	m_tangents[vert1*3+0] = tangent.x; m_tangents[vert1*3+1] = tangent.y; m_tangents[vert1*3+2] = tangent.z;	
-	m_tangents[vert2*3+0] = tangent.x; m_tangents[vert2*3+1] = tangent.y; m_tangents[vert2*3+2] = tangent.z;	
-
-	// Compute a bi-tangent
-	m_biTangents[vert0*3+0] = bitangent.x; m_biTangents[vert0*3+1] = bitangent.y; m_biTangents[vert0*3+2] = bitangent.z;	
-	m_biTangents[vert1*3+0] = bitangent.x; m_biTangents[vert1*3+1] = bitangent.y; m_biTangents[vert1*3+2] = bitangent.z;	
-	m_biTangents[vert2*3+0] = bitangent.x; m_biTangents[vert2*3+1] = bitangent.y; m_biTangents[vert2*3+2] = bitangent.z;	
+	ParallelFor(vertexCount, grain, [&](unsigned int begin, unsigned int end){
+		for(unsigned int v=begin; v < end; ++v){
+			glm::vec3 n = LoadVec3(m_normals, v);
+			float nLen = glm::length(n);
+			n = nLen > kEpsilon ? n / nLen : glm::vec3(0.0f, 0.0f, 1.0f);
+
+			glm::vec3 tangent(0.0f);
+			glm::vec3 bitangent(0.0f);
+			for(unsigned int c=cornerStart[v]; c < cornerStart[v+1]; ++c){
+				unsigned int vert[3];
+				if(!cornerVertices(corners[c], vert)){
+					continue;
+				}
+				glm::vec3 p0 = LoadVec3(m_vertexPositions, vert[0]);
+				glm::vec3 edge0 = LoadVec3(m_vertexPositions, vert[1]) - p0;
+				glm::vec3 edge1 = LoadVec3(m_vertexPositions, vert[2]) - p0;
+
+				glm::vec2 tex0(m_textureCoords[vert[0]*2+0], m_textureCoords[vert[0]*2+1]);
+				glm::vec2 deltaUV0 = glm::vec2(m_textureCoords[vert[1]*2+0], m_textureCoords[vert[1]*2+1]) - tex0;
+				glm::vec2 deltaUV1 = glm::vec2(m_textureCoords[vert[2]*2+0], m_textureCoords[vert[2]*2+1]) - tex0;
+
+				float det = deltaUV0.x * deltaUV1.y - deltaUV1.x * deltaUV0.y;
+				if(glm::abs(det) <= kEpsilon){
+					// Degenerate texture coordinates carry no tangent information
+					continue;
+				}
+				float f = 1.0f / det;
+				glm::vec3 faceTangent   = f * (deltaUV1.y * edge0 - deltaUV0.y * edge1);
+				glm::vec3 faceBitangent = f * (-deltaUV1.x * edge0 + deltaUV0.x * edge1);
+
+				float angle = cornerAngles[corners[c]];
+				// Project into the plane of the vertex normal before averaging
+				glm::vec3 t = faceTangent - n * glm::dot(n, faceTangent);
+				glm::vec3 b = faceBitangent - n * glm::dot(n, faceBitangent);
+				float tLen = glm::length(t);
+				float bLen = glm::length(b);
+				if(tLen > kEpsilon){
+					tangent += (t / tLen) * angle;
+				}
+				if(bLen > kEpsilon){
+					bitangent += (b / bLen) * angle;
+				}
+			}
+			StoreVec3(m_tangents, v, tangent);
+			StoreVec3(m_biTangents, v, bitangent);
+		}
+	});
+
+	// (3) Orthonormalize every vertex
+	const unsigned int groups = vertexCount / 4;
+	ParallelFor(groups, grain/4, [&](unsigned int begin, unsigned int end){
+#if defined(__SSE2__)
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 one = _mm_set1_ps(1.0f);
+		const __m128 eps = _mm_set1_ps(kEpsilon);
+		const __m128 signMask = _mm_set1_ps(-0.0f);
+		for(unsigned int g=begin; g < end; ++g){
+			float* nPtr = &m_normals[g*12];
+			float* tPtr = &m_tangents[g*12];
+			float* bPtr = &m_biTangents[g*12];
+			__m128 nx,ny,nz, tx,ty,tz, bx,by,bz;
+			LoadSoA(nPtr, nx, ny, nz);
+			LoadSoA(tPtr, tx, ty, tz);
+			LoadSoA(bPtr, bx, by, bz);
+
+			// Normalize the normal, falling back to +z
+			__m128 len2 = Dot3(nx,ny,nz, nx,ny,nz);
+			__m128 valid = _mm_cmpgt_ps(len2, eps);
+			__m128 inv = _mm_div_ps(one, _mm_sqrt_ps(_mm_max_ps(len2, eps)));
+			nx = Select(valid, _mm_mul_ps(nx, inv), zero);
+			ny = Select(valid, _mm_mul_ps(ny, inv), zero);
+			nz = Select(valid, _mm_mul_ps(nz, inv), one);
+
+			// Gram-Schmidt the tangent against the normal
+			__m128 d = Dot3(nx,ny,nz, tx,ty,tz);
+			tx = _mm_sub_ps(tx, _mm_mul_ps(nx, d));
+			ty = _mm_sub_ps(ty, _mm_mul_ps(ny, d));
+			tz = _mm_sub_ps(tz, _mm_mul_ps(nz, d));
+			// If nothing is left, use any perpendicular direction
+			// cross(n,x) = (0,nz,-ny) or cross(n,y) = (-nz,0,nx)
+			__m128 useX = _mm_cmplt_ps(_mm_andnot_ps(signMask, nx), _mm_set1_ps(0.9f));
+			__m128 fx = Select(useX, zero, _mm_xor_ps(nz, signMask));
+			__m128 fy = Select(useX, nz, zero);
+			__m128 fz = Select(useX, _mm_xor_ps(ny, signMask), nx);
+			len2 = Dot3(tx,ty,tz, tx,ty,tz);
+			valid = _mm_cmpgt_ps(len2, eps);
+			tx = Select(valid, tx, fx);
+			ty = Select(valid, ty, fy);
+			tz = Select(valid, tz, fz);
+			len2 = Dot3(tx,ty,tz, tx,ty,tz);
+			inv = _mm_div_ps(one, _mm_sqrt_ps(_mm_max_ps(len2, eps)));
+			tx = _mm_mul_ps(tx, inv);
+			ty = _mm_mul_ps(ty, inv);
+			tz = _mm_mul_ps(tz, inv);
+
+			// Rebuild the bi-tangent keeping only its handedness
+			__m128 cx = _mm_sub_ps(_mm_mul_ps(ny, tz), _mm_mul_ps(nz, ty));
+			__m128 cy = _mm_sub_ps(_mm_mul_ps(nz, tx), _mm_mul_ps(nx, tz));
+			__m128 cz = _mm_sub_ps(_mm_mul_ps(nx, ty), _mm_mul_ps(ny, tx));
+			__m128 flip = _mm_and_ps(_mm_cmplt_ps(Dot3(cx,cy,cz, bx,by,bz), zero), signMask);
+			bx = _mm_xor_ps(cx, flip);
+			by = _mm_xor_ps(cy, flip);
+			bz = _mm_xor_ps(cz, flip);
+
+			StoreSoA(nPtr, nx, ny, nz);
+			StoreSoA(tPtr, tx, ty, tz);
+			StoreSoA(bPtr, bx, by, bz);
+		}
+#else
+		for(unsigned int v=begin*4; v < end*4; ++v){
+			glm::vec3 n = LoadVec3(m_normals, v);
+			glm::vec3 t = LoadVec3(m_tangents, v);
+			glm::vec3 b = LoadVec3(m_biTangents, v);
+			OrthonormalizeVertex(n, t, b);
+			StoreVec3(m_normals, v, n);
+			StoreVec3(m_tangents, v, t);
+			StoreVec3(m_biTangents, v, b);
+		}
+#endif
+	});
+	// Left over vertices that did not fill a group of four
+	for(unsigned int v=groups*4; v < vertexCount; ++v){
+		glm::vec3 n = LoadVec3(m_normals, v);
+		glm::vec3 t = LoadVec3(m_tangents, v);
+		glm::vec3 b = LoadVec3(m_biTangents, v);
+		OrthonormalizeVertex(n, t, b);
+		StoreVec3(m_normals, v, n);
+		StoreVec3(m_tangents, v, t);
+		StoreVec3(m_biTangents, v, b);
+	}
+}
+
+// Spreads the lower 10 bits of v out so there are two zero bits
+// between each of them (used to build Morton codes).
+static uint32_t SpreadBits(uint32_t v){
+	v &= 0x3ff;
+	v = (v | (v << 16)) & 0x030000ff;
+	v = (v | (v <<  8)) & 0x0300f00f;
+	v = (v | (v <<  4)) & 0x030c30c3;
+	v = (v | (v <<  2)) & 0x09249249;
+	return v;
+}
+
+// Splits the mesh into meshlets.
+//
+// (1) Triangles are sorted along a Morton (Z-order) curve through their
+//     centers, which keeps triangles that are close in space close in the list.
+// (2) We then walk the sorted list and start a new meshlet whenever adding
+//     the next triangle would go over the vertex or triangle limit.
+// (3) Each meshlet gets a bounding sphere and a cone around its face
+//     normals, which is what the culling in Object uses.
+void Geometry::BuildMeshlets(unsigned int maxVertices, unsigned int maxTriangles){
+	m_meshlets.clear();
+	const unsigned int vertexCount = m_vertexPositions.size()/3;
+	const unsigned int triangleCount = m_indices.size()/3;
+	if(triangleCount == 0 || maxTriangles == 0 || maxVertices < 3){
+		return;
+	}
+
+	// (1) Sort triangles by the Morton code of their center
+	std::vector<glm::vec3> centers(triangleCount);
+	glm::vec3 minCenter(INFINITY), maxCenter(-INFINITY);
+	for(unsigned int t=0; t < triangleCount; ++t){
+		glm::vec3 center(0.0f);
+		for(unsigned int k=0; k < 3; ++k){
+			unsigned int v = std::min(m_indices[t*3+k], vertexCount-1);
+			center += LoadVec3(m_vertexPositions, v);
+		}
+		centers[t] = center / 3.0f;
+		minCenter = glm::min(minCenter, centers[t]);
+		maxCenter = glm::max(maxCenter, centers[t]);
+	}
+	// Use the same scale on every axis so a flat mesh is not stretched
+	glm::vec3 size = maxCenter - minCenter;
+	float extent = std::max(std::max(size.x, size.y), std::max(size.z, 1e-6f));
+	std::vector<uint64_t> order(triangleCount);
+	for(unsigned int t=0; t < triangleCount; ++t){
+		glm::vec3 n = (centers[t] - minCenter) / extent * 1023.0f;
+		uint32_t code = SpreadBits((uint32_t)n.x) | (SpreadBits((uint32_t)n.y) << 1) | (SpreadBits((uint32_t)n.z) << 2);
+		// Code in the high bits, triangle in the low bits, so one sort does both
+		order[t] = ((uint64_t)code << 32) | t;
+	}
+	std::sort(order.begin(), order.end());
+
+	// (2) Greedily fill meshlets in Morton order
+	std::vector<unsigned int> sortedIndices;
+	sortedIndices.reserve(triangleCount*3);
+	// Which meshlet last used each vertex, so we can count unique vertices
+	std::vector<unsigned int> lastMeshlet(vertexCount, ~0u);
+	unsigned int meshletVertices = 0;
+	unsigned int meshletStart = 0;
+
+	auto finishMeshlet = [&](){
+		Meshlet meshlet;
+		meshlet.indexOffset = meshletStart;
+		meshlet.indexCount = sortedIndices.size() - meshletStart;
+
+		// (3a) Bounding sphere around the center of the bounding box
+		glm::vec3 boxMin(INFINITY), boxMax(-INFINITY);
+		for(unsigned int i=meshletStart; i < sortedIndices.size(); ++i){
+			glm::vec3 p = LoadVec3(m_vertexPositions, sortedIndices[i]);
+			boxMin = glm::min(boxMin, p);
+			boxMax = glm::max(boxMax, p);
+		}
+		glm::vec3 center = (boxMin + boxMax) * 0.5f;
+		float radius = 0.0f;
+		for(unsigned int i=meshletStart; i < sortedIndices.size(); ++i){
+			radius = std::max(radius, glm::length(LoadVec3(m_vertexPositions, sortedIndices[i]) - center));
+		}
+
+		// (3b) Normal cone: average the face normals and find the widest one
+		std::vector<glm::vec3> faceNormals;
+		faceNormals.reserve(meshlet.indexCount/3);
+		glm::vec3 axis(0.0f);
+		for(unsigned int i=meshletStart; i < sortedIndices.size(); i+=3){
+			glm::vec3 p0 = LoadVec3(m_vertexPositions, sortedIndices[i+0]);
+			glm::vec3 n = glm::cross(LoadVec3(m_vertexPositions, sortedIndices[i+1]) - p0,
+			                         LoadVec3(m_vertexPositions, sortedIndices[i+2]) - p0);
+			float len = glm::length(n);
+			if(len > kEpsilon){
+				faceNormals.push_back(n / len);
+				axis += n / len;
+			}
+		}
+		float axisLen = glm::length(axis);
+		float cutoff = 1.0f;
+		if(axisLen > kEpsilon){
+			axis /= axisLen;
+			float minDot = 1.0f;
+			for(unsigned int i=0; i < faceNormals.size(); ++i){
+				minDot = std::min(minDot, glm::dot(faceNormals[i], axis));
+			}
+			// A cone wider than ~84 degrees can never cull anything useful
+			if(minDot > 0.1f){
+				cutoff = std::sqrt(1.0f - minDot*minDot);
+			}
+		}else{
+			axis = glm::vec3(0.0f, 0.0f, 1.0f);
+		}
+
+		for(int k=0; k < 3; ++k){
+			meshlet.center[k] = center[k];
+			meshlet.coneAxis[k] = axis[k];
+		}
+		meshlet.radius = radius;
+		meshlet.coneCutoff = cutoff;
+		m_meshlets.push_back(meshlet);
+
+		meshletStart = sortedIndices.size();
+		meshletVertices = 0;
+	};
+
+	for(unsigned int i=0; i < triangleCount; ++i){
+		unsigned int t = (unsigned int)(order[i] & 0xffffffffu);
+		unsigned int vert[3];
+		unsigned int newVertices = 0;
+		bool valid = true;
+		for(unsigned int k=0; k < 3; ++k){
+			vert[k] = m_indices[t*3+k];
+			valid = valid && vert[k] < vertexCount;
+		}
+		if(!valid){
+			continue;
+		}
+		unsigned int meshletId = m_meshlets.size();
+		for(unsigned int k=0; k < 3; ++k){
+			// Count each vertex once, even if it appears twice in the triangle
+			bool seen = lastMeshlet[vert[k]] == meshletId;
+			for(unsigned int j=0; j < k; ++j){
+				seen = seen || vert[j] == vert[k];
+			}
+			newVertices += seen ? 0 : 1;
+		}
+		unsigned int meshletTriangles = (sortedIndices.size() - meshletStart)/3;
+		if(meshletTriangles > 0 && (meshletVertices + newVertices > maxVertices || meshletTriangles + 1 > maxTriangles)){
+			finishMeshlet();
+			meshletId = m_meshlets.size();
+			newVertices = 0;
+			for(unsigned int k=0; k < 3; ++k){
+				bool seen = false;
+				for(unsigned int j=0; j < k; ++j){
+					seen = seen || vert[j] == vert[k];
+				}
+				newVertices += seen ? 0 : 1;
+			}
+		}
+		for(unsigned int k=0; k < 3; ++k){
+			lastMeshlet[vert[k]] = meshletId;
+			sortedIndices.push_back(vert[k]);
+		}
+		meshletVertices += newVertices;
+	}
+	if(sortedIndices.size() > meshletStart){
+		finishMeshlet();
+	}
+
+	m_indices.swap(sortedIndices);
+}
+
+// Retrieve the meshlets made by BuildMeshlets
+const std::vector<Meshlet>& Geometry::GetMeshlets() const{
+	return m_meshlets;
+}
+
+// Retrieve the bounds computed by Gen
+const Bounds& Geometry::GetBounds() const{
+	return m_bounds;
 }
 
 // Retrieves the number of indices that we have.
@@ -0,0 +1,279 @@
+#include "GeometryArena.hpp"
+#include "GLState.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <utility>
+
+namespace{
+    // Room for this many vertices and indices when an arena is first used.
+    // Arenas double in size when they run out.
+    const unsigned int kInitialVertices = 16*1024;
+    const unsigned int kInitialIndices = 64*1024;
+
+    const int kFormatCount = 3;
+    const char* kFormatNames[kFormatCount] = {"Position", "Texture", "Normal"};
+
+    // One arena per VertexFormat, created on first use
+    std::unique_ptr<GeometryArena>* GetArenas(){
+        static std::unique_ptr<GeometryArena> s_arenas[kFormatCount];
+        return s_arenas;
+    }
+
+    // Creates an empty buffer of 'size' bytes. It is left bound to
+    // GL_COPY_WRITE_BUFFER, which (unlike GL_ELEMENT_ARRAY_BUFFER) does
+    // not change the state of whatever vertex array is bound.
+    GpuResource CreateBuffer(GLsizeiptr size, const char* owner){
+        GpuResource buffer;
+        buffer.Create(GpuResourceType::Buffer, owner, "GeometryArena");
+        GLState::BindBuffer(GL_COPY_WRITE_BUFFER, buffer.Get());
+        glBufferData(GL_COPY_WRITE_BUFFER, size, nullptr, GL_STATIC_DRAW);
+        buffer.SetBytes(size);
+        return buffer;
+    }
+
+    // Copies bytes between two buffers on the GPU
+    void CopyBuffer(GLuint source, GLuint destination, GLintptr sourceOffset, GLintptr destinationOffset, GLsizeiptr size){
+        if(size == 0){
+            return;
+        }
+        GLState::BindBuffer(GL_COPY_READ_BUFFER, source);
+        GLState::BindBuffer(GL_COPY_WRITE_BUFFER, destination);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, sourceOffset, destinationOffset, size);
+    }
+}
+
+// ============== Arenas ==============
+
+GeometryArena& GeometryArena::Get(VertexFormat format){
+    std::unique_ptr<GeometryArena>& arena = GetArenas()[static_cast<int>(format)];
+    if(arena == nullptr){
+        arena.reset(new GeometryArena(format));
+    }
+    return *arena;
+}
+
+void GeometryArena::PrintReports(){
+    for(int i=0; i < kFormatCount; ++i){
+        if(GetArenas()[i] != nullptr){
+            GetArenas()[i]->PrintReport();
+        }
+    }
+}
+
+void GeometryArena::ReleaseAll(){
+    for(int i=0; i < kFormatCount; ++i){
+        if(GetArenas()[i] != nullptr){
+            GetArenas()[i]->Release();
+        }
+    }
+}
+
+// Constructor. No GL calls here, the buffers are made on first use.
+GeometryArena::GeometryArena(VertexFormat format) :
+    m_format(format),
+    m_vertexSize(VertexBufferLayout::GetStride(format)*sizeof(float)){
+}
+
+// Destructor
+GeometryArena::~GeometryArena(){
+    Release();
+}
+
+void GeometryArena::Release(){
+    m_vertexBuffer.Release();
+    m_indexBuffer.Release();
+    m_vertexArray.Release();
+}
+
+// ============== Allocation ==============
+
+GeometryArena::Handle GeometryArena::Allocate(unsigned int vertexCount, unsigned int indexCount, const float* vdata, const unsigned int* idata){
+    if(vertexCount == 0 || indexCount == 0){
+        return kInvalidHandle;
+    }
+    if(!m_vertexBuffer.IsValid()){
+        Reserve(std::max(kInitialVertices, vertexCount), std::max(kInitialIndices, indexCount));
+    }
+
+    // If there is no room, grow and/or pack the buffers and try again.
+    // After packing, everything that is free is one block, so this ends.
+    unsigned int vertexOffset = m_vertices.Allocate(vertexCount);
+    unsigned int indexOffset = m_indices.Allocate(indexCount);
+    while(vertexOffset == RangeAllocator::kInvalidOffset || indexOffset == RangeAllocator::kInvalidOffset){
+        m_vertices.Free(vertexOffset, vertexOffset != RangeAllocator::kInvalidOffset ? vertexCount : 0);
+        m_indices.Free(indexOffset, indexOffset != RangeAllocator::kInvalidOffset ? indexCount : 0);
+        if(m_vertices.GetFree() >= vertexCount && m_indices.GetFree() >= indexCount){
+            // There is enough space in total, it is only split up
+            Defragment();
+        }else{
+            // Only the space that is too small grows
+            unsigned int vertexCapacity = m_vertices.GetCapacity();
+            unsigned int indexCapacity = m_indices.GetCapacity();
+            if(m_vertices.GetFree() < vertexCount){
+                vertexCapacity = std::max(vertexCapacity*2, m_vertices.GetUsed() + vertexCount);
+            }
+            if(m_indices.GetFree() < indexCount){
+                indexCapacity = std::max(indexCapacity*2, m_indices.GetUsed() + indexCount);
+            }
+            Reserve(vertexCapacity, indexCapacity);
+        }
+        vertexOffset = m_vertices.Allocate(vertexCount);
+        indexOffset = m_indices.Allocate(indexCount);
+    }
+
+    GLState::BindBuffer(GL_COPY_WRITE_BUFFER, m_vertexBuffer.Get());
+    glBufferSubData(GL_COPY_WRITE_BUFFER, (GLintptr)vertexOffset*m_vertexSize, (GLsizeiptr)vertexCount*m_vertexSize, vdata);
+    GLState::BindBuffer(GL_COPY_WRITE_BUFFER, m_indexBuffer.Get());
+    glBufferSubData(GL_COPY_WRITE_BUFFER, (GLintptr)indexOffset*sizeof(unsigned int), (GLsizeiptr)indexCount*sizeof(unsigned int), idata);
+
+    Allocation allocation = {vertexOffset, vertexCount, indexOffset, indexCount, true};
+    if(!m_freeHandles.empty()){
+        Handle handle = m_freeHandles.back();
+        m_freeHandles.pop_back();
+        m_allocations[handle] = allocation;
+        return handle;
+    }
+    m_allocations.push_back(allocation);
+    return m_allocations.size() - 1;
+}
+
+void GeometryArena::Free(Handle handle){
+    if(handle >= m_allocations.size() || !m_allocations[handle].live){
+        return;
+    }
+    Allocation& allocation = m_allocations[handle];
+    m_vertices.Free(allocation.vertexOffset, allocation.vertexCount);
+    m_indices.Free(allocation.indexOffset, allocation.indexCount);
+    allocation.live = false;
+    m_freeHandles.push_back(handle);
+}
+
+// Grows the buffers. The old contents are copied to the start of the
+// new buffers, so every allocation keeps its offsets.
+void GeometryArena::Reserve(unsigned int vertexCapacity, unsigned int indexCapacity){
+    vertexCapacity = std::max(vertexCapacity, m_vertices.GetCapacity());
+    indexCapacity = std::max(indexCapacity, m_indices.GetCapacity());
+
+    const char* owner = kFormatNames[static_cast<int>(m_format)];
+    GpuResource vertexBuffer = CreateBuffer((GLsizeiptr)vertexCapacity*m_vertexSize, owner);
+    GpuResource indexBuffer = CreateBuffer((GLsizeiptr)indexCapacity*sizeof(unsigned int), owner);
+    if(m_vertexBuffer.IsValid()){
+        CopyBuffer(m_vertexBuffer.Get(), vertexBuffer.Get(), 0, 0, (GLsizeiptr)m_vertices.GetCapacity()*m_vertexSize);
+        CopyBuffer(m_indexBuffer.Get(), indexBuffer.Get(), 0, 0, (GLsizeiptr)m_indices.GetCapacity()*sizeof(unsigned int));
+        ++m_growCount;
+    }
+    // Moving in the new buffers deletes the old ones
+    m_vertexBuffer = std::move(vertexBuffer);
+    m_indexBuffer = std::move(indexBuffer);
+    m_vertices.Grow(vertexCapacity);
+    m_indices.Grow(indexCapacity);
+
+    // Point the vertex array at the new buffers
+    if(!m_vertexArray.IsValid()){
+        m_vertexArray.Create(GpuResourceType::VertexArray, owner, "GeometryArena");
+    }
+    GLState::BindVertexArray(m_vertexArray.Get());
+    GLState::BindBuffer(GL_ARRAY_BUFFER, m_vertexBuffer.Get());
+    VertexBufferLayout::SetAttributes(m_format);
+    GLState::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexBuffer.Get());
+}
+
+// Copies every live allocation, in order, into fresh buffers with no
+// gaps. Overlapping copies within one buffer are not allowed, so the
+// data always moves to new buffers of the same size.
+void GeometryArena::Defragment(){
+    if(!m_vertexBuffer.IsValid()){
+        return;
+    }
+    std::vector<Handle> live;
+    for(Handle handle=0; handle < m_allocations.size(); ++handle){
+        if(m_allocations[handle].live){
+            live.push_back(handle);
+        }
+    }
+
+    const char* owner = kFormatNames[static_cast<int>(m_format)];
+    GpuResource vertexBuffer = CreateBuffer((GLsizeiptr)m_vertices.GetCapacity()*m_vertexSize, owner);
+    GpuResource indexBuffer = CreateBuffer((GLsizeiptr)m_indices.GetCapacity()*sizeof(unsigned int), owner);
+
+    // Vertices, keeping the order they had in the buffer
+    std::sort(live.begin(), live.end(), [this](Handle a, Handle b){
+        return m_allocations[a].vertexOffset < m_allocations[b].vertexOffset;
+    });
+    unsigned int packedVertices = 0;
+    for(size_t i=0; i < live.size(); ++i){
+        Allocation& allocation = m_allocations[live[i]];
+        CopyBuffer(m_vertexBuffer.Get(), vertexBuffer.Get(), (GLintptr)allocation.vertexOffset*m_vertexSize,
+                   (GLintptr)packedVertices*m_vertexSize, (GLsizeiptr)allocation.vertexCount*m_vertexSize);
+        allocation.vertexOffset = packedVertices;
+        packedVertices += allocation.vertexCount;
+    }
+
+    // Indices are relative to their base vertex, so they copy as they are
+    std::sort(live.begin(), live.end(), [this](Handle a, Handle b){
+        return m_allocations[a].indexOffset < m_allocations[b].indexOffset;
+    });
+    unsigned int packedIndices = 0;
+    for(size_t i=0; i < live.size(); ++i){
+        Allocation& allocation = m_allocations[live[i]];
+        CopyBuffer(m_indexBuffer.Get(), indexBuffer.Get(), (GLintptr)allocation.indexOffset*sizeof(unsigned int),
+                   (GLintptr)packedIndices*sizeof(unsigned int), (GLsizeiptr)allocation.indexCount*sizeof(unsigned int));
+        allocation.indexOffset = packedIndices;
+        packedIndices += allocation.indexCount;
+    }
+
+    m_vertexBuffer = std::move(vertexBuffer);
+    m_indexBuffer = std::move(indexBuffer);
+    m_vertices.Reset(packedVertices);
+    m_indices.Reset(packedIndices);
+    ++m_defragmentCount;
+
+    GLState::BindVertexArray(m_vertexArray.Get());
+    GLState::BindBuffer(GL_ARRAY_BUFFER, m_vertexBuffer.Get());
+    VertexBufferLayout::SetAttributes(m_format);
+    GLState::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexBuffer.Get());
+}
+
+// ============== Drawing ==============
+
+void GeometryArena::Bind(){
+    GLState::BindVertexArray(m_vertexArray.Get());
+}
+
+GLuint GeometryArena::GetVertexArray() const{
+    return m_vertexArray.Get();
+}
+
+GLint GeometryArena::GetBaseVertex(Handle handle) const{
+    return handle < m_allocations.size() ? (GLint)m_allocations[handle].vertexOffset : 0;
+}
+
+unsigned int GeometryArena::GetFirstIndex(Handle handle) const{
+    return handle < m_allocations.size() ? m_allocations[handle].indexOffset : 0;
+}
+
+unsigned int GeometryArena::GetIndexCount(Handle handle) const{
+    return handle < m_allocations.size() && m_allocations[handle].live ? m_allocations[handle].indexCount : 0;
+}
+
+// ============== Reporting ==============
+
+void GeometryArena::PrintReport() const{
+    const double megabyte = 1024.0*1024.0;
+    unsigned int meshes = m_allocations.size() - m_freeHandles.size();
+    std::printf("(GeometryArena.cpp) %s arena: %u meshes, grown %u times, defragmented %u times\n",
+                kFormatNames[static_cast<int>(m_format)], meshes, m_growCount, m_defragmentCount);
+    const RangeAllocator* spaces[2] = {&m_vertices, &m_indices};
+    const char* names[2] = {"vertices", "indices "};
+    const unsigned int sizes[2] = {m_vertexSize, sizeof(unsigned int)};
+    for(int i=0; i < 2; ++i){
+        const RangeAllocator& space = *spaces[i];
+        double occupancy = space.GetCapacity() > 0 ? 100.0*space.GetUsed()/space.GetCapacity() : 0.0;
+        std::printf("    %s %u / %u used (%.1f%%, %.2f of %.2f MB), %u free blocks, largest %u, fragmentation %.1f%%\n",
+                    names[i], space.GetUsed(), space.GetCapacity(), occupancy,
+                    (double)space.GetUsed()*sizes[i]/megabyte, (double)space.GetCapacity()*sizes[i]/megabyte,
+                    space.GetFreeBlockCount(), space.GetLargestFreeBlock(), 100.0f*space.GetFragmentation());
+    }
+}
@@ -0,0 +1,202 @@
+#include "GpuResource.hpp"
+#include "GLState.hpp"
+
+#include <cstdio>
+#include <cstdint>
+#include <map>
+#include <unordered_map>
+
+namespace{
+    const int kTypeCount = 5;
+    const char* kTypeNames[kTypeCount] = {"buffers", "textures", "renderbuffers", "framebuffers", "vertex arrays"};
+
+    // What we know about one live GL object
+    struct Record{
+        std::string owner;
+        const char* category;
+        size_t bytes;
+    };
+
+    // GL names are only unique per type, so the type is part of the key
+    uint64_t GetKey(GpuResourceType type, GLuint id){
+        return ((uint64_t)static_cast<int>(type) << 32) | id;
+    }
+
+    std::unordered_map<uint64_t, Record>& GetRecords(){
+        static std::unordered_map<uint64_t, Record> s_records;
+        return s_records;
+    }
+
+    GLuint Generate(GpuResourceType type){
+        GLuint id = 0;
+        switch(type){
+            case GpuResourceType::Buffer:       glGenBuffers(1, &id); break;
+            case GpuResourceType::Texture:      glGenTextures(1, &id); break;
+            case GpuResourceType::Renderbuffer: glGenRenderbuffers(1, &id); break;
+            case GpuResourceType::Framebuffer:  glGenFramebuffers(1, &id); break;
+            case GpuResourceType::VertexArray:  glGenVertexArrays(1, &id); break;
+        }
+        return id;
+    }
+
+    // The name may be handed out again, so GLState must forget it too
+    void Delete(GpuResourceType type, GLuint id){
+        switch(type){
+            case GpuResourceType::Buffer:       glDeleteBuffers(1, &id); GLState::ForgetBuffer(id); break;
+            case GpuResourceType::Texture:      glDeleteTextures(1, &id); GLState::ForgetTexture(id); break;
+            case GpuResourceType::Renderbuffer: glDeleteRenderbuffers(1, &id); break;
+            case GpuResourceType::Framebuffer:  glDeleteFramebuffers(1, &id); GLState::ForgetFramebuffer(id); break;
+            case GpuResourceType::VertexArray:  glDeleteVertexArrays(1, &id); GLState::ForgetVertexArray(id); break;
+        }
+    }
+
+    double ToMegabytes(size_t bytes){
+        return bytes / (1024.0*1024.0);
+    }
+}
+
+// ============== GpuResource ==============
+
+// Constructor
+GpuResource::GpuResource(){
+}
+
+// Destructor
+GpuResource::~GpuResource(){
+    Release();
+}
+
+GpuResource::GpuResource(GpuResource&& other) : m_type(other.m_type), m_id(other.m_id){
+    other.m_id = 0;
+}
+
+GpuResource& GpuResource::operator=(GpuResource&& other){
+    if(this != &other){
+        Release();
+        m_type = other.m_type;
+        m_id = other.m_id;
+        other.m_id = 0;
+    }
+    return *this;
+}
+
+void GpuResource::Create(GpuResourceType type, const std::string& owner, const char* category){
+    Release();
+    m_type = type;
+    m_id = Generate(type);
+    if(m_id == 0){
+        std::printf("(GpuResource.cpp) ERROR, could not create %s for %s\n", kTypeNames[static_cast<int>(type)], owner.c_str());
+        return;
+    }
+    GpuResources::Add(m_type, m_id, owner, category);
+}
+
+void GpuResource::Release(){
+    if(m_id != 0){
+        GpuResources::Remove(m_type, m_id);
+        Delete(m_type, m_id);
+        m_id = 0;
+    }
+}
+
+void GpuResource::SetBytes(size_t bytes){
+    if(m_id != 0){
+        GpuResources::SetBytes(m_type, m_id, bytes);
+    }
+}
+
+// ============== GpuResources ==============
+
+void GpuResources::Add(GpuResourceType type, GLuint id, const std::string& owner, const char* category){
+    GetRecords()[GetKey(type, id)] = Record{owner, category, 0};
+}
+
+void GpuResources::Remove(GpuResourceType type, GLuint id){
+    GetRecords().erase(GetKey(type, id));
+}
+
+void GpuResources::SetBytes(GpuResourceType type, GLuint id, size_t bytes){
+    auto found = GetRecords().find(GetKey(type, id));
+    if(found != GetRecords().end()){
+        found->second.bytes = bytes;
+    }
+}
+
+size_t GpuResources::GetBytes(GpuResourceType type){
+    size_t bytes = 0;
+    for(const auto& entry : GetRecords()){
+        if((entry.first >> 32) == (uint64_t)static_cast<int>(type)){
+            bytes += entry.second.bytes;
+        }
+    }
+    return bytes;
+}
+
+unsigned int GpuResources::GetCount(GpuResourceType type){
+    unsigned int count = 0;
+    for(const auto& entry : GetRecords()){
+        if((entry.first >> 32) == (uint64_t)static_cast<int>(type)){
+            ++count;
+        }
+    }
+    return count;
+}
+
+void GpuResources::PrintReport(){
+    // Sorted by name so reports are easy to compare between runs
+    struct Total{
+        unsigned int count;
+        size_t bytes;
+    };
+    std::map<std::string, Total> categories;
+    size_t totalBytes = 0;
+    for(const auto& entry : GetRecords()){
+        Total& total = categories[entry.second.category];
+        ++total.count;
+        total.bytes += entry.second.bytes;
+        totalBytes += entry.second.bytes;
+    }
+
+    std::printf("(GpuResource.cpp) %zu GL objects, %.2f MB estimated\n", GetRecords().size(), ToMegabytes(totalBytes));
+    for(int i=0; i < kTypeCount; ++i){
+        GpuResourceType type = static_cast<GpuResourceType>(i);
+        std::printf("    %-14s %5u  %8.2f MB\n", kTypeNames[i], GetCount(type), ToMegabytes(GetBytes(type)));
+    }
+    for(const auto& category : categories){
+        std::printf("    [%s] %u objects, %.2f MB\n", category.first.c_str(), category.second.count, ToMegabytes(category.second.bytes));
+    }
+}
+
+unsigned int GpuResources::CheckLeaks(){
+    const std::unordered_map<uint64_t, Record>& records = GetRecords();
+    if(records.empty()){
+        std::printf("(GpuResource.cpp) No GL objects leaked\n");
+        return 0;
+    }
+    std::printf("(GpuResource.cpp) ERROR, %zu GL objects were never deleted:\n", records.size());
+    for(const auto& entry : records){
+        std::printf("    %s %u [%s] %s, %zu bytes\n", kTypeNames[entry.first >> 32], (unsigned int)(entry.first & 0xffffffff),
+                    entry.second.category, entry.second.owner.c_str(), entry.second.bytes);
+    }
+    return records.size();
+}
+
+// Sizes the driver is likely to use. Formats it does not know are
+// counted as 4 bytes per pixel.
+size_t GpuResources::GetImageBytes(GLenum internalFormat, int width, int height, bool mipmaps){
+    size_t pixelSize = 4;
+    switch(internalFormat){
+        case GL_RED: case GL_R8:                     pixelSize = 1; break;
+        case GL_RG: case GL_RG8: case GL_R16F:       pixelSize = 2; break;
+        // RGB8 is padded to 4 bytes per pixel by most drivers
+        case GL_RGB: case GL_RGB8:                   pixelSize = 4; break;
+        case GL_RGBA: case GL_RGBA8:                 pixelSize = 4; break;
+        case GL_DEPTH24_STENCIL8: case GL_R32F:      pixelSize = 4; break;
+        case GL_DEPTH_COMPONENT24:                   pixelSize = 4; break;
+        case GL_RGBA16F:                             pixelSize = 8; break;
+        case GL_RGBA32F:                             pixelSize = 16; break;
+    }
+    size_t bytes = (size_t)width*height*pixelSize;
+    // Every level is a quarter of the one before, which adds up to a third
+    return mipmaps ? bytes + bytes/3 : bytes;
+}
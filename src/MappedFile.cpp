@@ -0,0 +1,87 @@
+#include "MappedFile.hpp"
+
+#include <fstream>
+
+#if defined(LINUX) || defined(MAC)
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+    #define MAPPEDFILE_USE_MMAP
+#endif
+
+// Constructor
+MappedFile::MappedFile() : m_data(nullptr), m_size(0){
+}
+
+// Destructor
+MappedFile::~MappedFile(){
+    Close();
+}
+
+// Maps the whole file into memory
+bool MappedFile::Open(const std::string& path){
+    Close();
+#if defined(MAPPEDFILE_USE_MMAP)
+    int fd = open(path.c_str(), O_RDONLY);
+    if(fd < 0){
+        return false;
+    }
+    struct stat info;
+    if(fstat(fd, &info) != 0 || info.st_size <= 0){
+        close(fd);
+        return false;
+    }
+    void* ptr = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // The mapping stays valid after the descriptor is closed
+    close(fd);
+    if(ptr == MAP_FAILED){
+        return false;
+    }
+    m_data = static_cast<const unsigned char*>(ptr);
+    m_size = info.st_size;
+    return true;
+#else
+    std::ifstream file(path.c_str(), std::ios::binary | std::ios::ate);
+    if(!file.is_open()){
+        return false;
+    }
+    std::streamsize size = file.tellg();
+    if(size <= 0){
+        return false;
+    }
+    m_fallback.resize(size);
+    file.seekg(0);
+    if(!file.read(reinterpret_cast<char*>(m_fallback.data()), size)){
+        m_fallback.clear();
+        return false;
+    }
+    m_data = m_fallback.data();
+    m_size = size;
+    return true;
+#endif
+}
+
+// Release the mapping
+void MappedFile::Close(){
+#if defined(MAPPEDFILE_USE_MMAP)
+    if(m_data != nullptr){
+        munmap(const_cast<unsigned char*>(m_data), m_size);
+    }
+#endif
+    m_fallback.clear();
+    m_data = nullptr;
+    m_size = 0;
+}
+
+bool MappedFile::IsOpen() const{
+    return m_data != nullptr;
+}
+
+const unsigned char* MappedFile::GetData() const{
+    return m_data;
+}
+
+size_t MappedFile::GetSize() const{
+    return m_size;
+}
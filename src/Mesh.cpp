@@ -0,0 +1,96 @@
+#include "Mesh.hpp"
+#include "MeshFile.hpp"
+
+// Constructor
+Mesh::Mesh(){
+}
+
+// Destructor. Gives our space in the arena back.
+Mesh::~Mesh(){
+    GeometryArena::Get(VertexFormat::Normal).Free(m_arenaHandle);
+}
+
+// Retrieve the geometry to fill in
+Geometry& Mesh::GetGeometry(){
+    return m_geometry;
+}
+
+// Generate all of the vertex data and send it to the GPU
+void Mesh::Upload(){
+    // This is a helper function to generate all of the geometry
+    m_geometry.Gen();
+    // Copy the data into the shared buffers
+    GeometryArena& arena = GeometryArena::Get(VertexFormat::Normal);
+    arena.Free(m_arenaHandle);
+    m_arenaHandle = arena.Allocate(m_geometry.GetBufferDataSize() / VertexBufferLayout::GetStride(VertexFormat::Normal),
+                                   m_geometry.GetIndicesSize(),
+                                   m_geometry.GetBufferDataPtr(),
+                                   m_geometry.GetIndicesDataPtr());
+    m_meshlets = m_geometry.GetMeshlets();
+    m_bounds = m_geometry.GetBounds();
+}
+
+// The cooked data is already in its final layout, so it
+// goes straight from the mapped file to the GPU.
+void Mesh::Upload(const MeshFile& cooked){
+    GeometryArena& arena = GeometryArena::Get(VertexFormat::Normal);
+    arena.Free(m_arenaHandle);
+    m_arenaHandle = arena.Allocate(cooked.GetHeader().vertexCount,
+                                   cooked.GetIndicesSize(),
+                                   cooked.GetBufferDataPtr(),
+                                   cooked.GetIndicesDataPtr());
+    m_meshlets.assign(cooked.GetMeshletsPtr(), cooked.GetMeshletsPtr() + cooked.GetMeshletsSize());
+    // Cooked files only keep the box
+    const MeshFileHeader& header = cooked.GetHeader();
+    m_bounds = Bounds();
+    if(header.vertexCount > 0){
+        m_bounds.Add(glm::vec3(header.boundsMin[0], header.boundsMin[1], header.boundsMin[2]));
+        m_bounds.Add(glm::vec3(header.boundsMax[0], header.boundsMax[1], header.boundsMax[2]));
+    }
+    m_bounds.UpdateSphere();
+}
+
+// Nothing is generated, so the bounds come from the positions (the
+// first three floats of every vertex)
+void Mesh::Upload(const std::vector<float>& vertexData, const std::vector<unsigned int>& indices,
+                  const std::vector<Meshlet>& meshlets){
+    const unsigned int stride = VertexBufferLayout::GetStride(VertexFormat::Normal);
+    GeometryArena& arena = GeometryArena::Get(VertexFormat::Normal);
+    arena.Free(m_arenaHandle);
+    m_arenaHandle = arena.Allocate(vertexData.size() / stride, indices.size(), vertexData.data(), indices.data());
+    m_meshlets = meshlets;
+    m_bounds = Bounds();
+    for(size_t i=0; i + 2 < vertexData.size(); i += stride){
+        m_bounds.Add(glm::vec3(vertexData[i], vertexData[i+1], vertexData[i+2]));
+    }
+    m_bounds.UpdateSphere();
+}
+
+// Select our buffers
+void Mesh::Bind(){
+    GeometryArena::Get(VertexFormat::Normal).Bind();
+}
+
+GLuint Mesh::GetVertexArray() const{
+    return GeometryArena::Get(VertexFormat::Normal).GetVertexArray();
+}
+
+unsigned int Mesh::GetIndexCount() const{
+    return GeometryArena::Get(VertexFormat::Normal).GetIndexCount(m_arenaHandle);
+}
+
+unsigned int Mesh::GetFirstIndex() const{
+    return GeometryArena::Get(VertexFormat::Normal).GetFirstIndex(m_arenaHandle);
+}
+
+GLint Mesh::GetBaseVertex() const{
+    return GeometryArena::Get(VertexFormat::Normal).GetBaseVertex(m_arenaHandle);
+}
+
+const std::vector<Meshlet>& Mesh::GetMeshlets() const{
+    return m_meshlets;
+}
+
+const Bounds& Mesh::GetBounds() const{
+    return m_bounds;
+}
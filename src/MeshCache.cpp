@@ -0,0 +1,40 @@
+#include "MeshCache.hpp"
+
+#include <iostream>
+
+// Constructor is empty
+MeshCache::MeshCache(){
+}
+
+MeshCache& MeshCache::Instance(){
+    static MeshCache* instance = new MeshCache();
+    return *instance;
+}
+
+// Find or build the mesh for 'key'
+std::shared_ptr<Mesh> MeshCache::Get(const std::string& key, const std::function<void(Geometry&)>& build){
+    std::shared_ptr<Mesh> mesh = m_meshes[key].lock();
+    if(mesh != nullptr){
+        return mesh;
+    }
+    std::cout << "(MeshCache.cpp) Building mesh " << key << "\n";
+    mesh = std::make_shared<Mesh>();
+    build(mesh->GetGeometry());
+    mesh->Upload();
+    m_meshes[key] = mesh;
+    return mesh;
+}
+
+// Count the meshes that are still in use (and forget the others)
+unsigned int MeshCache::GetMeshCount(){
+    unsigned int count = 0;
+    for(auto it = m_meshes.begin(); it != m_meshes.end();){
+        if(it->second.expired()){
+            it = m_meshes.erase(it);
+        }else{
+            ++count;
+            ++it;
+        }
+    }
+    return count;
+}
@@ -0,0 +1,618 @@
+#include "MeshCodec.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// The rANS decoder has an AVX2 version (8 states per register, table
+// lookups with gathers). It is compiled for AVX2 whatever the build
+// flags are, and only used if the CPU has it.
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define MESHCODEC_AVX2
+#include <immintrin.h>
+#endif
+
+namespace{
+    // How each byte plane is stored
+    enum PlaneMode : uint8_t { kPlaneConstant = 0, kPlaneRaw = 1, kPlaneRans = 2, kPlaneSparse = 3 };
+
+    // rANS parameters. Probabilities are scaled to 1 << kProbBits and the
+    // coder state is kept in [kRansLow, kRansLow << 16). The stream is
+    // read and written 16 bits at a time, so decoding a symbol reads at
+    // most one word.
+    const uint32_t kProbBits = 12;
+    const uint32_t kProbScale = 1u << kProbBits;
+    const uint32_t kRansLow = 1u << 16;
+    // Number of interleaved coder states: symbol i belongs to state
+    // i % kStates. The AVX2 decoder keeps them in four registers of 8, so
+    // four table lookups are in flight at once.
+    const uint32_t kStates = 32;
+    // Elements of every plane decoded at a time (a multiple of kStates)
+    const uint32_t kDecodeBlock = 4096;
+
+    // ---- Little helpers for writing and reading the stream ----
+    void Put8(std::vector<unsigned char>& out, uint8_t v){
+        out.push_back(v);
+    }
+    void Put16(std::vector<unsigned char>& out, uint16_t v){
+        out.push_back(v & 0xff);
+        out.push_back(v >> 8);
+    }
+    void Put32(std::vector<unsigned char>& out, uint32_t v){
+        for(int i=0; i < 4; ++i){
+            out.push_back((v >> (i*8)) & 0xff);
+        }
+    }
+
+    // Reads from a buffer and remembers if we ever went past the end
+    struct Reader{
+        const unsigned char* ptr;
+        const unsigned char* end;
+        bool ok;
+
+        bool Has(size_t n) const{
+            return ok && (size_t)(end - ptr) >= n;
+        }
+        uint8_t Get8(){
+            if(!Has(1)){ ok = false; return 0; }
+            return *ptr++;
+        }
+        uint16_t Get16(){
+            if(!Has(2)){ ok = false; return 0; }
+            uint16_t v = ptr[0] | (ptr[1] << 8);
+            ptr += 2;
+            return v;
+        }
+        uint32_t Get32(){
+            if(!Has(4)){ ok = false; return 0; }
+            uint32_t v = ptr[0] | (ptr[1] << 8) | (ptr[2] << 16) | ((uint32_t)ptr[3] << 24);
+            ptr += 4;
+            return v;
+        }
+    };
+
+    inline uint32_t Zigzag(uint32_t v){
+        return (v << 1) ^ (uint32_t)((int32_t)v >> 31);
+    }
+    inline uint32_t Unzigzag(uint32_t v){
+        return (v >> 1) ^ (0u - (v & 1));
+    }
+
+    // Scales a histogram so that it sums to kProbScale while keeping
+    // every symbol that appears at a frequency of at least 1.
+    void NormalizeFrequencies(const uint32_t counts[256], uint32_t total, uint32_t freqs[256]){
+        uint32_t sum = 0;
+        for(int s=0; s < 256; ++s){
+            freqs[s] = 0;
+            if(counts[s] > 0){
+                uint64_t scaled = (uint64_t)counts[s] * kProbScale / total;
+                freqs[s] = scaled == 0 ? 1 : (uint32_t)scaled;
+                sum += freqs[s];
+            }
+        }
+        // Hand any difference to (or take it from) the most common symbols
+        while(sum != kProbScale){
+            int best = -1;
+            for(int s=0; s < 256; ++s){
+                if(freqs[s] > 1 && (best < 0 || freqs[s] > freqs[best])){
+                    best = s;
+                }
+            }
+            if(best < 0){
+                break;
+            }
+            if(sum < kProbScale){
+                freqs[best] += kProbScale - sum;
+                sum = kProbScale;
+            }else{
+                uint32_t take = sum - kProbScale;
+                take = take < freqs[best] - 1 ? take : freqs[best] - 1;
+                freqs[best] -= take;
+                sum -= take;
+            }
+        }
+    }
+
+    // Compresses one byte plane and appends it to 'out'
+    void EncodePlane(const uint8_t* plane, uint32_t count, std::vector<unsigned char>& out){
+        uint32_t counts[256] = {0};
+        for(uint32_t i=0; i < count; ++i){
+            ++counts[plane[i]];
+        }
+        int distinct = 0;
+        for(int s=0; s < 256; ++s){
+            distinct += counts[s] > 0 ? 1 : 0;
+        }
+        if(distinct <= 1){
+            Put8(out, kPlaneConstant);
+            Put8(out, count > 0 ? plane[0] : 0);
+            return;
+        }
+
+        uint32_t freqs[256];
+        uint32_t starts[256];
+        NormalizeFrequencies(counts, count, freqs);
+        uint32_t cumulative = 0;
+        for(int s=0; s < 256; ++s){
+            starts[s] = cumulative;
+            cumulative += freqs[s];
+        }
+
+        // The encoder runs backwards and writes backwards, so that the
+        // decoder can run forwards: the words the states of one group of
+        // kStates symbols need come in state order. Each symbol writes at
+        // most one word.
+        std::vector<uint8_t> buffer(count*2 + 4*kStates + 64);
+        uint8_t* ptr = buffer.data() + buffer.size();
+        uint32_t states[kStates];
+        for(uint32_t k=0; k < kStates; ++k){
+            states[k] = kRansLow;
+        }
+        for(uint32_t i=count; i-- > 0;){
+            uint32_t& x = states[i % kStates];
+            uint8_t s = plane[i];
+            uint32_t freq = freqs[s];
+            uint32_t maxState = ((kRansLow >> kProbBits) << 16) * freq;
+            if(x >= maxState){
+                ptr -= 2;
+                ptr[0] = (uint8_t)(x & 0xff);
+                ptr[1] = (uint8_t)((x >> 8) & 0xff);
+                x >>= 16;
+            }
+            x = ((x / freq) << kProbBits) + (x % freq) + starts[s];
+        }
+        // Flush the states so that state 0 is read first
+        for(uint32_t k=kStates; k-- > 0;){
+            ptr -= 4;
+            for(int b=0; b < 4; ++b){
+                ptr[b] = (states[k] >> (b*8)) & 0xff;
+            }
+        }
+        uint32_t encodedSize = buffer.data() + buffer.size() - ptr;
+
+        // Table: symbol count then (symbol, frequency) pairs
+        uint32_t tableSize = 2 + distinct*3 + 4;
+        // A plane that is one value except in a few places is stored as
+        // that value and the exceptions (index, value), which is smaller
+        // than the rANS states and much quicker to decode
+        int common = 0;
+        for(int s=1; s < 256; ++s){
+            common = counts[s] > counts[common] ? s : common;
+        }
+        const uint32_t exceptions = count - counts[common];
+        const uint64_t sparseSize = 5 + (uint64_t)exceptions*5;
+        if(sparseSize < encodedSize + tableSize && sparseSize < count){
+            Put8(out, kPlaneSparse);
+            Put8(out, common);
+            Put32(out, exceptions);
+            for(uint32_t i=0; i < count; ++i){
+                if(plane[i] != common){
+                    Put32(out, i);
+                    Put8(out, plane[i]);
+                }
+            }
+            return;
+        }
+        if(encodedSize + tableSize >= count){
+            Put8(out, kPlaneRaw);
+            out.insert(out.end(), plane, plane + count);
+            return;
+        }
+        Put8(out, kPlaneRans);
+        Put16(out, distinct);
+        for(int s=0; s < 256; ++s){
+            if(freqs[s] > 0){
+                Put8(out, s);
+                Put16(out, freqs[s]);
+            }
+        }
+        Put32(out, encodedSize);
+        out.insert(out.end(), ptr, ptr + encodedSize);
+    }
+
+#if defined(MESHCODEC_AVX2)
+    bool HasAVX2(){
+        static const bool hasAVX2 = __builtin_cpu_supports("avx2");
+        return hasAVX2;
+    }
+
+    // For each mask of states that need a word, the index of the word each
+    // state takes (the number of states before it that need one too)
+    struct RefillTable{
+        alignas(32) uint32_t lanes[256][8];
+        RefillTable(){
+            for(uint32_t mask=0; mask < 256; ++mask){
+                uint32_t taken = 0;
+                for(uint32_t k=0; k < 8; ++k){
+                    lanes[mask][k] = taken;
+                    taken += (mask >> k) & 1;
+                }
+            }
+        }
+    };
+    const RefillTable s_refill;
+
+    // Decodes kStates symbols per step, one per state, while at least
+    // kStates words are left in the stream (so every load stays inside
+    // it). Returns how many symbols were decoded; 'states' and 'ptr' are
+    // left where the scalar decoder carries on.
+    __attribute__((target("avx2")))
+    uint32_t DecodeRansAVX2(const uint32_t* table, uint32_t* states, const uint8_t*& ptr, const uint8_t* end,
+                            uint8_t* plane, uint32_t count){
+        const __m256i slotMask = _mm256_set1_epi32(kProbScale - 1);
+        const __m256i freqMask = _mm256_set1_epi32(0xfff);
+        const __m256i zero = _mm256_setzero_si256();
+        // Byte 0 of every state to the front of its 128-bit half
+        const __m256i gatherSymbols = _mm256_setr_epi8(0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                                                       0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+        const __m256i packSymbols = _mm256_setr_epi32(0, 4, 0, 0, 0, 0, 0, 0);
+        const uint32_t kRegisters = kStates / 8;
+        __m256i x[kRegisters];
+        for(uint32_t r=0; r < kRegisters; ++r){
+            x[r] = _mm256_loadu_si256((const __m256i*)(states + r*8));
+        }
+        uint32_t i = 0;
+        for(; i + kStates <= count && end - ptr >= (ptrdiff_t)(kStates*2); i += kStates){
+            // Registers take their words in order, so states stay in order
+            for(uint32_t r=0; r < kRegisters; ++r){
+                const __m256i e = _mm256_i32gather_epi32((const int*)table, _mm256_and_si256(x[r], slotMask), 4);
+
+                const __m256i symbols = _mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(e, gatherSymbols), packSymbols);
+                _mm_storel_epi64((__m128i*)(plane + i + r*8), _mm256_castsi256_si128(symbols));
+
+                // x = freq * (x >> kProbBits) + (slot - start)
+                const __m256i freq = _mm256_and_si256(_mm256_srli_epi32(e, 8), freqMask);
+                x[r] = _mm256_add_epi32(_mm256_mullo_epi32(freq, _mm256_srli_epi32(x[r], kProbBits)), _mm256_srli_epi32(e, 20));
+
+                // States below kRansLow take the next words, in state order
+                const __m256i refill = _mm256_cmpeq_epi32(_mm256_srli_epi32(x[r], 16), zero);
+                const uint32_t mask = (uint32_t)_mm256_movemask_ps(_mm256_castsi256_ps(refill));
+                __m256i words = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*)ptr));
+                words = _mm256_permutevar8x32_epi32(words, _mm256_load_si256((const __m256i*)s_refill.lanes[mask]));
+                x[r] = _mm256_blendv_epi8(x[r], _mm256_or_si256(_mm256_slli_epi32(x[r], 16), words), refill);
+                ptr += 2 * __builtin_popcount(mask);
+            }
+        }
+        for(uint32_t r=0; r < kRegisters; ++r){
+            _mm256_storeu_si256((__m256i*)(states + r*8), x[r]);
+        }
+        return i;
+    }
+#endif
+
+    // Where one byte plane is in the stream, and how far it has been
+    // decoded. Planes are decoded a block of elements at a time.
+    struct PlaneDecoder{
+        uint8_t mode;
+        // The value of a constant or sparse plane
+        uint8_t value;
+        // The bytes of a raw plane, the (index, value) exceptions of a
+        // sparse one, or the words of a rANS one
+        const uint8_t* ptr;
+        const uint8_t* end;
+        // rANS only: the lookup table (see OpenPlane) and coder states
+        const uint32_t* table;
+        uint32_t states[kStates];
+    };
+
+    // Reads the header of one byte plane of 'count' bytes and moves past
+    // its data. A rANS plane's lookup table is built in 'table'
+    // (kProbScale entries). Returns false if the data is broken.
+    bool OpenPlane(Reader& reader, PlaneDecoder& plane, uint32_t* table, uint32_t count){
+        plane.mode = reader.Get8();
+        if(plane.mode == kPlaneConstant){
+            plane.value = reader.Get8();
+            return reader.ok;
+        }
+        if(plane.mode == kPlaneRaw){
+            if(!reader.Has(count)){
+                return false;
+            }
+            plane.ptr = reader.ptr;
+            reader.ptr += count;
+            return true;
+        }
+        if(plane.mode == kPlaneSparse){
+            plane.value = reader.Get8();
+            uint32_t exceptions = reader.Get32();
+            if(!reader.ok || exceptions > count || !reader.Has((size_t)exceptions*5)){
+                return false;
+            }
+            plane.ptr = reader.ptr;
+            plane.end = reader.ptr + (size_t)exceptions*5;
+            reader.ptr = plane.end;
+            // Exceptions must come in order, and inside the plane
+            uint32_t next = 0;
+            for(const uint8_t* e = plane.ptr; e < plane.end; e += 5){
+                uint32_t index = e[0] | (e[1] << 8) | (e[2] << 16) | ((uint32_t)e[3] << 24);
+                if(index < next || index >= count){
+                    return false;
+                }
+                next = index + 1;
+            }
+            return true;
+        }
+        if(plane.mode != kPlaneRans){
+            return false;
+        }
+
+        // Every slot of the probability range maps to one entry:
+        // symbol (8 bits) | frequency (12 bits) | slot - start (12 bits)
+        uint32_t symbolCount = reader.Get16();
+        uint32_t cumulative = 0;
+        for(uint32_t i=0; i < symbolCount && reader.ok; ++i){
+            uint32_t s = reader.Get8();
+            uint32_t freq = reader.Get16();
+            if(freq == 0 || freq >= kProbScale || cumulative + freq > kProbScale){
+                return false;
+            }
+            for(uint32_t slot=0; slot < freq; ++slot){
+                table[cumulative + slot] = s | (freq << 8) | (slot << 20);
+            }
+            cumulative += freq;
+        }
+        uint32_t encodedSize = reader.Get32();
+        if(!reader.ok || cumulative != kProbScale || !reader.Has(encodedSize) || encodedSize < 4*kStates){
+            return false;
+        }
+        plane.table = table;
+        plane.ptr = reader.ptr;
+        plane.end = reader.ptr + encodedSize;
+        reader.ptr = plane.end;
+        for(uint32_t k=0; k < kStates; ++k){
+            plane.states[k] = plane.ptr[0] | (plane.ptr[1] << 8) | (plane.ptr[2] << 16) | ((uint32_t)plane.ptr[3] << 24);
+            plane.ptr += 4;
+        }
+        return true;
+    }
+
+    // Decodes bytes [begin, end) of a plane into out[0, end - begin).
+    // Blocks must be decoded in order, and 'begin' must be a multiple of
+    // kStates so that element i still belongs to state i % kStates.
+    void DecodePlaneRange(PlaneDecoder& plane, uint8_t* out, uint32_t begin, uint32_t end){
+        const uint32_t count = end - begin;
+        if(plane.mode == kPlaneConstant){
+            std::memset(out, plane.value, count);
+            return;
+        }
+        if(plane.mode == kPlaneRaw){
+            std::memcpy(out, plane.ptr + begin, count);
+            return;
+        }
+        if(plane.mode == kPlaneSparse){
+            std::memset(out, plane.value, count);
+            for(; plane.ptr < plane.end; plane.ptr += 5){
+                const uint8_t* e = plane.ptr;
+                uint32_t index = e[0] | (e[1] << 8) | (e[2] << 16) | ((uint32_t)e[3] << 24);
+                if(index >= end){
+                    break;
+                }
+                out[index - begin] = e[4];
+            }
+            return;
+        }
+
+        const uint32_t* table = plane.table;
+        uint32_t* states = plane.states;
+        const uint8_t* ptr = plane.ptr;
+        uint32_t i = 0;
+#if defined(MESHCODEC_AVX2)
+        if(HasAVX2()){
+            i = DecodeRansAVX2(table, states, ptr, plane.end, out, count);
+            // Near the end of the stream the loads would go past it, so the
+            // last words are copied where there is room. Planes that are
+            // nearly constant have hardly any words, and would otherwise be
+            // decoded one symbol at a time.
+            if(i + kStates <= count){
+                uint8_t tail[kStates*4] = {0};
+                const size_t left = plane.end - ptr;
+                std::memcpy(tail, ptr, left);
+                const uint8_t* tailPtr = tail;
+                i += DecodeRansAVX2(table, states, tailPtr, tail + sizeof(tail), out + i, count - i);
+                // Only broken data reads past the words that were left
+                ptr += std::min(left, (size_t)(tailPtr - tail));
+            }
+        }
+#endif
+        // The rest (and everything without AVX2) one symbol at a time, in
+        // the same order
+        for(; i < count; ++i){
+            uint32_t& x = states[i % kStates];
+            uint32_t e = table[x & (kProbScale - 1)];
+            out[i] = (uint8_t)e;
+            x = ((e >> 8) & 0xfff) * (x >> kProbBits) + (e >> 20);
+            if(x < kRansLow && plane.end - ptr >= 2){
+                x = (x << 16) | ptr[0] | (ptr[1] << 8);
+                ptr += 2;
+            }
+        }
+        plane.ptr = ptr;
+    }
+
+#if defined(__SSE2__)
+    // Rebuilds 16 words of one column from its four byte planes (which
+    // start 'planeStride' bytes apart), starting at element i: joins the bytes, undoes
+    // the zigzag and then the delta (a running sum, carried in 'carry').
+    inline void RebuildSixteen(const uint8_t* planes, size_t planeStride, uint32_t i, __m128i& carry, __m128i w[4]){
+        const __m128i one = _mm_set1_epi32(1);
+        const __m128i zero = _mm_setzero_si128();
+        __m128i b0 = _mm_loadu_si128((const __m128i*)(planes + i));
+        __m128i b1 = _mm_loadu_si128((const __m128i*)(planes + planeStride + i));
+        __m128i b2 = _mm_loadu_si128((const __m128i*)(planes + planeStride*2 + i));
+        __m128i b3 = _mm_loadu_si128((const __m128i*)(planes + planeStride*3 + i));
+        // Interleave the planes back into 32-bit words
+        __m128i lo01 = _mm_unpacklo_epi8(b0, b1);
+        __m128i hi01 = _mm_unpackhi_epi8(b0, b1);
+        __m128i lo23 = _mm_unpacklo_epi8(b2, b3);
+        __m128i hi23 = _mm_unpackhi_epi8(b2, b3);
+        w[0] = _mm_unpacklo_epi16(lo01, lo23);
+        w[1] = _mm_unpackhi_epi16(lo01, lo23);
+        w[2] = _mm_unpacklo_epi16(hi01, hi23);
+        w[3] = _mm_unpackhi_epi16(hi01, hi23);
+        for(int k=0; k < 4; ++k){
+            // Zigzag decode: (v >> 1) ^ -(v & 1)
+            __m128i v = _mm_xor_si128(_mm_srli_epi32(w[k], 1), _mm_sub_epi32(zero, _mm_and_si128(w[k], one)));
+            // Running sum within the register, plus the previous total
+            v = _mm_add_epi32(v, _mm_slli_si128(v, 4));
+            v = _mm_add_epi32(v, _mm_slli_si128(v, 8));
+            v = _mm_add_epi32(v, carry);
+            carry = _mm_shuffle_epi32(v, _MM_SHUFFLE(3,3,3,3));
+            w[k] = v;
+        }
+    }
+#endif
+
+    // Rebuilds elements [begin, end) of 'words' columns, each from its four
+    // byte planes. Planes start 'planeStride' bytes apart, column w's at
+    // planes + w*4*planeStride. previous[w] carries column w's running sum.
+    // Writes word w of element i to output[i*words + w].
+    void RebuildRows(const uint8_t* planes, size_t planeStride, uint32_t words, uint32_t begin, uint32_t end,
+                     unsigned int* output, uint32_t* previous){
+        uint32_t i = begin;
+#if defined(__SSE2__)
+        // Four columns at a time: 16 elements of each are rebuilt, then
+        // turned around (4x4 transposes) into rows, which are stored whole
+        if(words == 1){
+            __m128i carry = _mm_set1_epi32((int)previous[0]);
+            for(; i + 16 <= end; i += 16){
+                __m128i v[4];
+                RebuildSixteen(planes, planeStride, i, carry, v);
+                for(int k=0; k < 4; ++k){
+                    _mm_storeu_si128((__m128i*)(output + i + k*4), v[k]);
+                }
+            }
+            previous[0] = (uint32_t)_mm_cvtsi128_si32(carry);
+        }
+        for(; i + 16 <= end; i += 16){
+            for(uint32_t w=0; w < words; w += 4){
+                const uint32_t columns = std::min(words - w, 4u);
+                __m128i v[4][4];
+                for(uint32_t c=0; c < 4; ++c){
+                    if(c < columns){
+                        __m128i carry = _mm_set1_epi32((int)previous[w + c]);
+                        RebuildSixteen(planes + (w + c)*4*planeStride, planeStride, i, carry, v[c]);
+                        previous[w + c] = (uint32_t)_mm_cvtsi128_si32(carry);
+                    }else{
+                        v[c][0] = v[c][1] = v[c][2] = v[c][3] = _mm_setzero_si128();
+                    }
+                }
+                for(int k=0; k < 4; ++k){
+                    __m128 r0 = _mm_castsi128_ps(v[0][k]);
+                    __m128 r1 = _mm_castsi128_ps(v[1][k]);
+                    __m128 r2 = _mm_castsi128_ps(v[2][k]);
+                    __m128 r3 = _mm_castsi128_ps(v[3][k]);
+                    _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+                    const __m128i rows[4] = {_mm_castps_si128(r0), _mm_castps_si128(r1),
+                                             _mm_castps_si128(r2), _mm_castps_si128(r3)};
+                    for(int j=0; j < 4; ++j){
+                        unsigned int* row = output + (size_t)(i + k*4 + j)*words + w;
+                        if(columns == 4){
+                            _mm_storeu_si128((__m128i*)row, rows[j]);
+                        }else{
+                            alignas(16) uint32_t lanes[4];
+                            _mm_store_si128((__m128i*)lanes, rows[j]);
+                            for(uint32_t c=0; c < columns; ++c){
+                                row[c] = lanes[c];
+                            }
+                        }
+                    }
+                }
+            }
+        }
+#endif
+        for(; i < end; ++i){
+            for(uint32_t w=0; w < words; ++w){
+                const uint8_t* column = planes + w*4*planeStride;
+                uint32_t v = column[i] | (column[planeStride + i] << 8) | (column[planeStride*2 + i] << 16)
+                           | ((uint32_t)column[planeStride*3 + i] << 24);
+                previous[w] += Unzigzag(v);
+                output[(size_t)i*words + w] = previous[w];
+            }
+        }
+    }
+}
+
+// ============== Public interface ==============
+
+void MeshCodec::EncodeIndices(const unsigned int* indices, unsigned int count, std::vector<unsigned char>& out){
+    EncodeWords(indices, count, 1, out);
+}
+
+bool MeshCodec::DecodeIndices(const unsigned char* data, size_t size, unsigned int* indices, unsigned int count){
+    return DecodeWords(data, size, indices, count, 1);
+}
+
+void MeshCodec::EncodeVertices(const void* vertices, unsigned int count, unsigned int stride, std::vector<unsigned char>& out){
+    EncodeWords(static_cast<const unsigned int*>(vertices), count, stride/4, out);
+}
+
+bool MeshCodec::DecodeVertices(const unsigned char* data, size_t size, void* vertices, unsigned int count, unsigned int stride){
+    return DecodeWords(data, size, static_cast<unsigned int*>(vertices), count, stride/4);
+}
+
+// Layout of an encoded stream:
+//      uint32 element count
+//      uint32 words per element
+//      for each word, 4 byte planes (lowest byte first)
+void MeshCodec::EncodeWords(const unsigned int* input, unsigned int count, unsigned int words, std::vector<unsigned char>& out){
+    Put32(out, count);
+    Put32(out, words);
+    std::vector<uint8_t> planes(count*4);
+    for(unsigned int w=0; w < words; ++w){
+        uint32_t previous = 0;
+        for(unsigned int i=0; i < count; ++i){
+            uint32_t value = input[i*words + w];
+            uint32_t z = Zigzag(value - previous);
+            previous = value;
+            planes[i]           = z & 0xff;
+            planes[i + count]   = (z >> 8) & 0xff;
+            planes[i + count*2] = (z >> 16) & 0xff;
+            planes[i + count*3] = (z >> 24) & 0xff;
+        }
+        for(int b=0; b < 4; ++b){
+            EncodePlane(planes.data() + b*count, count, out);
+        }
+    }
+}
+
+bool MeshCodec::DecodeWords(const unsigned char* data, size_t size, unsigned int* output, unsigned int count, unsigned int words){
+    Reader reader = {data, data + size, true};
+    if(reader.Get32() != count || reader.Get32() != words || !reader.ok){
+        return false;
+    }
+    // Find every plane first, then decode a block of elements of every
+    // plane at a time and rebuild those rows while the block is in cache.
+    // A row reads from every plane at once, so the planes of a block are
+    // spaced by a cache line more than a multiple of 4 KB, or they would
+    // all fall in the same cache sets.
+    const uint32_t planeCount = words*4;
+    static thread_local std::vector<PlaneDecoder> decoders;
+    static thread_local std::vector<uint32_t> tables;
+    static thread_local std::vector<uint8_t> block;
+    decoders.resize(planeCount);
+    if(tables.size() < (size_t)planeCount*kProbScale){
+        tables.resize((size_t)planeCount*kProbScale);
+    }
+    for(uint32_t p=0; p < planeCount; ++p){
+        if(!OpenPlane(reader, decoders[p], tables.data() + (size_t)p*kProbScale, count)){
+            return false;
+        }
+    }
+    const size_t planeStride = kDecodeBlock + 64;
+    if(block.size() < planeStride*planeCount){
+        block.resize(planeStride*planeCount);
+    }
+    std::vector<uint32_t> previous(words, 0);
+    for(uint32_t begin=0; begin < count; begin += kDecodeBlock){
+        const uint32_t end = std::min(count, begin + kDecodeBlock);
+        for(uint32_t p=0; p < planeCount; ++p){
+            DecodePlaneRange(decoders[p], block.data() + p*planeStride, begin, end);
+        }
+        RebuildRows(block.data(), planeStride, words, 0, end - begin, output + (size_t)begin*words, previous.data());
+    }
+    return true;
+}
@@ -0,0 +1,239 @@
+#include "MeshFile.hpp"
+#include "MeshCodec.hpp"
+
+#include <glad/glad.h>
+
+#include <cstring>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+static_assert(sizeof(MeshFileHeader) == 256, "MeshFileHeader must stay 256 bytes");
+static_assert(sizeof(MeshFileHeader) % MeshFile::kAlignment == 0, "Header must keep the data aligned");
+
+namespace{
+    const char kMagic[4] = {'F','T','M','S'};
+
+    // The layout produced by Geometry::Gen, which is
+    // VertexFormat::Normal in VertexBufferLayout
+    // positions: x,y,z
+    // normals:  x,y,z
+    // texcoords: s,t
+    // tangent: t_x,t_y,t_z
+    // bitangent b_x,b_y,b_z
+    const MeshFileAttribute kNormalLayout[] = {
+        {0, 3, GL_FLOAT, sizeof(float)*0},
+        {1, 3, GL_FLOAT, sizeof(float)*3},
+        {2, 2, GL_FLOAT, sizeof(float)*6},
+        {3, 3, GL_FLOAT, sizeof(float)*8},
+        {4, 3, GL_FLOAT, sizeof(float)*11},
+    };
+    const uint32_t kNormalLayoutCount = sizeof(kNormalLayout)/sizeof(kNormalLayout[0]);
+    const uint32_t kNormalLayoutStride = sizeof(float)*14;
+
+    // Rounds 'value' up to the next multiple of the file alignment
+    uint64_t AlignUp(uint64_t value){
+        return (value + MeshFile::kAlignment - 1) & ~uint64_t(MeshFile::kAlignment - 1);
+    }
+
+    // Writes zeros until the stream reaches 'offset'
+    void PadTo(std::ofstream& file, uint64_t offset){
+        static const char zeros[MeshFile::kAlignment] = {0};
+        uint64_t pos = file.tellp();
+        if(offset > pos){
+            file.write(zeros, offset - pos);
+        }
+    }
+}
+
+// Constructor
+MeshFile::MeshFile() : m_header(nullptr){
+}
+
+// Destructor
+MeshFile::~MeshFile(){
+}
+
+// Writes a cooked mesh.
+// The file is written under a temporary name first and then renamed,
+// so a crash half way through never leaves a broken mesh behind.
+bool MeshFile::Cook(Geometry& geometry, const std::string& path, uint64_t sourceKey, bool compress){
+    const float* vertexData = geometry.GetBufferDataPtr();
+    const uint32_t floatCount = geometry.GetBufferDataSize();
+    const uint32_t vertexCount = floatCount / (kNormalLayoutStride/sizeof(float));
+    if(vertexCount == 0){
+        std::cout << "(MeshFile.cpp) ERROR, nothing to cook. Was Gen() called?\n";
+        return false;
+    }
+
+    MeshFileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.headerSize = sizeof(MeshFileHeader);
+    header.vertexCount = vertexCount;
+    header.vertexStride = kNormalLayoutStride;
+    header.attributeCount = kNormalLayoutCount;
+    std::memcpy(header.attributes, kNormalLayout, sizeof(kNormalLayout));
+    header.indexType = GL_UNSIGNED_INT;
+    header.indexCount = geometry.GetIndicesSize();
+    header.sourceKey = sourceKey;
+    header.flags = compress ? kFlagCompressed : 0;
+
+    // Bounds come from the positions at the start of every vertex
+    for(int k=0; k < 3; ++k){
+        header.boundsMin[k] = vertexData[k];
+        header.boundsMax[k] = vertexData[k];
+    }
+    for(uint32_t v=0; v < vertexCount; ++v){
+        const float* p = vertexData + v*(kNormalLayoutStride/sizeof(float));
+        for(int k=0; k < 3; ++k){
+            header.boundsMin[k] = p[k] < header.boundsMin[k] ? p[k] : header.boundsMin[k];
+            header.boundsMax[k] = p[k] > header.boundsMax[k] ? p[k] : header.boundsMax[k];
+        }
+    }
+
+    // The sections either point at the geometry or at its compressed copy
+    const char* vertexBytes = reinterpret_cast<const char*>(vertexData);
+    const char* indexBytes = reinterpret_cast<const char*>(geometry.GetIndicesDataPtr());
+    std::vector<unsigned char> compressedVertices;
+    std::vector<unsigned char> compressedIndices;
+    header.vertexDataSize = uint64_t(vertexCount) * kNormalLayoutStride;
+    header.indexDataSize = uint64_t(header.indexCount) * sizeof(unsigned int);
+    if(compress){
+        MeshCodec::EncodeVertices(vertexData, vertexCount, kNormalLayoutStride, compressedVertices);
+        MeshCodec::EncodeIndices(geometry.GetIndicesDataPtr(), header.indexCount, compressedIndices);
+        vertexBytes = reinterpret_cast<const char*>(compressedVertices.data());
+        indexBytes = reinterpret_cast<const char*>(compressedIndices.data());
+        header.vertexDataSize = compressedVertices.size();
+        header.indexDataSize = compressedIndices.size();
+    }
+
+    header.vertexDataOffset = AlignUp(sizeof(MeshFileHeader));
+    header.indexDataOffset = AlignUp(header.vertexDataOffset + header.vertexDataSize);
+    const std::vector<Meshlet>& meshlets = geometry.GetMeshlets();
+    header.meshletCount = meshlets.size();
+    header.meshletDataOffset = AlignUp(header.indexDataOffset + header.indexDataSize);
+    header.meshletDataSize = uint64_t(header.meshletCount) * sizeof(Meshlet);
+
+    std::string tempPath = path + ".tmp";
+    {
+        std::ofstream file(tempPath.c_str(), std::ios::binary | std::ios::trunc);
+        if(!file.is_open()){
+            std::cout << "(MeshFile.cpp) ERROR, could not write " << tempPath << "\n";
+            return false;
+        }
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        PadTo(file, header.vertexDataOffset);
+        file.write(vertexBytes, header.vertexDataSize);
+        PadTo(file, header.indexDataOffset);
+        file.write(indexBytes, header.indexDataSize);
+        PadTo(file, header.meshletDataOffset);
+        file.write(reinterpret_cast<const char*>(meshlets.data()), header.meshletDataSize);
+        if(!file.good()){
+            std::cout << "(MeshFile.cpp) ERROR, failed while writing " << tempPath << "\n";
+            file.close();
+            std::remove(tempPath.c_str());
+            return false;
+        }
+    }
+    // Replace any older version of the file
+    std::remove(path.c_str());
+    if(std::rename(tempPath.c_str(), path.c_str()) != 0){
+        std::cout << "(MeshFile.cpp) ERROR, could not rename " << tempPath << "\n";
+        std::remove(tempPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+// Maps a cooked mesh and checks that we can use it
+bool MeshFile::Load(const std::string& path, uint64_t sourceKey){
+    m_header = nullptr;
+    m_vertexData.clear();
+    m_indexData.clear();
+    if(!m_file.Open(path)){
+        return false;
+    }
+    const size_t size = m_file.GetSize();
+    const MeshFileHeader* header = reinterpret_cast<const MeshFileHeader*>(m_file.GetData());
+    bool valid = size >= sizeof(MeshFileHeader)
+              && std::memcmp(header->magic, kMagic, sizeof(kMagic)) == 0
+              && header->version == kVersion
+              && header->headerSize == sizeof(MeshFileHeader)
+              && header->sourceKey == sourceKey
+              && (header->flags & ~kFlagCompressed) == 0;
+    const bool compressed = valid && (header->flags & kFlagCompressed) != 0;
+    // Make sure the data is where the header says it is.
+    // Compressed sections have no fixed size, the decoder checks them.
+    valid = valid
+         && header->vertexDataOffset % kAlignment == 0
+         && header->indexDataOffset % kAlignment == 0
+         && (compressed || header->vertexDataSize == uint64_t(header->vertexCount) * header->vertexStride)
+         && (compressed || header->indexDataSize == uint64_t(header->indexCount) * sizeof(unsigned int))
+         && header->vertexDataOffset + header->vertexDataSize <= size
+         && header->indexDataOffset + header->indexDataSize <= size
+         && header->meshletDataOffset % kAlignment == 0
+         && header->meshletDataSize == uint64_t(header->meshletCount) * sizeof(Meshlet)
+         && header->meshletDataOffset + header->meshletDataSize <= size;
+    // We can only draw the layout VertexBufferLayout knows about
+    valid = valid
+         && header->vertexStride == kNormalLayoutStride
+         && header->attributeCount == kNormalLayoutCount
+         && header->indexType == GL_UNSIGNED_INT
+         && std::memcmp(header->attributes, kNormalLayout, sizeof(kNormalLayout)) == 0;
+    if(valid && compressed){
+        m_vertexData.resize(uint64_t(header->vertexCount) * (kNormalLayoutStride/sizeof(float)));
+        m_indexData.resize(header->indexCount);
+        valid = MeshCodec::DecodeVertices(m_file.GetData() + header->vertexDataOffset, header->vertexDataSize,
+                                          m_vertexData.data(), header->vertexCount, kNormalLayoutStride)
+             && MeshCodec::DecodeIndices(m_file.GetData() + header->indexDataOffset, header->indexDataSize,
+                                         m_indexData.data(), header->indexCount);
+        if(!valid){
+            std::cout << "(MeshFile.cpp) ERROR, compressed data in " << path << " is broken\n";
+            m_vertexData.clear();
+            m_indexData.clear();
+        }
+    }
+    if(!valid){
+        m_file.Close();
+        return false;
+    }
+    m_header = header;
+    return true;
+}
+
+const MeshFileHeader& MeshFile::GetHeader() const{
+    return *m_header;
+}
+
+const float* MeshFile::GetBufferDataPtr() const{
+    if(m_header->flags & kFlagCompressed){
+        return m_vertexData.data();
+    }
+    return reinterpret_cast<const float*>(m_file.GetData() + m_header->vertexDataOffset);
+}
+
+unsigned int MeshFile::GetBufferDataSize() const{
+    return m_header->vertexCount * (m_header->vertexStride / sizeof(float));
+}
+
+const unsigned int* MeshFile::GetIndicesDataPtr() const{
+    if(m_header->flags & kFlagCompressed){
+        return m_indexData.data();
+    }
+    return reinterpret_cast<const unsigned int*>(m_file.GetData() + m_header->indexDataOffset);
+}
+
+unsigned int MeshFile::GetIndicesSize() const{
+    return m_header->indexCount;
+}
+
+const Meshlet* MeshFile::GetMeshletsPtr() const{
+    return reinterpret_cast<const Meshlet*>(m_file.GetData() + m_header->meshletDataOffset);
+}
+
+unsigned int MeshFile::GetMeshletsSize() const{
+    return m_header->meshletCount;
+}
@@ -0,0 +1,976 @@
+#include "MeshImporter.hpp"
+#include "MappedFile.hpp"
+#include "Parallel.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+namespace{
+    // ============== Number parsing ==============
+
+    inline bool IsDigit(char c){
+        return c >= '0' && c <= '9';
+    }
+
+    // Spaces within a line
+    inline bool IsSpace(char c){
+        return c == ' ' || c == '\t' || c == '\r';
+    }
+
+    // Powers of ten that a double holds exactly
+    const double kPowersOfTen[] = {
+        1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+
+    // Parses a decimal number such as -12, 0.5 or 1.5e-3 starting at 'p'.
+    // Does not look at the locale, so '.' is always the decimal point.
+    // On success 'p' is moved past the number.
+    bool ParseNumber(const char*& p, const char* end, double& out){
+        const char* start = p;
+        bool negative = false;
+        if(p < end && (*p == '-' || *p == '+')){
+            negative = *p == '-';
+            ++p;
+        }
+        // Keep the first 19 significant digits (they fit in 64 bits)
+        uint64_t mantissa = 0;
+        int digits = 0;
+        int exponent = 0;
+        bool any = false;
+        for(; p < end && IsDigit(*p); ++p){
+            any = true;
+            if(digits < 19){
+                mantissa = mantissa*10 + (*p - '0');
+                digits += mantissa != 0 ? 1 : 0;
+            }else{
+                ++exponent;
+            }
+        }
+        if(p < end && *p == '.'){
+            ++p;
+            for(; p < end && IsDigit(*p); ++p){
+                any = true;
+                if(digits < 19){
+                    mantissa = mantissa*10 + (*p - '0');
+                    digits += mantissa != 0 ? 1 : 0;
+                    --exponent;
+                }
+            }
+        }
+        if(!any){
+            p = start;
+            return false;
+        }
+        if(p < end && (*p == 'e' || *p == 'E')){
+            const char* e = p + 1;
+            bool negativeExponent = false;
+            if(e < end && (*e == '-' || *e == '+')){
+                negativeExponent = *e == '-';
+                ++e;
+            }
+            if(e < end && IsDigit(*e)){
+                int value = 0;
+                for(; e < end && IsDigit(*e); ++e){
+                    value = value < 10000 ? value*10 + (*e - '0') : value;
+                }
+                exponent += negativeExponent ? -value : value;
+                p = e;
+            }
+        }
+        double result = (double)mantissa;
+        if(mantissa != 0){
+            while(exponent > 22){
+                result *= 1e22;
+                exponent -= 22;
+            }
+            while(exponent < -22){
+                result /= 1e22;
+                exponent += 22;
+            }
+            result = exponent >= 0 ? result * kPowersOfTen[exponent] : result / kPowersOfTen[-exponent];
+        }
+        out = negative ? -result : result;
+        return true;
+    }
+
+    bool ParseFloat(const char*& p, const char* end, float& out){
+        double value;
+        if(!ParseNumber(p, end, value)){
+            return false;
+        }
+        out = (float)value;
+        return true;
+    }
+
+    // Parses a whole number such as 12 or -3
+    bool ParseInt(const char*& p, const char* end, int& out){
+        bool negative = false;
+        const char* start = p;
+        if(p < end && (*p == '-' || *p == '+')){
+            negative = *p == '-';
+            ++p;
+        }
+        if(p >= end || !IsDigit(*p)){
+            p = start;
+            return false;
+        }
+        int64_t value = 0;
+        for(; p < end && IsDigit(*p); ++p){
+            value = value < INT32_MAX ? value*10 + (*p - '0') : value;
+        }
+        value = std::min<int64_t>(value, INT32_MAX);
+        out = (int)(negative ? -value : value);
+        return true;
+    }
+
+    // ============== Welding ==============
+
+    // Hands out one index per distinct (position, texture coordinate).
+    // Uses open addressing on the raw bits of the five floats.
+    class VertexWelder{
+    public:
+        // 'expected' is a guess of how many distinct vertices there are
+        explicit VertexWelder(size_t expected){
+            size_t capacity = 64;
+            while(capacity < expected*2){
+                capacity *= 2;
+            }
+            m_slots.assign(capacity, kEmpty);
+            m_vertices.reserve(expected*5);
+        }
+
+        // Returns the index of the vertex, adding it if it is new
+        uint32_t Add(float x, float y, float z, float s, float t){
+            // Adding 0 turns -0 into +0 so that they weld together
+            const float vertex[5] = {x + 0.0f, y + 0.0f, z + 0.0f, s + 0.0f, t + 0.0f};
+            uint32_t bits[5];
+            std::memcpy(bits, vertex, sizeof(bits));
+            size_t mask = m_slots.size() - 1;
+            size_t slot = Hash(bits) & mask;
+            while(m_slots[slot] != kEmpty){
+                if(std::memcmp(&m_vertices[m_slots[slot]*5], vertex, sizeof(vertex)) == 0){
+                    return m_slots[slot];
+                }
+                slot = (slot + 1) & mask;
+            }
+            uint32_t index = GetCount();
+            m_slots[slot] = index;
+            m_vertices.insert(m_vertices.end(), vertex, vertex + 5);
+            if(GetCount()*2 > m_slots.size()){
+                Grow();
+            }
+            return index;
+        }
+
+        // Number of distinct vertices so far
+        uint32_t GetCount() const{
+            return m_vertices.size() / 5;
+        }
+
+        // Copies the welded vertices and 'indices' into the geometry
+        void Output(const std::vector<uint32_t>& indices, Geometry& geometry) const{
+            geometry.Reserve(GetCount(), indices.size());
+            for(uint32_t i=0; i < GetCount(); ++i){
+                const float* v = &m_vertices[i*5];
+                geometry.AddVertex(v[0], v[1], v[2], v[3], v[4]);
+            }
+            for(size_t i=0; i < indices.size(); ++i){
+                geometry.AddIndex(indices[i]);
+            }
+        }
+
+    private:
+        static const uint32_t kEmpty = 0xffffffff;
+
+        static size_t Hash(const uint32_t bits[5]){
+            uint64_t h = 0;
+            for(int i=0; i < 5; ++i){
+                h = (h ^ bits[i]) * 0x9E3779B97F4A7C15ull;
+                h ^= h >> 29;
+            }
+            return (size_t)h;
+        }
+
+        // Doubles the table and puts every vertex back in
+        void Grow(){
+            std::vector<uint32_t> slots(m_slots.size()*2, kEmpty);
+            size_t mask = slots.size() - 1;
+            for(uint32_t i=0; i < GetCount(); ++i){
+                uint32_t bits[5];
+                std::memcpy(bits, &m_vertices[i*5], sizeof(bits));
+                size_t slot = Hash(bits) & mask;
+                while(slots[slot] != kEmpty){
+                    slot = (slot + 1) & mask;
+                }
+                slots[slot] = i;
+            }
+            m_slots.swap(slots);
+        }
+
+        std::vector<uint32_t> m_slots;
+        std::vector<float> m_vertices;
+    };
+
+    // ============== OBJ ==============
+
+    // OBJ files smaller than this are not worth splitting
+    const size_t kObjMinChunkBytes = 256*1024;
+
+    // One corner of a face as written in the file
+    struct ObjCorner{
+        enum Flags : uint8_t { kRelativePosition = 1, kRelativeTexcoord = 2, kNoTexcoord = 4 };
+        // Zero based. Relative (negative) indices are stored relative
+        // to the start of the chunk and fixed up once chunks are merged.
+        int32_t position;
+        int32_t texcoord;
+        uint8_t flags;
+    };
+
+    // A range of whole lines, parsed by one thread
+    struct ObjChunk{
+        const char* begin;
+        const char* end;
+        // x,y,z for every 'v' line
+        std::vector<float> positions;
+        // s,t for every 'vt' line
+        std::vector<float> texcoords;
+        // Three corners per triangle (polygons are fanned)
+        std::vector<ObjCorner> corners;
+        // Line that could not be parsed (null if none)
+        const char* error;
+    };
+
+    // Parses one corner such as 3, 3/1, 3//2 or 3/1/2
+    bool ParseObjCorner(const char*& p, const char* end, const ObjChunk& chunk, ObjCorner& corner){
+        int position;
+        if(!ParseInt(p, end, position) || position == 0){
+            return false;
+        }
+        corner.flags = ObjCorner::kNoTexcoord;
+        corner.texcoord = 0;
+        if(position > 0){
+            corner.position = position - 1;
+        }else{
+            corner.position = (int32_t)(chunk.positions.size()/3) + position;
+            corner.flags |= ObjCorner::kRelativePosition;
+        }
+        if(p < end && *p == '/'){
+            ++p;
+            int texcoord;
+            if(ParseInt(p, end, texcoord)){
+                if(texcoord == 0){
+                    return false;
+                }
+                corner.flags &= ~ObjCorner::kNoTexcoord;
+                if(texcoord > 0){
+                    corner.texcoord = texcoord - 1;
+                }else{
+                    corner.texcoord = (int32_t)(chunk.texcoords.size()/2) + texcoord;
+                    corner.flags |= ObjCorner::kRelativeTexcoord;
+                }
+            }
+            // Normals are rebuilt by Geometry, so skip them
+            if(p < end && *p == '/'){
+                ++p;
+                int normal;
+                ParseInt(p, end, normal);
+            }
+        }
+        return true;
+    }
+
+    void ParseObjChunk(ObjChunk& chunk){
+        std::vector<ObjCorner> face;
+        const char* p = chunk.begin;
+        const char* end = chunk.end;
+        chunk.error = nullptr;
+        while(p < end){
+            const char* lineEnd = static_cast<const char*>(std::memchr(p, '\n', end - p));
+            lineEnd = lineEnd != nullptr ? lineEnd : end;
+            while(p < lineEnd && IsSpace(*p)){
+                ++p;
+            }
+            const char* line = p;
+            size_t length = lineEnd - p;
+            if(length > 2 && p[0] == 'v' && IsSpace(p[1])){
+                p += 2;
+                float xyz[3] = {0.0f, 0.0f, 0.0f};
+                for(int k=0; k < 3; ++k){
+                    while(p < lineEnd && IsSpace(*p)){
+                        ++p;
+                    }
+                    if(!ParseFloat(p, lineEnd, xyz[k])){
+                        chunk.error = line;
+                        return;
+                    }
+                }
+                chunk.positions.insert(chunk.positions.end(), xyz, xyz + 3);
+            }else if(length > 3 && p[0] == 'v' && p[1] == 't' && IsSpace(p[2])){
+                p += 3;
+                float st[2] = {0.0f, 0.0f};
+                for(int k=0; k < 2; ++k){
+                    while(p < lineEnd && IsSpace(*p)){
+                        ++p;
+                    }
+                    // 't' is optional in the format
+                    if(!ParseFloat(p, lineEnd, st[k]) && k == 0){
+                        chunk.error = line;
+                        return;
+                    }
+                }
+                chunk.texcoords.insert(chunk.texcoords.end(), st, st + 2);
+            }else if(length > 2 && p[0] == 'f' && IsSpace(p[1])){
+                p += 2;
+                face.clear();
+                while(true){
+                    while(p < lineEnd && IsSpace(*p)){
+                        ++p;
+                    }
+                    if(p >= lineEnd){
+                        break;
+                    }
+                    ObjCorner corner;
+                    if(!ParseObjCorner(p, lineEnd, chunk, corner)){
+                        chunk.error = line;
+                        return;
+                    }
+                    face.push_back(corner);
+                }
+                // Turn polygons into a fan of triangles
+                for(size_t i=2; i < face.size(); ++i){
+                    chunk.corners.push_back(face[0]);
+                    chunk.corners.push_back(face[i-1]);
+                    chunk.corners.push_back(face[i]);
+                }
+            }
+            // Everything else (vn, o, g, s, usemtl, comments...) is ignored
+            p = lineEnd + 1;
+        }
+    }
+
+    // ============== JSON (just enough for glTF) ==============
+
+    struct JsonValue{
+        enum Type { kNull, kBool, kNumber, kString, kArray, kObject };
+        Type type = kNull;
+        double number = 0.0;
+        std::string string;
+        // Elements of an array, or the values of an object
+        std::vector<JsonValue> items;
+        // Keys of an object (same order as 'items')
+        std::vector<std::string> keys;
+
+        // Retrieve a member of an object (null if missing)
+        const JsonValue* Find(const char* key) const{
+            for(size_t i=0; i < keys.size(); ++i){
+                if(keys[i] == key){
+                    return &items[i];
+                }
+            }
+            return nullptr;
+        }
+        // Retrieve an element of an array (null if out of range)
+        const JsonValue* At(size_t index) const{
+            return type == kArray && index < items.size() ? &items[index] : nullptr;
+        }
+        // Retrieve a number member, or 'fallback' if there is none
+        double GetNumber(const char* key, double fallback) const{
+            const JsonValue* value = Find(key);
+            return value != nullptr && value->type == kNumber ? value->number : fallback;
+        }
+        // Retrieve a string member, or "" if there is none
+        std::string GetString(const char* key) const{
+            const JsonValue* value = Find(key);
+            return value != nullptr && value->type == kString ? value->string : std::string();
+        }
+    };
+
+    // Deeper nesting than this is treated as a broken file
+    const int kJsonMaxDepth = 64;
+
+    void SkipJsonSpace(const char*& p, const char* end){
+        while(p < end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r')){
+            ++p;
+        }
+    }
+
+    // Appends the code point 'c' to 'out' as UTF-8
+    void AppendUtf8(std::string& out, uint32_t c){
+        if(c < 0x80){
+            out += (char)c;
+        }else if(c < 0x800){
+            out += (char)(0xC0 | (c >> 6));
+            out += (char)(0x80 | (c & 0x3F));
+        }else{
+            out += (char)(0xE0 | (c >> 12));
+            out += (char)(0x80 | ((c >> 6) & 0x3F));
+            out += (char)(0x80 | (c & 0x3F));
+        }
+    }
+
+    bool ParseJsonString(const char*& p, const char* end, std::string& out){
+        if(p >= end || *p != '"'){
+            return false;
+        }
+        ++p;
+        while(p < end && *p != '"'){
+            if(*p != '\\'){
+                out += *p++;
+                continue;
+            }
+            if(++p >= end){
+                return false;
+            }
+            char c = *p++;
+            switch(c){
+                case 'b': out += '\b'; break;
+                case 'f': out += '\f'; break;
+                case 'n': out += '\n'; break;
+                case 'r': out += '\r'; break;
+                case 't': out += '\t'; break;
+                case 'u':{
+                    if(end - p < 4){
+                        return false;
+                    }
+                    uint32_t code = 0;
+                    for(int i=0; i < 4; ++i, ++p){
+                        char h = *p;
+                        code <<= 4;
+                        if(IsDigit(h)) code |= h - '0';
+                        else if(h >= 'a' && h <= 'f') code |= h - 'a' + 10;
+                        else if(h >= 'A' && h <= 'F') code |= h - 'A' + 10;
+                        else return false;
+                    }
+                    AppendUtf8(out, code);
+                    break;
+                }
+                default: out += c; break;
+            }
+        }
+        if(p >= end){
+            return false;
+        }
+        ++p;
+        return true;
+    }
+
+    bool ParseJsonValue(const char*& p, const char* end, JsonValue& out, int depth){
+        SkipJsonSpace(p, end);
+        if(p >= end || depth > kJsonMaxDepth){
+            return false;
+        }
+        if(*p == '{'){
+            out.type = JsonValue::kObject;
+            ++p;
+            SkipJsonSpace(p, end);
+            if(p < end && *p == '}'){
+                ++p;
+                return true;
+            }
+            while(true){
+                SkipJsonSpace(p, end);
+                out.keys.emplace_back();
+                if(!ParseJsonString(p, end, out.keys.back())){
+                    return false;
+                }
+                SkipJsonSpace(p, end);
+                if(p >= end || *p != ':'){
+                    return false;
+                }
+                ++p;
+                out.items.emplace_back();
+                if(!ParseJsonValue(p, end, out.items.back(), depth+1)){
+                    return false;
+                }
+                SkipJsonSpace(p, end);
+                if(p < end && *p == ','){
+                    ++p;
+                    continue;
+                }
+                if(p < end && *p == '}'){
+                    ++p;
+                    return true;
+                }
+                return false;
+            }
+        }
+        if(*p == '['){
+            out.type = JsonValue::kArray;
+            ++p;
+            SkipJsonSpace(p, end);
+            if(p < end && *p == ']'){
+                ++p;
+                return true;
+            }
+            while(true){
+                out.items.emplace_back();
+                if(!ParseJsonValue(p, end, out.items.back(), depth+1)){
+                    return false;
+                }
+                SkipJsonSpace(p, end);
+                if(p < end && *p == ','){
+                    ++p;
+                    continue;
+                }
+                if(p < end && *p == ']'){
+                    ++p;
+                    return true;
+                }
+                return false;
+            }
+        }
+        if(*p == '"'){
+            out.type = JsonValue::kString;
+            return ParseJsonString(p, end, out.string);
+        }
+        if(end - p >= 4 && std::memcmp(p, "true", 4) == 0){
+            out.type = JsonValue::kBool;
+            out.number = 1.0;
+            p += 4;
+            return true;
+        }
+        if(end - p >= 5 && std::memcmp(p, "false", 5) == 0){
+            out.type = JsonValue::kBool;
+            p += 5;
+            return true;
+        }
+        if(end - p >= 4 && std::memcmp(p, "null", 4) == 0){
+            p += 4;
+            return true;
+        }
+        out.type = JsonValue::kNumber;
+        return ParseNumber(p, end, out.number);
+    }
+
+    // ============== glTF ==============
+
+    // A range of bytes inside a buffer
+    struct ByteRange{
+        const unsigned char* data;
+        size_t size;
+        size_t stride;
+    };
+
+    // Component types used by accessors
+    const int kByte = 5120, kUnsignedByte = 5121, kShort = 5122,
+              kUnsignedShort = 5123, kUnsignedInt = 5125, kFloat = 5126;
+    // glTF mode for triangle lists
+    const int kTriangles = 4;
+
+    int ComponentSize(int componentType){
+        switch(componentType){
+            case kByte: case kUnsignedByte: return 1;
+            case kShort: case kUnsignedShort: return 2;
+            case kUnsignedInt: case kFloat: return 4;
+            default: return 0;
+        }
+    }
+
+    int ComponentCount(const std::string& type){
+        if(type == "SCALAR") return 1;
+        if(type == "VEC2") return 2;
+        if(type == "VEC3") return 3;
+        if(type == "VEC4") return 4;
+        return 0;
+    }
+
+    // Decodes base64 text (as used by data: URIs)
+    bool DecodeBase64(const char* text, size_t length, std::vector<unsigned char>& out){
+        uint32_t bits = 0;
+        int count = 0;
+        for(size_t i=0; i < length; ++i){
+            char c = text[i];
+            int value;
+            if(c >= 'A' && c <= 'Z') value = c - 'A';
+            else if(c >= 'a' && c <= 'z') value = c - 'a' + 26;
+            else if(IsDigit(c)) value = c - '0' + 52;
+            else if(c == '+' || c == '-') value = 62;
+            else if(c == '/' || c == '_') value = 63;
+            else if(c == '=') break;
+            else return false;
+            bits = (bits << 6) | value;
+            count += 6;
+            if(count >= 8){
+                count -= 8;
+                out.push_back((bits >> count) & 0xff);
+            }
+        }
+        return true;
+    }
+
+    // Everything an accessor says about where its data is
+    struct Accessor{
+        ByteRange range;
+        size_t count;
+        int componentType;
+        int components;
+        bool normalized;
+    };
+
+    // Looks up accessor 'index' and checks that all of its data is
+    // inside its buffer view
+    bool GetAccessor(const JsonValue& root, const std::vector<ByteRange>& views, int index, Accessor& accessor){
+        const JsonValue* accessors = root.Find("accessors");
+        const JsonValue* json = accessors != nullptr ? accessors->At(index) : nullptr;
+        if(json == nullptr || index < 0 || json->Find("sparse") != nullptr){
+            return false;
+        }
+        accessor.count = (size_t)json->GetNumber("count", 0);
+        accessor.componentType = (int)json->GetNumber("componentType", 0);
+        accessor.components = ComponentCount(json->GetString("type"));
+        const JsonValue* normalized = json->Find("normalized");
+        accessor.normalized = normalized != nullptr && normalized->number != 0.0;
+        size_t elementSize = ComponentSize(accessor.componentType) * accessor.components;
+        int viewIndex = (int)json->GetNumber("bufferView", -1);
+        if(elementSize == 0 || viewIndex < 0 || viewIndex >= (int)views.size()){
+            return false;
+        }
+        const ByteRange& view = views[viewIndex];
+        size_t offset = (size_t)json->GetNumber("byteOffset", 0);
+        size_t stride = view.stride != 0 ? view.stride : elementSize;
+        if(accessor.count > 0 && offset + (accessor.count-1)*stride + elementSize > view.size){
+            return false;
+        }
+        accessor.range.data = view.data + offset;
+        accessor.range.size = view.size - offset;
+        accessor.range.stride = stride;
+        return true;
+    }
+
+    // Reads component 'c' of element 'i' as a float
+    float ReadComponent(const Accessor& accessor, size_t i, int c){
+        const unsigned char* p = accessor.range.data + i*accessor.range.stride + c*ComponentSize(accessor.componentType);
+        switch(accessor.componentType){
+            case kFloat:{
+                float value;
+                std::memcpy(&value, p, sizeof(value));
+                return value;
+            }
+            case kUnsignedByte:{
+                return accessor.normalized ? p[0] / 255.0f : (float)p[0];
+            }
+            case kUnsignedShort:{
+                uint16_t value;
+                std::memcpy(&value, p, sizeof(value));
+                return accessor.normalized ? value / 65535.0f : (float)value;
+            }
+            default:
+                return 0.0f;
+        }
+    }
+
+    // Reads index 'i' of an index accessor
+    uint32_t ReadIndex(const Accessor& accessor, size_t i){
+        const unsigned char* p = accessor.range.data + i*accessor.range.stride;
+        switch(accessor.componentType){
+            case kUnsignedByte: return p[0];
+            case kUnsignedShort:{
+                uint16_t value;
+                std::memcpy(&value, p, sizeof(value));
+                return value;
+            }
+            default:{
+                uint32_t value;
+                std::memcpy(&value, p, sizeof(value));
+                return value;
+            }
+        }
+    }
+
+    // The file name extension in lower case (without the dot)
+    std::string GetExtension(const std::string& path){
+        size_t dot = path.find_last_of('.');
+        if(dot == std::string::npos){
+            return std::string();
+        }
+        std::string extension = path.substr(dot + 1);
+        for(size_t i=0; i < extension.size(); ++i){
+            extension[i] = (char)std::tolower((unsigned char)extension[i]);
+        }
+        return extension;
+    }
+
+    // The directory part of a path including the trailing separator
+    std::string GetDirectory(const std::string& path){
+        size_t slash = path.find_last_of("/\\");
+        return slash == std::string::npos ? std::string() : path.substr(0, slash + 1);
+    }
+}
+
+// ============== Public interface ==============
+
+bool MeshImporter::Load(const std::string& path, Geometry& geometry){
+    std::string extension = GetExtension(path);
+    if(extension == "obj"){
+        return LoadOBJ(path, geometry);
+    }
+    if(extension == "gltf" || extension == "glb"){
+        return LoadGLTF(path, geometry);
+    }
+    std::cout << "(MeshImporter.cpp) ERROR, unknown mesh format: " << path << "\n";
+    return false;
+}
+
+bool MeshImporter::LoadOBJ(const std::string& path, Geometry& geometry){
+    MappedFile file;
+    if(!file.Open(path)){
+        std::cout << "(MeshImporter.cpp) ERROR, could not open " << path << "\n";
+        return false;
+    }
+    return ParseOBJ(reinterpret_cast<const char*>(file.GetData()), file.GetSize(), geometry);
+}
+
+bool MeshImporter::LoadGLTF(const std::string& path, Geometry& geometry){
+    MappedFile file;
+    if(!file.Open(path)){
+        std::cout << "(MeshImporter.cpp) ERROR, could not open " << path << "\n";
+        return false;
+    }
+    return ParseGLTF(reinterpret_cast<const char*>(file.GetData()), file.GetSize(), GetDirectory(path), geometry);
+}
+
+// OBJ is parsed in two steps:
+// (1) In parallel, every chunk of lines collects its own positions,
+//     texture coordinates and triangles.
+// (2) In file order, the chunks are joined and every corner is welded
+//     into a final vertex.
+bool MeshImporter::ParseOBJ(const char* data, size_t size, Geometry& geometry){
+    // Split into chunks that each start at the beginning of a line
+    unsigned int chunkCount = (unsigned int)std::min<size_t>(GetWorkerCount()*4, size/kObjMinChunkBytes + 1);
+    std::vector<ObjChunk> chunks(chunkCount);
+    const char* end = data + size;
+    const char* begin = data;
+    for(unsigned int i=0; i < chunkCount; ++i){
+        const char* chunkEnd = end;
+        if(i + 1 < chunkCount){
+            chunkEnd = std::max(begin, data + size*(i+1)/chunkCount);
+            const char* newline = static_cast<const char*>(std::memchr(chunkEnd, '\n', end - chunkEnd));
+            chunkEnd = newline != nullptr ? newline + 1 : end;
+        }
+        chunks[i].begin = begin;
+        chunks[i].end = chunkEnd;
+        begin = chunkEnd;
+    }
+
+    ParallelFor(chunkCount, 1, [&chunks](unsigned int first, unsigned int last){
+        for(unsigned int i=first; i < last; ++i){
+            ParseObjChunk(chunks[i]);
+        }
+    });
+
+    // Join the positions and texture coordinates of all chunks
+    std::vector<float> positions;
+    std::vector<float> texcoords;
+    std::vector<uint32_t> positionBase(chunkCount);
+    std::vector<uint32_t> texcoordBase(chunkCount);
+    size_t cornerCount = 0;
+    for(unsigned int i=0; i < chunkCount; ++i){
+        if(chunks[i].error != nullptr){
+            const char* lineEnd = static_cast<const char*>(std::memchr(chunks[i].error, '\n', end - chunks[i].error));
+            std::cout << "(MeshImporter.cpp) ERROR, could not parse OBJ line: "
+                      << std::string(chunks[i].error, lineEnd != nullptr ? lineEnd : end) << "\n";
+            return false;
+        }
+        positionBase[i] = positions.size()/3;
+        texcoordBase[i] = texcoords.size()/2;
+        positions.insert(positions.end(), chunks[i].positions.begin(), chunks[i].positions.end());
+        texcoords.insert(texcoords.end(), chunks[i].texcoords.begin(), chunks[i].texcoords.end());
+        cornerCount += chunks[i].corners.size();
+    }
+    const int64_t positionCount = positions.size()/3;
+    const int64_t texcoordCount = texcoords.size()/2;
+
+    VertexWelder welder(positionCount);
+    std::vector<uint32_t> indices;
+    indices.reserve(cornerCount);
+    for(unsigned int i=0; i < chunkCount; ++i){
+        const std::vector<ObjCorner>& corners = chunks[i].corners;
+        for(size_t c=0; c < corners.size(); ++c){
+            const ObjCorner& corner = corners[c];
+            int64_t position = corner.position;
+            if(corner.flags & ObjCorner::kRelativePosition){
+                position += positionBase[i];
+            }
+            int64_t texcoord = corner.texcoord;
+            if(corner.flags & ObjCorner::kRelativeTexcoord){
+                texcoord += texcoordBase[i];
+            }
+            bool hasTexcoord = (corner.flags & ObjCorner::kNoTexcoord) == 0;
+            if(position < 0 || position >= positionCount
+               || (hasTexcoord && (texcoord < 0 || texcoord >= texcoordCount))){
+                std::cout << "(MeshImporter.cpp) ERROR, OBJ face refers to a missing vertex\n";
+                return false;
+            }
+            const float* xyz = &positions[position*3];
+            float s = hasTexcoord ? texcoords[texcoord*2] : 0.0f;
+            float t = hasTexcoord ? texcoords[texcoord*2+1] : 0.0f;
+            indices.push_back(welder.Add(xyz[0], xyz[1], xyz[2], s, t));
+        }
+    }
+    welder.Output(indices, geometry);
+    return true;
+}
+
+bool MeshImporter::ParseGLTF(const char* data, size_t size, const std::string& directory, Geometry& geometry){
+    // A .glb is a small header followed by a JSON chunk and a binary chunk
+    const char* json = data;
+    size_t jsonSize = size;
+    ByteRange binary = {nullptr, 0, 0};
+    if(size >= 12 && std::memcmp(data, "glTF", 4) == 0){
+        const uint32_t kChunkJson = 0x4E4F534A;
+        const uint32_t kChunkBinary = 0x004E4942;
+        json = nullptr;
+        size_t offset = 12;
+        while(offset + 8 <= size){
+            uint32_t chunkSize;
+            uint32_t chunkType;
+            std::memcpy(&chunkSize, data + offset, 4);
+            std::memcpy(&chunkType, data + offset + 4, 4);
+            offset += 8;
+            if(chunkSize > size - offset){
+                break;
+            }
+            if(chunkType == kChunkJson && json == nullptr){
+                json = data + offset;
+                jsonSize = chunkSize;
+            }else if(chunkType == kChunkBinary && binary.data == nullptr){
+                binary.data = reinterpret_cast<const unsigned char*>(data + offset);
+                binary.size = chunkSize;
+            }
+            offset += (chunkSize + 3) & ~3u;
+        }
+        if(json == nullptr){
+            std::cout << "(MeshImporter.cpp) ERROR, glb file has no JSON chunk\n";
+            return false;
+        }
+    }
+
+    JsonValue root;
+    const char* p = json;
+    if(!ParseJsonValue(p, json + jsonSize, root, 0) || root.type != JsonValue::kObject){
+        std::cout << "(MeshImporter.cpp) ERROR, glTF JSON could not be parsed\n";
+        return false;
+    }
+
+    // Buffers: the glb binary chunk, base64 data, or separate files
+    std::vector<ByteRange> buffers;
+    std::vector<std::unique_ptr<MappedFile>> files;
+    std::vector<std::unique_ptr<std::vector<unsigned char>>> decoded;
+    const JsonValue* jsonBuffers = root.Find("buffers");
+    for(size_t i=0; jsonBuffers != nullptr && i < jsonBuffers->items.size(); ++i){
+        const JsonValue& buffer = jsonBuffers->items[i];
+        std::string uri = buffer.GetString("uri");
+        ByteRange range = {nullptr, 0, 0};
+        if(uri.empty()){
+            range = binary;
+        }else if(uri.compare(0, 5, "data:") == 0){
+            size_t comma = uri.find(',');
+            decoded.emplace_back(new std::vector<unsigned char>());
+            if(comma == std::string::npos || !DecodeBase64(uri.data() + comma + 1, uri.size() - comma - 1, *decoded.back())){
+                std::cout << "(MeshImporter.cpp) ERROR, bad data URI in glTF buffer " << i << "\n";
+                return false;
+            }
+            range.data = decoded.back()->data();
+            range.size = decoded.back()->size();
+        }else{
+            files.emplace_back(new MappedFile());
+            if(!files.back()->Open(directory + uri)){
+                std::cout << "(MeshImporter.cpp) ERROR, could not open glTF buffer " << directory + uri << "\n";
+                return false;
+            }
+            range.data = files.back()->GetData();
+            range.size = files.back()->GetSize();
+        }
+        if((size_t)buffer.GetNumber("byteLength", 0) > range.size){
+            std::cout << "(MeshImporter.cpp) ERROR, glTF buffer " << i << " is too short\n";
+            return false;
+        }
+        buffers.push_back(range);
+    }
+
+    std::vector<ByteRange> views;
+    const JsonValue* jsonViews = root.Find("bufferViews");
+    for(size_t i=0; jsonViews != nullptr && i < jsonViews->items.size(); ++i){
+        const JsonValue& view = jsonViews->items[i];
+        int buffer = (int)view.GetNumber("buffer", -1);
+        size_t offset = (size_t)view.GetNumber("byteOffset", 0);
+        size_t length = (size_t)view.GetNumber("byteLength", 0);
+        if(buffer < 0 || buffer >= (int)buffers.size() || offset + length > buffers[buffer].size){
+            std::cout << "(MeshImporter.cpp) ERROR, glTF buffer view " << i << " is out of range\n";
+            return false;
+        }
+        ByteRange range = {buffers[buffer].data + offset, length, (size_t)view.GetNumber("byteStride", 0)};
+        views.push_back(range);
+    }
+
+    VertexWelder welder(0);
+    std::vector<uint32_t> indices;
+    std::vector<uint32_t> remap;
+    const JsonValue* meshes = root.Find("meshes");
+    for(size_t m=0; meshes != nullptr && m < meshes->items.size(); ++m){
+        const JsonValue* primitives = meshes->items[m].Find("primitives");
+        for(size_t k=0; primitives != nullptr && k < primitives->items.size(); ++k){
+            const JsonValue& primitive = primitives->items[k];
+            if((int)primitive.GetNumber("mode", kTriangles) != kTriangles){
+                std::cout << "(MeshImporter.cpp) Skipping glTF primitive that is not a triangle list\n";
+                continue;
+            }
+            const JsonValue* attributes = primitive.Find("attributes");
+            Accessor positions;
+            if(attributes == nullptr
+               || !GetAccessor(root, views, (int)attributes->GetNumber("POSITION", -1), positions)
+               || positions.components != 3 || positions.componentType != kFloat){
+                std::cout << "(MeshImporter.cpp) ERROR, glTF primitive has no usable POSITION\n";
+                return false;
+            }
+            Accessor texcoords;
+            bool hasTexcoords = GetAccessor(root, views, (int)attributes->GetNumber("TEXCOORD_0", -1), texcoords)
+                             && texcoords.components == 2 && texcoords.count == positions.count;
+
+            // Weld this primitive's vertices into the shared list.
+            // glTF puts the origin of texture space at the top left.
+            remap.resize(positions.count);
+            for(size_t i=0; i < positions.count; ++i){
+                float s = hasTexcoords ? ReadComponent(texcoords, i, 0) : 0.0f;
+                float t = hasTexcoords ? 1.0f - ReadComponent(texcoords, i, 1) : 0.0f;
+                remap[i] = welder.Add(ReadComponent(positions, i, 0), ReadComponent(positions, i, 1),
+                                      ReadComponent(positions, i, 2), s, t);
+            }
+
+            int indexAccessor = (int)primitive.GetNumber("indices", -1);
+            if(indexAccessor < 0){
+                for(size_t i=0; i + 2 < positions.count; i += 3){
+                    indices.insert(indices.end(), {remap[i], remap[i+1], remap[i+2]});
+                }
+                continue;
+            }
+            Accessor source;
+            if(!GetAccessor(root, views, indexAccessor, source) || source.components != 1
+               || (source.componentType != kUnsignedByte && source.componentType != kUnsignedShort
+                   && source.componentType != kUnsignedInt)){
+                std::cout << "(MeshImporter.cpp) ERROR, glTF primitive has unusable indices\n";
+                return false;
+            }
+            for(size_t i=0; i + 2 < source.count; i += 3){
+                uint32_t a = ReadIndex(source, i), b = ReadIndex(source, i+1), c = ReadIndex(source, i+2);
+                if(a >= positions.count || b >= positions.count || c >= positions.count){
+                    std::cout << "(MeshImporter.cpp) ERROR, glTF index out of range\n";
+                    return false;
+                }
+                indices.insert(indices.end(), {remap[a], remap[b], remap[c]});
+            }
+        }
+    }
+    if(indices.empty()){
+        std::cout << "(MeshImporter.cpp) ERROR, glTF file has no triangles\n";
+        return false;
+    }
+    welder.Output(indices, geometry);
+    return true;
+}
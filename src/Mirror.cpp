@@ -1,59 +1,74 @@
 #include "Mirror.hpp"
+#include "GLState.hpp"
+#include "ShaderManager.hpp"
 #include "Camera.hpp"
 #include "Error.hpp"
 
 // Sets up a mirror with a predefined camera
-Mirror::Mirror(std::string frag_name, int camera) {
+Mirror::Mirror(std::string frag_name, int camera) : m_name(frag_name) {
     // (1) ======= Setup shader
-    m_fboShader = std::make_shared<Shader>();
-    // Setup shaders for the Framebuffer Object
-    std::string fboVertexShader = m_fboShader->LoadShader("./shaders/fboVert.glsl");
-    std::string fboFragmentShader = m_fboShader->LoadShader(frag_name);
-    // Actually create our shader
-    m_fboShader->CreateShader(fboVertexShader,fboFragmentShader);       
+    // Framebuffers and mirrors with the same fragment shader share one program
+    m_fboShader = ShaderManager::Instance().Get("./shaders/fboVert.glsl", frag_name);
+    m_diffuseMapUniform = m_fboShader->GetUniform("u_DiffuseMap", GL_INT);
     // Skipping the screen quad setup, we do not need it since we will draw on the default textured quad.
     camera_id = camera;
 
     drawn_yet = false;
 }
 
+// The framebuffer and its attachments are GpuResources, which
+// delete themselves
 Mirror::~Mirror() {
 
 }
 
 void Mirror::Bind() {
     // Make sure we are updating the correct 'buffers'
-    m_vertexBufferLayout.Bind();
+    if(m_mesh!=nullptr){
+        m_mesh->Bind();
+    }
     // Diffuse map is 0 by default, but it is good to set it explicitly
     if (drawn_yet) {
-        glBindTexture(GL_TEXTURE_2D, m_colorBuffer_id);
+        GLState::BindTexture(0, GL_TEXTURE_2D, m_colorBuffer.Get());
     }
     else {
         m_textureDiffuse.Bind(0);
     }
 }
 
+// Whatever Bind puts in slot 0
+GLuint Mirror::GetMaterialTexture() const {
+    return drawn_yet ? m_colorBuffer.Get() : m_textureDiffuse.GetId();
+}
+
+// Each mirror binds its own texture, which may be a render target
+bool Mirror::CanInstance() const {
+    return false;
+}
+
 // For our Mirror, we just use a regular Textured Quad, we use the inherited function from Object.hpp
 // We will not have to set up a Screen quad
 // We also will not have to modify Render() since Render() uses a one size fits all Bind() call to bind both the vertices and the texture
 
 void Mirror::CreateBuffer(int width, int height) {
     // Generate a framebuffer
-    glGenFramebuffers(1, &m_fbo_id);
+    m_fbo.Create(GpuResourceType::Framebuffer, m_name, "Mirror");
     // Select the buffer we have just generated
     BindBuffer();
     // Create a color attachement texture
-    glGenTextures(1, &m_colorBuffer_id);
-    glBindTexture(GL_TEXTURE_2D, m_colorBuffer_id);
+    m_colorBuffer.Create(GpuResourceType::Texture, m_name, "Mirror");
+    GLState::BindTexture(0, GL_TEXTURE_2D, m_colorBuffer.Get());
     glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, NULL); // texture size
+    m_colorBuffer.SetBytes(GpuResources::GetImageBytes(GL_RGB, width, height));
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glFramebufferTexture2D(GL_FRAMEBUFFER,GL_COLOR_ATTACHMENT0,GL_TEXTURE_2D,m_colorBuffer_id,0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER,GL_COLOR_ATTACHMENT0,GL_TEXTURE_2D,m_colorBuffer.Get(),0);
     // Create our render buffer object
-    glGenRenderbuffers(1,&m_rbo_id);
-    glBindRenderbuffer(GL_RENDERBUFFER,m_rbo_id);
+    m_rbo.Create(GpuResourceType::Renderbuffer, m_name, "Mirror");
+    glBindRenderbuffer(GL_RENDERBUFFER,m_rbo.Get());
     glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8,width,height);
-    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, m_rbo_id);
+    m_rbo.SetBytes(GpuResources::GetImageBytes(GL_DEPTH24_STENCIL8, width, height));
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, m_rbo.Get());
     // Deselect our buffers
     UnbindBuffer();
 }
@@ -67,13 +82,13 @@ void Mirror::UpdateBuffer() {
     // For our object, we apply the texture in the following way
     // Note that we set the value to 0, because we have bound
     // our texture to slot 0.
-    m_fboShader->SetUniform1i("u_DiffuseMap",0);  
+    m_fboShader->SetUniform1i(m_diffuseMapUniform,0);  
 }
 
 void Mirror::BindBuffer() {
-    glBindFramebuffer(GL_FRAMEBUFFER, m_fbo_id);
+    GLState::BindFramebuffer(GL_FRAMEBUFFER, m_fbo.Get());
 }
 
 void Mirror::UnbindBuffer() {
-    glBindFramebuffer(GL_FRAMEBUFFER,0);
+    GLState::BindFramebuffer(GL_FRAMEBUFFER,0);
 }
\ No newline at end of file
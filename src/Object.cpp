@@ -1,6 +1,11 @@
 #include "Object.hpp"
 #include "Camera.hpp"
 #include "Error.hpp"
+#include "Frustum.hpp"
+#include "Primitives.hpp"
+
+#include <cmath>
+#include <cstdint>
 
 
 Object::Object(){
@@ -24,58 +29,153 @@ void Object::LoadTexture(std::string fileName){
 // otherwise 'explicitly' called this
 // so we create our objects at the correct time
 void Object::MakeTexturedQuad(std::string fileName){
-
-        // Setup geometry
-        // We are using a new abstraction which allows us
-        // to create triangles shapes on the fly
-        // Position and Texture coordinate 
-        m_geometry.AddVertex(-1.0f,-1.0f, 0.0f, 0.0f, 0.0f);
-        m_geometry.AddVertex( 1.0f,-1.0f, 0.0f, 1.0f, 0.0f);
-    	m_geometry.AddVertex( 1.0f, 1.0f, 0.0f, 1.0f, 1.0f);
-        m_geometry.AddVertex(-1.0f, 1.0f, 0.0f, 0.0f, 1.0f);
-            
-        // Make our triangles and populate our
-        // indices data structure	
-        m_geometry.MakeTriangle(0,1,2);
-        m_geometry.MakeTriangle(2,3,0);
-
-        // This is a helper function to generate all of the geometry
-        m_geometry.Gen();
-
-        // Create a buffer and set the stride of information
-        // NOTE: How we are leveraging our data structure in order to very cleanly
-        //       get information into and out of our data structure.
-        m_vertexBufferLayout.CreateNormalBufferLayout(m_geometry.GetBufferDataSize(),
-                                        m_geometry.GetIndicesSize(),
-                                        m_geometry.GetBufferDataPtr(),
-                                        m_geometry.GetIndicesDataPtr());
+        // Every quad is the same four vertices, so rather than
+        // building our own copy we share one from the MeshCache.
+        m_mesh = Primitives::Quad();
 
         // Load our actual texture
         // We are using the input parameter as our texture to load
         m_textureDiffuse.LoadTexture(fileName.c_str());
 }
 
+// Use a (possibly shared) mesh for this object
+void Object::SetMesh(std::shared_ptr<Mesh> mesh){
+    m_mesh = mesh;
+}
+
+// Retrieve the mesh this object draws
+std::shared_ptr<Mesh> Object::GetMesh() const{
+    return m_mesh;
+}
+
+// Retrieve the shader variant this object needs
+const ShaderFeatures& Object::GetShaderFeatures() const{
+    return m_shaderFeatures;
+}
+
+// Retrieve our diffuse map
+const Texture& Object::GetDiffuseTexture() const{
+    return m_textureDiffuse;
+}
+
 // Bind everything we need in our object
 // Generally this is called in update() and render()
 // before we do any actual work with our object
 void Object::Bind(){
         // Make sure we are updating the correct 'buffers'
-        m_vertexBufferLayout.Bind();
+        if(m_mesh!=nullptr){
+            m_mesh->Bind();
+        }
         // Diffuse map is 0 by default, but it is good to set it explicitly
         m_textureDiffuse.Bind(0);
-        // Detail map
-//        m_detailMap.Bind(1); // NOTE: Not yet supported
+        // Detail map, only if our shader variant samples it
+        if(m_shaderFeatures.detailMap){
+            m_detailMap.Bind(1);
+        }
+}
+
+GLuint Object::GetMaterialTexture() const{
+    return m_textureDiffuse.GetId();
+}
+
+// Cull our meshlets against the current view.
+// Everything is done in object space: the frustum planes are pulled out
+// of the full model-view-projection matrix, and the camera position is
+// moved into object space with the inverse model matrix.
+// NOTE: The cone test assumes the model matrix does not scale the object
+//       unevenly. Nodes scaled to zero (flat quads) skip the cone test.
+void Object::Cull(const glm::mat4& model, const glm::mat4& view, const glm::mat4& projection){
+    m_drawCounts.clear();
+    m_drawOffsets.clear();
+    m_useDrawRanges = m_mesh!=nullptr && !m_mesh->GetMeshlets().empty();
+    if(!m_useDrawRanges){
+        return;
+    }
+    const std::vector<Meshlet>& meshlets = m_mesh->GetMeshlets();
+
+    Frustum frustum;
+    frustum.Extract(projection * view * model);
+
+    glm::mat4 modelView = view * model;
+    bool coneTest = std::abs(glm::determinant(glm::mat3(model))) > 1e-8f;
+    glm::vec3 eye(0.0f);
+    if(coneTest){
+        // The camera sits at the origin of view space
+        eye = glm::vec3(glm::inverse(modelView) * glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+    }
+
+    // Meshlet offsets are relative to the mesh, which sits somewhere
+    // in the arena's index buffer
+    const unsigned int firstIndex = m_mesh->GetFirstIndex();
+    for(unsigned int i=0; i < meshlets.size(); ++i){
+        const Meshlet& meshlet = meshlets[i];
+        glm::vec3 center(meshlet.center[0], meshlet.center[1], meshlet.center[2]);
+        if(!frustum.IsSphereVisible(center, meshlet.radius)){
+            continue;
+        }
+        if(coneTest && meshlet.coneCutoff < 1.0f){
+            // Every triangle faces away from the camera if the camera is
+            // inside the 'backface' cone behind the meshlet
+            glm::vec3 axis(meshlet.coneAxis[0], meshlet.coneAxis[1], meshlet.coneAxis[2]);
+            glm::vec3 toCenter = center - eye;
+            if(glm::dot(toCenter, axis) >= meshlet.coneCutoff * glm::length(toCenter) + meshlet.radius){
+                continue;
+            }
+        }
+        // Merge with the previous range if they touch in the index buffer
+        const void* offset = (const void*)(uintptr_t)((firstIndex + meshlet.indexOffset) * sizeof(unsigned int));
+        if(!m_drawCounts.empty() &&
+           (uintptr_t)m_drawOffsets.back() + m_drawCounts.back()*sizeof(unsigned int) == (uintptr_t)offset){
+            m_drawCounts.back() += meshlet.indexCount;
+        }else{
+            m_drawCounts.push_back(meshlet.indexCount);
+            m_drawOffsets.push_back(offset);
+        }
+    }
 }
 
 // Render our geometry
 void Object::Render(){
+    // Nothing to draw until we have a mesh
+    if(m_mesh==nullptr){
+        return;
+    }
     // Call our helper function to just bind everything
     Bind();
+    // Our indices start at 0 for our own first vertex, but our vertices
+    // sit somewhere in the middle of the shared vertex buffer
+    const GLint baseVertex = m_mesh->GetBaseVertex();
+    // Only draw the meshlets that passed culling
+    if(m_useDrawRanges){
+        if(!m_drawCounts.empty()){
+            m_drawBaseVertices.assign(m_drawCounts.size(), baseVertex);
+            glMultiDrawElementsBaseVertex(GL_TRIANGLES, m_drawCounts.data(), GL_UNSIGNED_INT,
+                                          m_drawOffsets.data(), m_drawCounts.size(), m_drawBaseVertices.data());
+        }
+        return;
+    }
 	//Render data
-    glDrawElements(GL_TRIANGLES,
-                   m_geometry.GetIndicesSize(), // The number of indicies, not triangles.
+    const void* firstIndex = (const void*)(uintptr_t)(m_mesh->GetFirstIndex() * sizeof(unsigned int));
+    glDrawElementsBaseVertex(GL_TRIANGLES,
+                   m_mesh->GetIndexCount(),     // The number of indicies, not triangles.
                    GL_UNSIGNED_INT,             // Make sure the data type matches
-                        nullptr);               // Offset pointer to the data. 
-                                                // nullptr because we are currently bound
+                   firstIndex,                  // Offset of our first index in the
+                                                // shared index buffer
+                   baseVertex);                 // Added to every index
 }
 
+
+bool Object::CanInstance() const{
+    return m_mesh!=nullptr && m_mesh->GetMeshlets().empty() && !m_shaderFeatures.detailMap;
+}
+
+// Every instance draws the same index range; only the model matrix differs
+void Object::RenderInstanced(GLsizei instances){
+    if(m_mesh==nullptr){
+        return;
+    }
+    Bind();
+    const void* firstIndex = (const void*)(uintptr_t)(m_mesh->GetFirstIndex() * sizeof(unsigned int));
+    glDrawElementsInstancedBaseVertex(GL_TRIANGLES, m_mesh->GetIndexCount(), GL_UNSIGNED_INT,
+                                      firstIndex, instances, m_mesh->GetBaseVertex());
+}
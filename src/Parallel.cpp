@@ -0,0 +1,49 @@
+#include "Parallel.hpp"
+
+#include <thread>
+#include <vector>
+#include <algorithm>
+
+// Returns how many worker threads we are allowed to use.
+// hardware_concurrency() may return 0 if it is not known.
+unsigned int GetWorkerCount(){
+    unsigned int count = std::thread::hardware_concurrency();
+    return count == 0 ? 1 : count;
+}
+
+// Split [0,count) into one chunk per worker.
+// The calling thread works on the first chunk itself so
+// that we only spawn (workers-1) threads.
+void ParallelFor(unsigned int count, unsigned int grain,
+                 const std::function<void(unsigned int begin, unsigned int end)>& fn){
+    if(count == 0){
+        return;
+    }
+    if(grain == 0){
+        grain = 1;
+    }
+    // Do not create more chunks than there is work for.
+    unsigned int chunks = std::min(GetWorkerCount(), (count + grain - 1) / grain);
+    if(chunks <= 1){
+        fn(0, count);
+        return;
+    }
+
+    unsigned int chunkSize = (count + chunks - 1) / chunks;
+    std::vector<std::thread> workers;
+    workers.reserve(chunks - 1);
+    for(unsigned int i = 1; i < chunks; ++i){
+        unsigned int begin = i * chunkSize;
+        unsigned int end = std::min(count, begin + chunkSize);
+        if(begin >= end){
+            break;
+        }
+        workers.emplace_back(fn, begin, end);
+    }
+    // First chunk runs on this thread
+    fn(0, std::min(count, chunkSize));
+
+    for(unsigned int i = 0; i < workers.size(); ++i){
+        workers[i].join();
+    }
+}
@@ -0,0 +1,213 @@
+#include "Primitives.hpp"
+#include "MeshCache.hpp"
+
+#include <cmath>
+#include <string>
+
+namespace{
+    const float kPi = 3.14159265359f;
+}
+
+// A quad in the xy plane facing +z
+void Primitives::BuildQuad(Geometry& geometry){
+    // Position and Texture coordinate 
+    geometry.AddVertex(-1.0f,-1.0f, 0.0f, 0.0f, 0.0f);
+    geometry.AddVertex( 1.0f,-1.0f, 0.0f, 1.0f, 0.0f);
+    geometry.AddVertex( 1.0f, 1.0f, 0.0f, 1.0f, 1.0f);
+    geometry.AddVertex(-1.0f, 1.0f, 0.0f, 0.0f, 1.0f);
+    // Make our triangles and populate our
+    // indices data structure	
+    geometry.MakeTriangle(0,1,2);
+    geometry.MakeTriangle(2,3,0);
+}
+
+// A plane in the xz plane facing +y
+void Primitives::BuildPlane(Geometry& geometry){
+    BuildGrid(geometry, 1, 1);
+}
+
+// A grid of (xSegments+1) * (zSegments+1) vertices in the xz plane.
+// This is the same layout the terrain uses, without any heights.
+void Primitives::BuildGrid(Geometry& geometry, unsigned int xSegments, unsigned int zSegments){
+    xSegments = xSegments == 0 ? 1 : xSegments;
+    zSegments = zSegments == 0 ? 1 : zSegments;
+    for(unsigned int z=0; z <= zSegments; ++z){
+        for(unsigned int x=0; x <= xSegments; ++x){
+            float u = (float)x/(float)xSegments;
+            float v = (float)z/(float)zSegments;
+            geometry.AddVertex(u*2.0f-1.0f, 0.0f, v*2.0f-1.0f, u, 1.0f-v);
+        }
+    }
+    const unsigned int row = xSegments+1;
+    for(unsigned int z=0; z < zSegments; ++z){
+        for(unsigned int x=0; x < xSegments; ++x){
+            unsigned int i = x + z*row;
+            geometry.MakeTriangle(i, i+row, i+1);
+            geometry.MakeTriangle(i+1, i+row, i+row+1);
+        }
+    }
+}
+
+// A cube built from six quads.
+// Each face has its own four vertices so that the normals are flat.
+void Primitives::BuildCube(Geometry& geometry){
+    // For each face: the direction it faces, then the directions of
+    // its 'u' and 'v' texture axes. u x v == normal keeps the winding CCW.
+    const float faces[6][9] = {
+        { 0, 0, 1,   1, 0, 0,   0, 1, 0}, // front
+        { 0, 0,-1,  -1, 0, 0,   0, 1, 0}, // back
+        { 1, 0, 0,   0, 0,-1,   0, 1, 0}, // right
+        {-1, 0, 0,   0, 0, 1,   0, 1, 0}, // left
+        { 0, 1, 0,   1, 0, 0,   0, 0,-1}, // top
+        { 0,-1, 0,   1, 0, 0,   0, 0, 1}, // bottom
+    };
+    for(unsigned int f=0; f < 6; ++f){
+        const float* n = &faces[f][0];
+        const float* u = &faces[f][3];
+        const float* v = &faces[f][6];
+        unsigned int first = f*4;
+        const float corners[4][2] = {{-1,-1},{1,-1},{1,1},{-1,1}};
+        for(unsigned int c=0; c < 4; ++c){
+            float a = corners[c][0];
+            float b = corners[c][1];
+            geometry.AddVertex(n[0] + a*u[0] + b*v[0],
+                               n[1] + a*u[1] + b*v[1],
+                               n[2] + a*u[2] + b*v[2],
+                               (a+1.0f)*0.5f, (b+1.0f)*0.5f);
+        }
+        geometry.MakeTriangle(first+0, first+1, first+2);
+        geometry.MakeTriangle(first+2, first+3, first+0);
+    }
+}
+
+// Algorithm for rendering a sphere
+// The algorithm was obtained here: http://learningwebgl.com/blog/?p=1253
+// Please review the page so you can understand the algorithm. You may think
+// back to your algebra days and equation of a circle! (And some trig with
+// how sin and cos work
+void Primitives::BuildSphere(Geometry& geometry, unsigned int latitudeBands, unsigned int longitudeBands){
+    latitudeBands = latitudeBands < 2 ? 2 : latitudeBands;
+    longitudeBands = longitudeBands < 3 ? 3 : longitudeBands;
+
+    for(unsigned int latNumber = 0; latNumber <= latitudeBands; latNumber++){
+        float theta = latNumber * kPi / latitudeBands;
+        float sinTheta = std::sin(theta);
+        float cosTheta = std::cos(theta);
+        // Make the poles exact, so the triangles touching them are
+        // properly degenerate rather than slivers of rounding error
+        if(latNumber == 0 || latNumber == latitudeBands){
+            sinTheta = 0.0f;
+        }
+
+        for(unsigned int longNumber = 0; longNumber <= longitudeBands; longNumber++){
+            float phi = longNumber * 2 * kPi / longitudeBands;
+            float sinPhi = std::sin(phi);
+            float cosPhi = std::cos(phi);
+
+            float x = cosPhi * sinTheta;
+            float y = cosTheta;
+            float z = sinPhi * sinTheta;
+            // Why is this "1-" Think about the range of texture coordinates
+            float u = 1 - ((float)longNumber / (float)longitudeBands);
+            float v = 1 - ((float)latNumber / (float)latitudeBands);
+
+            geometry.AddVertex(x, y, z, u, v);
+        }
+    }
+
+    // Now that we have all of our vertices
+    // generated, we need to generate our indices for our
+    // index element buffer.
+    // This diagram shows it nicely visually
+    // http://learningwebgl.com/lessons/lesson11/sphere-triangles.png
+    for (unsigned int latNumber1 = 0; latNumber1 < latitudeBands; latNumber1++){
+        for (unsigned int longNumber1 = 0; longNumber1 < longitudeBands; longNumber1++){
+            unsigned int first = (latNumber1 * (longitudeBands + 1)) + longNumber1;
+            unsigned int second = first + longitudeBands + 1;
+            // Wound so that the triangles face outwards
+            geometry.MakeTriangle(first, first+1, second);
+            geometry.MakeTriangle(second, first+1, second+1);
+        }
+    }
+}
+
+// A cylinder of radius 1 from y=-1 to y=1.
+// The side and the two caps have separate vertices so that the
+// edges stay sharp.
+void Primitives::BuildCylinder(Geometry& geometry, unsigned int segments){
+    segments = segments < 3 ? 3 : segments;
+
+    // Side: a ring at the bottom and top. The first column is repeated
+    // at the end so that the texture can wrap all the way around.
+    for(unsigned int s=0; s <= segments; ++s){
+        float u = (float)s/(float)segments;
+        float phi = u * 2.0f * kPi;
+        float x = std::cos(phi);
+        float z = -std::sin(phi);
+        geometry.AddVertex(x,-1.0f, z, u, 0.0f);
+        geometry.AddVertex(x, 1.0f, z, u, 1.0f);
+    }
+    for(unsigned int s=0; s < segments; ++s){
+        unsigned int bottom = s*2;
+        unsigned int top = bottom+1;
+        geometry.MakeTriangle(bottom, bottom+2, top);
+        geometry.MakeTriangle(top, bottom+2, top+2);
+    }
+
+    // Caps: a center vertex and a ring for each
+    for(int cap=0; cap < 2; ++cap){
+        float y = cap == 0 ? -1.0f : 1.0f;
+        unsigned int center = (segments+1)*2 + cap*(segments+1);
+        geometry.AddVertex(0.0f, y, 0.0f, 0.5f, 0.5f);
+        for(unsigned int s=0; s < segments; ++s){
+            float phi = (float)s/(float)segments * 2.0f * kPi;
+            float x = std::cos(phi);
+            float z = -std::sin(phi);
+            geometry.AddVertex(x, y, z, x*0.5f+0.5f, z*0.5f+0.5f);
+        }
+        for(unsigned int s=0; s < segments; ++s){
+            unsigned int a = center + 1 + s;
+            unsigned int b = center + 1 + (s+1)%segments;
+            if(cap == 0){
+                geometry.MakeTriangle(center, b, a);
+            }else{
+                geometry.MakeTriangle(center, a, b);
+            }
+        }
+    }
+}
+
+// ============== Shared meshes ==============
+
+std::shared_ptr<Mesh> Primitives::Quad(){
+    return MeshCache::Instance().Get("quad", BuildQuad);
+}
+
+std::shared_ptr<Mesh> Primitives::Plane(){
+    return MeshCache::Instance().Get("plane", BuildPlane);
+}
+
+std::shared_ptr<Mesh> Primitives::Grid(unsigned int xSegments, unsigned int zSegments){
+    std::string key = "grid(" + std::to_string(xSegments) + "," + std::to_string(zSegments) + ")";
+    return MeshCache::Instance().Get(key, [=](Geometry& geometry){
+        BuildGrid(geometry, xSegments, zSegments);
+    });
+}
+
+std::shared_ptr<Mesh> Primitives::Cube(){
+    return MeshCache::Instance().Get("cube", BuildCube);
+}
+
+std::shared_ptr<Mesh> Primitives::Sphere(unsigned int latitudeBands, unsigned int longitudeBands){
+    std::string key = "sphere(" + std::to_string(latitudeBands) + "," + std::to_string(longitudeBands) + ")";
+    return MeshCache::Instance().Get(key, [=](Geometry& geometry){
+        BuildSphere(geometry, latitudeBands, longitudeBands);
+    });
+}
+
+std::shared_ptr<Mesh> Primitives::Cylinder(unsigned int segments){
+    std::string key = "cylinder(" + std::to_string(segments) + ")";
+    return MeshCache::Instance().Get(key, [=](Geometry& geometry){
+        BuildCylinder(geometry, segments);
+    });
+}
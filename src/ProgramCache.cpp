@@ -0,0 +1,208 @@
+#include "ProgramCache.hpp"
+#include "Hash.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+// glad is generated for GL 3.3, which has none of the program binary
+// names, so they are declared here.
+#ifndef GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#endif
+#ifndef GL_PROGRAM_BINARY_LENGTH
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#endif
+#ifndef GL_NUM_PROGRAM_BINARY_FORMATS
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+#endif
+typedef void (APIENTRYP PFNGETPROGRAMBINARYPROC)(GLuint program, GLsizei bufSize, GLsizei* length, GLenum* binaryFormat, void* binary);
+typedef void (APIENTRYP PFNPROGRAMBINARYPROC)(GLuint program, GLenum binaryFormat, const void* binary, GLsizei length);
+typedef void (APIENTRYP PFNPROGRAMPARAMETERIPROC)(GLuint program, GLenum pname, GLint value);
+
+const char* const ProgramCache::kDirectory = "./shadercache";
+
+namespace{
+    // Loaded by ProgramCache::LoadFunctions (null if unsupported)
+    PFNGETPROGRAMBINARYPROC s_getProgramBinary = nullptr;
+    PFNPROGRAMBINARYPROC s_programBinary = nullptr;
+    PFNPROGRAMPARAMETERIPROC s_programParameteri = nullptr;
+
+    // Hash of the driver strings, part of every key
+    uint64_t s_driverKey = 0;
+
+    // Start of every cache file
+    const char kMagic[4] = {'P','B','I','N'};
+    const uint32_t kVersion = 1;
+    struct ProgramFileHeader{
+        char magic[4];
+        uint32_t version;
+        uint64_t key;
+        uint32_t binaryFormat;
+        uint32_t binarySize;
+        double compileMilliseconds;
+    };
+
+    // Counters for PrintStats
+    unsigned int s_hits = 0;
+    unsigned int s_misses = 0;
+    double s_loadMilliseconds = 0.0;
+    double s_compileMilliseconds = 0.0;
+    double s_savedMilliseconds = 0.0;
+
+    std::string GetPath(uint64_t key){
+        char name[32];
+        std::snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long)key);
+        return std::string(ProgramCache::kDirectory) + "/" + name;
+    }
+
+    uint64_t HashGLString(GLenum name, uint64_t seed){
+        const char* value = (const char*)glGetString(name);
+        return value != nullptr ? HashBytes(value, std::strlen(value), seed) : seed;
+    }
+}
+
+// glGetProgramBinary is core in 4.1. On older contexts the extension
+// provides the same functions.
+void ProgramCache::LoadFunctions(GLADloadproc load){
+    bool supported = GLVersion.major > 4 || (GLVersion.major == 4 && GLVersion.minor >= 1);
+    if(!supported){
+        GLint count = 0;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+        for(GLint i=0; i < count && !supported; ++i){
+            const char* name = (const char*)glGetStringi(GL_EXTENSIONS, i);
+            supported = name != nullptr && std::strcmp(name, "GL_ARB_get_program_binary") == 0;
+        }
+    }
+    // Some drivers support the functions but no binary formats at all
+    GLint formats = 0;
+    if(supported){
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    }
+    if(supported && formats > 0){
+        s_getProgramBinary = (PFNGETPROGRAMBINARYPROC)load("glGetProgramBinary");
+        s_programBinary = (PFNPROGRAMBINARYPROC)load("glProgramBinary");
+        s_programParameteri = (PFNPROGRAMPARAMETERIPROC)load("glProgramParameteri");
+    }
+
+    s_driverKey = HashGLString(GL_VENDOR, kHashSeed);
+    s_driverKey = HashGLString(GL_RENDERER, s_driverKey);
+    s_driverKey = HashGLString(GL_VERSION, s_driverKey);
+}
+
+bool ProgramCache::IsAvailable(){
+    return s_getProgramBinary != nullptr && s_programBinary != nullptr && s_programParameteri != nullptr;
+}
+
+// The sources were hashed once by ShaderManager; only the key is
+// hashed again, seeded with the driver
+uint64_t ProgramCache::GetKey(uint64_t sourceKey){
+    return HashBytes(&sourceKey, sizeof(sourceKey), s_driverKey);
+}
+
+void ProgramCache::PrepareProgram(GLuint program){
+    if(IsAvailable()){
+        s_programParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+}
+
+bool ProgramCache::Load(uint64_t key, GLuint program, double& compileMilliseconds){
+    if(!IsAvailable()){
+        return false;
+    }
+    std::ifstream file(GetPath(key).c_str(), std::ios::binary);
+    if(!file.is_open()){
+        return false;
+    }
+    ProgramFileHeader header;
+    if(!file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+       std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 || header.version != kVersion || header.key != key){
+        return false;
+    }
+    std::vector<char> binary(header.binarySize);
+    if(!file.read(binary.data(), binary.size())){
+        return false;
+    }
+
+    s_programBinary(program, header.binaryFormat, binary.data(), binary.size());
+    GLint linked = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    if(linked != GL_TRUE){
+        std::cout << "(ProgramCache.cpp) Driver rejected cached program " << GetPath(key) << "\n";
+        return false;
+    }
+    compileMilliseconds = header.compileMilliseconds;
+    return true;
+}
+
+// Written to a temporary file first, like cooked meshes, so a crash
+// never leaves half a program behind
+bool ProgramCache::Save(uint64_t key, GLuint program, double compileMilliseconds){
+    if(!IsAvailable()){
+        return false;
+    }
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if(length <= 0){
+        return false;
+    }
+    std::vector<char> binary(length);
+    GLenum binaryFormat = 0;
+    GLsizei written = 0;
+    s_getProgramBinary(program, length, &written, &binaryFormat, binary.data());
+    if(written <= 0){
+        return false;
+    }
+
+    std::error_code error;
+    std::filesystem::create_directories(kDirectory, error);
+    ProgramFileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.key = key;
+    header.binaryFormat = binaryFormat;
+    header.binarySize = written;
+    header.compileMilliseconds = compileMilliseconds;
+
+    std::string path = GetPath(key);
+    std::string tempPath = path + ".tmp";
+    {
+        std::ofstream file(tempPath.c_str(), std::ios::binary | std::ios::trunc);
+        if(!file.is_open()){
+            std::cout << "(ProgramCache.cpp) ERROR, could not write " << tempPath << "\n";
+            return false;
+        }
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(binary.data(), written);
+        if(!file){
+            std::cout << "(ProgramCache.cpp) ERROR, could not write " << tempPath << "\n";
+            return false;
+        }
+    }
+    std::filesystem::rename(tempPath, path, error);
+    return !error;
+}
+
+void ProgramCache::CountMiss(double compileMilliseconds){
+    ++s_misses;
+    s_compileMilliseconds += compileMilliseconds;
+    std::printf("(ProgramCache.cpp) Miss, program compiled in %.2f ms\n", compileMilliseconds);
+}
+
+void ProgramCache::CountHit(double loadMilliseconds, double compileMilliseconds){
+    ++s_hits;
+    s_loadMilliseconds += loadMilliseconds;
+    s_savedMilliseconds += compileMilliseconds - loadMilliseconds;
+    std::printf("(ProgramCache.cpp) Hit, program loaded in %.2f ms (compiling took %.2f ms)\n",
+                loadMilliseconds, compileMilliseconds);
+}
+
+void ProgramCache::PrintStats(){
+    std::printf("(ProgramCache.cpp) %s: %u hits (%.2f ms loading), %u misses (%.2f ms compiling), %.2f ms saved\n",
+                IsAvailable() ? "enabled" : "not supported by this driver",
+                s_hits, s_loadMilliseconds, s_misses, s_compileMilliseconds, s_savedMilliseconds);
+}
@@ -0,0 +1,110 @@
+#include "RangeAllocator.hpp"
+
+#include <iterator>
+
+// Constructor
+RangeAllocator::RangeAllocator(unsigned int capacity) : m_capacity(0), m_used(0){
+    Grow(capacity);
+}
+
+// Best fit: the smallest block that is large enough, so that large
+// blocks stay available for large meshes.
+unsigned int RangeAllocator::Allocate(unsigned int size){
+    if(size == 0){
+        return kInvalidOffset;
+    }
+    auto best = m_freeBlocks.end();
+    for(auto it = m_freeBlocks.begin(); it != m_freeBlocks.end(); ++it){
+        if(it->second >= size && (best == m_freeBlocks.end() || it->second < best->second)){
+            best = it;
+            if(best->second == size){
+                break;
+            }
+        }
+    }
+    if(best == m_freeBlocks.end()){
+        return kInvalidOffset;
+    }
+    unsigned int offset = best->first;
+    unsigned int remaining = best->second - size;
+    m_freeBlocks.erase(best);
+    if(remaining > 0){
+        m_freeBlocks[offset + size] = remaining;
+    }
+    m_used += size;
+    return offset;
+}
+
+// Puts the range back and merges it with the free blocks on either side
+void RangeAllocator::Free(unsigned int offset, unsigned int size){
+    if(size == 0 || offset == kInvalidOffset){
+        return;
+    }
+    m_used -= size;
+    auto next = m_freeBlocks.lower_bound(offset);
+    if(next != m_freeBlocks.begin()){
+        auto previous = std::prev(next);
+        if(previous->first + previous->second == offset){
+            offset = previous->first;
+            size += previous->second;
+            m_freeBlocks.erase(previous);
+        }
+    }
+    if(next != m_freeBlocks.end() && offset + size == next->first){
+        size += next->second;
+        m_freeBlocks.erase(next);
+    }
+    m_freeBlocks[offset] = size;
+}
+
+// The new space is freed like any other range, so it merges with a
+// free block at the old end.
+void RangeAllocator::Grow(unsigned int capacity){
+    if(capacity <= m_capacity){
+        return;
+    }
+    unsigned int oldCapacity = m_capacity;
+    m_capacity = capacity;
+    m_used += capacity - oldCapacity;
+    Free(oldCapacity, capacity - oldCapacity);
+}
+
+void RangeAllocator::Reset(unsigned int used){
+    m_freeBlocks.clear();
+    m_used = used;
+    if(used < m_capacity){
+        m_freeBlocks[used] = m_capacity - used;
+    }
+}
+
+unsigned int RangeAllocator::GetCapacity() const{
+    return m_capacity;
+}
+
+unsigned int RangeAllocator::GetUsed() const{
+    return m_used;
+}
+
+unsigned int RangeAllocator::GetFree() const{
+    return m_capacity - m_used;
+}
+
+unsigned int RangeAllocator::GetFreeBlockCount() const{
+    return m_freeBlocks.size();
+}
+
+unsigned int RangeAllocator::GetLargestFreeBlock() const{
+    unsigned int largest = 0;
+    for(auto it = m_freeBlocks.begin(); it != m_freeBlocks.end(); ++it){
+        largest = it->second > largest ? it->second : largest;
+    }
+    return largest;
+}
+
+float RangeAllocator::GetFragmentation() const{
+    unsigned int free = GetFree();
+    if(free == 0){
+        return 0.0f;
+    }
+    return 1.0f - (float)GetLargestFreeBlock() / (float)free;
+}
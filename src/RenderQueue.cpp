@@ -0,0 +1,377 @@
+#include "RenderQueue.hpp"
+#include "SceneNode.hpp"
+#include "Object.hpp"
+#include "Shader.hpp"
+#include "GLState.hpp"
+#include "UniformBlocks.hpp"
+#include "Camera.hpp"
+#include "Frustum.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <unordered_map>
+
+namespace{
+    // Fields of the sort key (see RenderQueue.hpp)
+    const int kDepthBits = 21;
+    const int kMeshShift = 21;
+    const int kMaterialShift = 33;
+    const int kProgramShift = 49;
+    const int kTranslucentShift = 61;
+    const int kPassShift = 62;
+    const uint64_t kDepthMax = (1ull << kDepthBits) - 1;
+    const uint32_t kMeshMax = (1u << 12) - 1;
+    const uint32_t kMaterialMax = (1u << 16) - 1;
+    const uint32_t kProgramMax = (1u << 12) - 1;
+    // Every packet is opaque and in the main pass for now
+    const uint64_t kMainPass = 0;
+    const uint64_t kOpaque = 0;
+
+    // Number for 'key', handing out the next one the first time it is seen.
+    // Numbers past 'max' all share 'max' (they still draw correctly, only
+    // less well sorted).
+    template<typename T>
+    uint64_t Rank(std::unordered_map<T, uint32_t>& ranks, T key, uint32_t max){
+        auto found = ranks.find(key);
+        if(found == ranks.end()){
+            found = ranks.emplace(key, (uint32_t)ranks.size()).first;
+        }
+        return std::min(found->second, max);
+    }
+
+    // Sorts 'keys' (and 'order' along with them) one byte at a time,
+    // lowest byte first. Bytes that are the same in every key are skipped,
+    // which for our keys is most of them.
+    void RadixSort(std::vector<uint64_t>& keys, std::vector<uint32_t>& order,
+                   std::vector<uint64_t>& keysScratch, std::vector<uint32_t>& orderScratch){
+        const size_t count = keys.size();
+        keysScratch.resize(count);
+        orderScratch.resize(count);
+        for(int shift=0; shift < 64; shift += 8){
+            size_t counts[256] = {0};
+            for(size_t i=0; i < count; ++i){
+                ++counts[(keys[i] >> shift) & 0xff];
+            }
+            if(counts[(keys[0] >> shift) & 0xff] == count){
+                continue;
+            }
+            size_t offsets[256];
+            size_t sum = 0;
+            for(int digit=0; digit < 256; ++digit){
+                offsets[digit] = sum;
+                sum += counts[digit];
+            }
+            for(size_t i=0; i < count; ++i){
+                size_t to = offsets[(keys[i] >> shift) & 0xff]++;
+                keysScratch[to] = keys[i];
+                orderScratch[to] = order[i];
+            }
+            keys.swap(keysScratch);
+            order.swap(orderScratch);
+        }
+    }
+
+    // Counts the state changes of drawing 'packets' in 'order' (the first
+    // draw counts, since it has to select everything)
+    void CountSwitches(const std::vector<DrawPacket>& packets, const uint32_t* order, size_t count,
+                       RenderQueue::Switches& switches){
+        const DrawPacket* previous = nullptr;
+        for(size_t i=0; i < count; ++i){
+            const DrawPacket& packet = packets[order != nullptr ? order[i] : i];
+            switches.programs += previous == nullptr || previous->shader != packet.shader;
+            switches.textures += previous == nullptr || previous->materialTexture != packet.materialTexture;
+            switches.vertexArrays += previous == nullptr || previous->vertexArray != packet.vertexArray;
+            previous = &packet;
+        }
+    }
+
+    void AddSwitches(RenderQueue::Switches& total, const RenderQueue::Switches& add){
+        total.programs += add.programs;
+        total.textures += add.textures;
+        total.vertexArrays += add.vertexArrays;
+    }
+}
+
+uint32_t RenderQueue::Add(Object* object, Shader* shader, TransformHierarchy::Handle transform, uint32_t parent){
+    DrawPacket packet;
+    packet.object = object;
+    packet.shader = shader;
+    packet.transform = transform;
+    packet.mesh = nullptr;
+    packet.instanceable = false;
+    packet.stateKey = 0;
+    packet.materialTexture = 0;
+    packet.vertexArray = 0;
+    packet.parent = parent;
+    packet.subtreeEnd = 0;
+    m_packets.push_back(packet);
+    return m_packets.size() - 1;
+}
+
+void RenderQueue::Build(SceneNode* root, StreamBuffer& uniforms){
+    // The previous frame is complete
+    if(m_frame.views > 0){
+        m_lastFrame = m_frame;
+        m_total.views += m_frame.views;
+        m_total.draws += m_frame.draws;
+        m_total.drawCalls += m_frame.drawCalls;
+        m_total.instancedCalls += m_frame.instancedCalls;
+        AddSwitches(m_total.sorted, m_frame.sorted);
+        AddSwitches(m_total.sceneOrder, m_frame.sceneOrder);
+        m_total.culling.tested += m_frame.culling.tested;
+        m_total.culling.culled += m_frame.culling.culled;
+        m_total.culling.visible += m_frame.culling.visible;
+        ++m_frames;
+        m_lastFrameViews.swap(m_frameViews);
+    }
+    m_frame = Stats();
+    m_frameViews.clear();
+
+    m_packets.clear();
+    m_uniforms = &uniforms;
+    if(root != nullptr){
+        root->Enqueue(*this);
+    }
+    if(m_packets.empty()){
+        return;
+    }
+    AssignStateKeys();
+    ComputeBounds();
+}
+
+void RenderQueue::AssignStateKeys(){
+    std::unordered_map<const Shader*, uint32_t> programs;
+    std::unordered_map<GLuint, uint32_t> materials;
+    std::unordered_map<const Mesh*, uint32_t> meshes;
+    for(DrawPacket& packet : m_packets){
+        std::shared_ptr<Mesh> mesh = packet.object->GetMesh();
+        packet.materialTexture = packet.object->GetMaterialTexture();
+        packet.vertexArray = mesh != nullptr ? mesh->GetVertexArray() : 0;
+        packet.mesh = mesh.get();
+        packet.instanceable = packet.object->CanInstance();
+        packet.stateKey = (kMainPass << kPassShift) | (kOpaque << kTranslucentShift)
+                        | (Rank<const Shader*>(programs, packet.shader, kProgramMax) << kProgramShift)
+                        | (Rank<GLuint>(materials, packet.materialTexture, kMaterialMax) << kMaterialShift)
+                        | (Rank<const Mesh*>(meshes, mesh.get(), kMeshMax) << kMeshShift);
+    }
+}
+
+// Children follow their parent, so by the time a packet is reached
+// walking backwards, everything below it has been added to its bounds
+void RenderQueue::ComputeBounds(){
+    const TransformHierarchy& hierarchy = TransformHierarchy::Instance();
+    for(size_t i=0; i < m_packets.size(); ++i){
+        DrawPacket& packet = m_packets[i];
+        std::shared_ptr<Mesh> mesh = packet.object->GetMesh();
+        packet.bounds = mesh != nullptr ? mesh->GetBounds().Transformed(hierarchy.GetWorld(packet.transform).GetInternalMatrix())
+                                        : Bounds();
+        packet.subtreeBounds = packet.bounds;
+        packet.subtreeEnd = i + 1;
+    }
+    for(size_t i=m_packets.size(); i-- > 0;){
+        const DrawPacket& packet = m_packets[i];
+        if(packet.parent != kNoParent){
+            DrawPacket& parent = m_packets[packet.parent];
+            parent.subtreeBounds.Add(packet.subtreeBounds);
+            parent.subtreeEnd = std::max(parent.subtreeEnd, packet.subtreeEnd);
+        }
+    }
+}
+
+// A subtree entirely outside is skipped, and one entirely inside is
+// drawn without testing anything below it. Only when the subtree
+// straddles the frustum is the node's own box tested. Packets without
+// bounds cannot be culled.
+void RenderQueue::Cull(const Frustum& frustum, Culling& culling){
+    m_visible.clear();
+    const uint32_t count = m_packets.size();
+    uint32_t i = 0;
+    while(i < count){
+        const DrawPacket& packet = m_packets[i];
+        Frustum::Containment subtree = Frustum::Containment::Inside;
+        if(!packet.subtreeBounds.IsEmpty()){
+            ++culling.tested;
+            const Bounds& bounds = packet.subtreeBounds;
+            subtree = frustum.TestBox((bounds.min + bounds.max) * 0.5f, bounds.GetExtents());
+        }
+        if(subtree == Frustum::Containment::Outside){
+            culling.culled += packet.subtreeEnd - i;
+            i = packet.subtreeEnd;
+            continue;
+        }
+        if(subtree == Frustum::Containment::Inside){
+            for(; i < packet.subtreeEnd; ++i){
+                m_visible.push_back(i);
+            }
+            continue;
+        }
+        bool visible = true;
+        if(packet.subtreeEnd > i + 1 && !packet.bounds.IsEmpty()){
+            ++culling.tested;
+            const Bounds& bounds = packet.bounds;
+            visible = frustum.TestBox((bounds.min + bounds.max) * 0.5f, bounds.GetExtents()) != Frustum::Containment::Outside;
+        }
+        if(visible){
+            m_visible.push_back(i);
+        }else{
+            ++culling.culled;
+        }
+        ++i;
+    }
+    culling.visible = m_visible.size();
+}
+
+// The depth is taken at the center of each object's bounds (its origin
+// if it has none) and scaled to the farthest object of this view
+void RenderQueue::Submit(const Camera& camera){
+    if(m_uniforms == nullptr){
+        return;
+    }
+    Culling culling{};
+    Cull(camera.GetFrustum(), culling);
+    m_frameViews.push_back(culling);
+    m_frame.culling.tested += culling.tested;
+    m_frame.culling.culled += culling.culled;
+    m_frame.culling.visible += culling.visible;
+    ++m_frame.views;
+
+    const glm::mat4& view = camera.GetViewMatrix();
+    const TransformHierarchy& hierarchy = TransformHierarchy::Instance();
+    const size_t count = m_visible.size();
+    if(count == 0){
+        return;
+    }
+    m_depths.resize(count);
+    m_keys.resize(count);
+    m_order.resize(count);
+    float farthest = 0.0f;
+    for(size_t i=0; i < count; ++i){
+        const DrawPacket& packet = m_packets[m_visible[i]];
+        const glm::vec4 center = packet.bounds.IsEmpty() ? hierarchy.GetWorld(packet.transform).GetInternalMatrix()[3]
+                                                         : glm::vec4(packet.bounds.center, 1.0f);
+        // View space looks down -z
+        m_depths[i] = std::max(-(view * center).z, 0.0f);
+        farthest = std::max(farthest, m_depths[i]);
+    }
+    const float scale = farthest > 0.0f ? kDepthMax / farthest : 0.0f;
+    for(size_t i=0; i < count; ++i){
+        m_keys[i] = m_packets[m_visible[i]].stateKey | std::min((uint64_t)(m_depths[i] * scale), kDepthMax);
+        m_order[i] = m_visible[i];
+    }
+    RadixSort(m_keys, m_order, m_keysScratch, m_orderScratch);
+
+    if(!BuildDraws()){
+        // The stream buffer is full (counted as an overflow there)
+        return;
+    }
+    m_frame.draws += count;
+    m_frame.drawCalls += m_draws.size();
+    CountSwitches(m_packets, m_order.data(), count, m_frame.sorted);
+    CountSwitches(m_packets, m_visible.data(), count, m_frame.sceneOrder);
+
+    // The program only changes where the program field of the key does
+    const GLuint buffer = m_uniforms->GetBuffer();
+    const Shader* program = nullptr;
+    for(const Draw& draw : m_draws){
+        const DrawPacket& packet = m_packets[m_order[draw.first]];
+        if(packet.shader != program){
+            packet.shader->Bind();
+            program = packet.shader;
+        }
+        GLState::BindUniformBufferRange(kObjectBlockBinding, buffer, draw.offset, sizeof(ObjectBlock));
+        if(draw.count > 1){
+            packet.object->RenderInstanced(draw.count);
+            ++m_frame.instancedCalls;
+        }else{
+            // Skip the parts of large objects this view cannot see
+            packet.object->Cull(hierarchy.GetWorld(packet.transform).GetInternalMatrix(), view, camera.GetProjectionMatrix());
+            packet.object->Render();
+        }
+    }
+}
+
+// A draw takes the packets after its first for as long as they draw
+// the same mesh with the same program and texture. Every draw's
+// matrices start at an aligned offset, and the last draw's ObjectBlock
+// must still fit in the mapping, so the whole block is reserved after it.
+bool RenderQueue::BuildDraws(){
+    m_draws.clear();
+    const uint32_t count = m_order.size();
+    for(uint32_t i=0; i < count;){
+        const DrawPacket& first = m_packets[m_order[i]];
+        uint32_t end = i + 1;
+        if(first.instanceable){
+            while(end < count && end - i < (uint32_t)ObjectBlock::kMaxInstances){
+                const DrawPacket& next = m_packets[m_order[end]];
+                if(!next.instanceable || next.mesh != first.mesh || next.shader != first.shader
+                   || next.materialTexture != first.materialTexture){
+                    break;
+                }
+                ++end;
+            }
+        }
+        m_draws.push_back(Draw{i, end - i, 0});
+        i = end;
+    }
+
+    const unsigned int alignment = m_uniforms->GetUniformAlignment();
+    const size_t matrixSize = sizeof(glm::mat4);
+    size_t size = 0;
+    for(Draw& draw : m_draws){
+        draw.offset = size;
+        size += (draw.count*matrixSize + alignment - 1) / alignment * alignment;
+    }
+    size += sizeof(ObjectBlock);
+
+    GLintptr base = 0;
+    unsigned char* data = static_cast<unsigned char*>(m_uniforms->Map(size, alignment, base));
+    if(data == nullptr){
+        return false;
+    }
+    const TransformHierarchy& hierarchy = TransformHierarchy::Instance();
+    for(Draw& draw : m_draws){
+        glm::mat4* models = reinterpret_cast<glm::mat4*>(data + draw.offset);
+        for(uint32_t i=0; i < draw.count; ++i){
+            models[i] = hierarchy.GetWorld(m_packets[m_order[draw.first + i]].transform).GetInternalMatrix();
+        }
+        draw.offset += base;
+    }
+    m_uniforms->Unmap();
+    return true;
+}
+
+const std::vector<DrawPacket>& RenderQueue::GetPackets() const{
+    return m_packets;
+}
+
+const RenderQueue::Stats& RenderQueue::GetLastFrame() const{
+    return m_lastFrame;
+}
+
+const std::vector<RenderQueue::Culling>& RenderQueue::GetLastFrameViews() const{
+    return m_lastFrameViews;
+}
+
+void RenderQueue::PrintStats() const{
+    const double frames = m_frames > 0 ? m_frames : 1;
+    std::printf("(RenderQueue.cpp) Last frame: %u views, %u draws (average %.1f views, %.1f draws)\n",
+                m_lastFrame.views, m_lastFrame.draws, m_total.views/frames, m_total.draws/frames);
+    std::printf("    draw calls: %u, %u of them instanced (average %.1f, %.1f)\n",
+                m_lastFrame.drawCalls, m_lastFrame.instancedCalls, m_total.drawCalls/frames, m_total.instancedCalls/frames);
+    const char* names[3] = {"programs", "textures", "vertex arrays"};
+    const unsigned int sorted[3] = {m_lastFrame.sorted.programs, m_lastFrame.sorted.textures, m_lastFrame.sorted.vertexArrays};
+    const unsigned int scene[3] = {m_lastFrame.sceneOrder.programs, m_lastFrame.sceneOrder.textures, m_lastFrame.sceneOrder.vertexArrays};
+    const unsigned int totalSorted[3] = {m_total.sorted.programs, m_total.sorted.textures, m_total.sorted.vertexArrays};
+    const unsigned int totalScene[3] = {m_total.sceneOrder.programs, m_total.sceneOrder.textures, m_total.sceneOrder.vertexArrays};
+    for(int i=0; i < 3; ++i){
+        std::printf("    %-13s switches: sorted %4u (%7.1f), scene order %4u (%7.1f)\n", names[i],
+                    sorted[i], totalSorted[i]/frames, scene[i], totalScene[i]/frames);
+    }
+    std::printf("    culling: tested %u, culled %u, visible %u (average %.1f, %.1f, %.1f)\n",
+                m_lastFrame.culling.tested, m_lastFrame.culling.culled, m_lastFrame.culling.visible,
+                m_total.culling.tested/frames, m_total.culling.culled/frames, m_total.culling.visible/frames);
+    for(size_t i=0; i < m_lastFrameViews.size(); ++i){
+        std::printf("        view %zu: tested %u, culled %u, visible %u\n", i,
+                    m_lastFrameViews[i].tested, m_lastFrameViews[i].culled, m_lastFrameViews[i].visible);
+    }
+}
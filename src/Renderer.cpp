@@ -1,5 +1,9 @@
 #include "Renderer.hpp"
 #include "Mirror.hpp"
+#include "GLState.hpp"
+#include "UniformBlocks.hpp"
+#include "TransformHierarchy.hpp"
+#include "SceneComponents.hpp"
 #include <iostream>
 
 // source: https://stackoverflow.com/questions/31064234/find-the-angle-between-two-vectors-from-an-arbitrary-origin
@@ -23,7 +27,7 @@ Renderer::Renderer(unsigned int w, unsigned int h){
     m_cameras.push_back(defaultCamera);
     m_cameras.push_back(rearViewCamera);
     // Initialize the root in our scene
-    m_root = nullptr;
+    m_root = SceneNodePool::kInvalidHandle;
 
     // By derfaflt create one framebuffer within the renderere.
     // create another framebuffer that sharpens the image
@@ -34,10 +38,16 @@ Renderer::Renderer(unsigned int w, unsigned int h){
     m_framebuffers.push_back(newFramebuffer);
     m_framebuffers.push_back(newFramebuffer2);
     active = m_framebuffers[1];
+
+    // Room for one frame of streamed data, three frames in flight
+    m_streamBuffer.Create(1024*1024);
 }
 
 // Sets the height and width of our renderer
 Renderer::~Renderer(){
+    m_streamBuffer.PrintStats("Renderer stream buffer");
+    m_renderQueue.PrintStats();
+    GLState::PrintStats();
     // Delete all of our camera pointers
     for(int i=0; i < m_cameras.size(); i++){
         delete m_cameras[i];
@@ -61,45 +71,50 @@ void Renderer::Update(){
 // Setup our OpenGL State machine
 // Then render the scene
 void Renderer::Render(){
-    // we will likely want to first go through all the items, and if any of them are mirrors, keep track of them because we will want to draw the world from each mirror's POV first
-    std::vector<Mirror *> mirrors;
-    m_root->FindMirrors(mirrors);
+    // Move on to the part of the stream buffer the GPU is done with
+    m_streamBuffer.BeginFrame();
+
+    // Everything that moved since the last frame gets its new world
+    // transform once here, instead of once per pass
+    TransformHierarchy::Instance().Update();
+    SceneComponents& components = SceneComponents::Instance();
+    components.UpdateBounds();
+    // Collect what to draw once, for every view below
+    m_renderQueue.Build(SceneNodePool::Instance().Get(m_root), m_streamBuffer);
+
+    // We want to draw the world from each mirror's POV first
+    ComponentArray<MirrorComponent>& mirrorComponents = components.mirrors;
 
     // iterate through all the mirrors
-    for (int i = 0; i < mirrors.size(); i++) {
+    for (unsigned int m = 0; m < mirrorComponents.GetCount(); m++) {
+        Mirror* mirror = mirrorComponents[m].mirror;
         // here, calculate the new direction of the camera
-        glm::vec3 diffFromPlayerToMirror(m_cameras[mirrors[i]->camera_id]->m_eyePosition.x - m_cameras[0]->m_eyePosition.x,0,m_cameras[mirrors[i]->camera_id]->m_eyePosition.z - m_cameras[0]->m_eyePosition.z);
+        glm::vec3 diffFromPlayerToMirror(m_cameras[mirror->camera_id]->m_eyePosition.x - m_cameras[0]->m_eyePosition.x,0,m_cameras[mirror->camera_id]->m_eyePosition.z - m_cameras[0]->m_eyePosition.z);
         diffFromPlayerToMirror = glm::normalize(diffFromPlayerToMirror);
-        m_cameras[mirrors[i]->camera_id]->m_viewDirection.x = diffFromPlayerToMirror.x;
-        m_cameras[mirrors[i]->camera_id]->m_viewDirection.z = diffFromPlayerToMirror.z;
+        m_cameras[mirror->camera_id]->m_viewDirection.x = diffFromPlayerToMirror.x;
+        m_cameras[mirror->camera_id]->m_viewDirection.z = diffFromPlayerToMirror.z;
 
         // render directly in front of the mirror if the camera reflection ends up behind the mirror
-        if (mirrors[i]->forwards.z > 0 && m_cameras[mirrors[i]->camera_id]->m_viewDirection.z < 0) {
-            m_cameras[mirrors[i]->camera_id]->m_viewDirection.z = 1;
+        if (mirror->forwards.z > 0 && m_cameras[mirror->camera_id]->m_viewDirection.z < 0) {
+            m_cameras[mirror->camera_id]->m_viewDirection.z = 1;
         }
-        else if (mirrors[i]->forwards.z < 0 && m_cameras[mirrors[i]->camera_id]->m_viewDirection.z > 0) {
-            m_cameras[mirrors[i]->camera_id]->m_viewDirection.z = -1;
+        else if (mirror->forwards.z < 0 && m_cameras[mirror->camera_id]->m_viewDirection.z > 0) {
+            m_cameras[mirror->camera_id]->m_viewDirection.z = -1;
         }
 
 
         // Logic for actually imprinting onto the framebuffer goes here
-        m_projectionMatrix = glm::perspective(45.0f,((float)m_screenWidth)/((float)m_screenHeight),0.1f,512.0f);
-        if(m_root!=nullptr){
-            // TODO: By default, we will only have one camera
-            //       You may otherwise not want to hardcode
-            //       a value of '0' here.
-            m_root->Update(m_projectionMatrix, m_cameras[mirrors[i]->camera_id]);
-        }
+        Camera* camera = m_cameras[mirror->camera_id];
+        UpdatePass(camera);
 
-        mirrors[i]->UpdateBuffer();
-        mirrors[i]->BindBuffer();
+        mirror->UpdateBuffer();
+        mirror->BindBuffer();
 
         // What we are doing, is telling opengl to create a depth(or Z-buffer) 
         // for us that is stored every frame.
-        glEnable(GL_DEPTH_TEST);
-        glEnable(GL_TEXTURE_2D); 
+        GLState::Enable(GL_DEPTH_TEST);
         // This is the background of the screen.
-        glViewport(0, 0, m_screenWidth, m_screenHeight);
+        GLState::SetViewport(0, 0, m_screenWidth, m_screenHeight);
         glClearColor( 0.55f, 0.45f, 1.0f, 1.f );
         // Clear color buffer and Depth Buffer
         // Remember that the 'depth buffer' is our
@@ -108,24 +123,16 @@ void Renderer::Render(){
         glClear(GL_DEPTH_BUFFER_BIT | GL_COLOR_BUFFER_BIT);
 
         // Now we render our objects from our scenegraph
-        if(m_root!=nullptr){
-            m_root->Draw();
-        }
+        m_renderQueue.Submit(*camera);
 
         // Finish with our framebuffer
-        mirrors[i]->UnbindBuffer();
+        mirror->UnbindBuffer();
     }
 
     for (int i = 0; i < m_framebuffers.size(); i++) {
-        m_projectionMatrix = glm::perspective(45.0f,((float)m_screenWidth)/((float)m_screenHeight),0.1f,512.0f);
-
         // Update the Uniforms of the game objects to be passed into shaders, based on the camera that this framebuffer belongs to.
-        if(m_root!=nullptr){
-            // TODO: By default, we will only have one camera
-            //       You may otherwise not want to hardcode
-            //       a value of '0' here.
-            m_root->Update(m_projectionMatrix, m_cameras[m_framebuffers[i]->camera_id]);
-        }
+        Camera* camera = m_cameras[m_framebuffers[i]->camera_id];
+        UpdatePass(camera);
 
         m_framebuffers[i]->Update();
         // Bind to our farmebuffer
@@ -133,10 +140,9 @@ void Renderer::Render(){
 
         // What we are doing, is telling opengl to create a depth(or Z-buffer) 
         // for us that is stored every frame.
-        glEnable(GL_DEPTH_TEST);
-        glEnable(GL_TEXTURE_2D); 
+        GLState::Enable(GL_DEPTH_TEST);
         // This is the background of the screen.
-        glViewport(0, 0, m_screenWidth, m_screenHeight);
+        GLState::SetViewport(0, 0, m_screenWidth, m_screenHeight);
         glClearColor( 0.55f, 0.45f, 1.0f, 1.f );
         // Clear color buffer and Depth Buffer
         // Remember that the 'depth buffer' is our
@@ -156,15 +162,13 @@ void Renderer::Render(){
         const Uint8* currentKeyStates = SDL_GetKeyboardState( NULL );
         if( currentKeyStates[ SDL_SCANCODE_W ] )
         {
-            glPolygonMode(GL_FRONT_AND_BACK,GL_LINE);
+            GLState::SetPolygonMode(GL_LINE);
         }else{
-            glPolygonMode(GL_FRONT_AND_BACK,GL_FILL);
+            GLState::SetPolygonMode(GL_FILL);
         }
         
         // Now we render our objects from our scenegraph
-        if(m_root!=nullptr){
-            m_root->Draw();
-        }
+        m_renderQueue.Submit(*camera);
 
         // Finish with our framebuffer
         m_framebuffers[i]->Unbind();
@@ -173,7 +177,7 @@ void Renderer::Render(){
     // Now draw a new scene
     // We do not need depth since we are drawing a '2D'
     // image over our screen.
-    glDisable(GL_DEPTH_TEST);
+    GLState::Disable(GL_DEPTH_TEST);
     // Clear everything away
     // Clear the screen color, and typically I do this
     // to something 'different' than our original as an
@@ -192,11 +196,64 @@ void Renderer::Render(){
         // Unselect our shader and continue
         m_framebuffers[i]->m_fboShader->Unbind();
     }
+
+    // Everything that reads this frame's streamed data has been issued
+    m_streamBuffer.EndFrame();
+    GLState::EndFrame();
+}
+
+// Everything every shader needs to know about this camera goes into
+// the stream buffer once, instead of into every program
+void Renderer::UpdatePass(Camera* camera){
+    m_projectionMatrix = glm::perspective(45.0f,((float)m_screenWidth)/((float)m_screenHeight),0.1f,512.0f);
+
+    camera->UpdateMatrices(m_projectionMatrix);
+
+    GLintptr offset = 0;
+    ViewBlock* view = static_cast<ViewBlock*>(m_streamBuffer.MapUniforms(sizeof(ViewBlock), offset));
+    if(view != nullptr){
+        view->view = camera->GetViewMatrix();
+        view->projection = camera->GetProjectionMatrix();
+        view->viewProjection = camera->GetViewProjectionMatrix();
+        view->eyePosition = glm::vec4(camera->m_eyePosition, 1.0f);
+        m_streamBuffer.Unmap();
+        GLState::BindUniformBufferRange(kViewBlockBinding, m_streamBuffer.GetBuffer(), offset, sizeof(ViewBlock));
+    }
+
+    // The lights of the scene, or if it has none, two lights just in
+    // front of the camera
+    LightBlock* lights = static_cast<LightBlock*>(m_streamBuffer.MapUniforms(sizeof(LightBlock), offset));
+    if(lights != nullptr && SceneComponents::Instance().FillLights(*lights) > 0){
+        m_streamBuffer.Unmap();
+        GLState::BindUniformBufferRange(kLightBlockBinding, m_streamBuffer.GetBuffer(), offset, sizeof(LightBlock));
+    }else if(lights != nullptr){
+        glm::vec3 lightPos = camera->m_eyePosition + camera->m_viewDirection;
+        // Create a first 'light'
+        PointLightData& first = lights->pointLights[0];
+        first.lightColor = glm::vec3(1.0f,1.0f,1.0f);
+        first.lightPos = lightPos;
+        first.ambientIntensity = 0.9f;
+        first.specularStrength = 0.5f;
+        first.constant = 1.0f;
+        first.linear = 0.003f;
+        first.quadratic = 0.0f;
+        // Create a second light
+        PointLightData& second = lights->pointLights[1];
+        second.lightColor = glm::vec3(1.0f,0.0f,0.0f);
+        second.lightPos = lightPos;
+        second.ambientIntensity = 0.9f;
+        second.specularStrength = 0.5f;
+        second.constant = 1.0f;
+        second.linear = 0.09f;
+        second.quadratic = 0.032f;
+        m_streamBuffer.Unmap();
+        GLState::BindUniformBufferRange(kLightBlockBinding, m_streamBuffer.GetBuffer(), offset, sizeof(LightBlock));
+    }
 }
 
 // Determines what the root is of the renderer, so the
 // scene can be drawn.
-void Renderer::setRoot(std::shared_ptr<SceneNode> startingNode){
+void Renderer::setRoot(SceneNodePool::Handle startingNode){
     m_root = startingNode;
 }
 
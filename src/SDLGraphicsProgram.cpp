@@ -6,6 +6,13 @@
 // Include the 'Renderer.hpp' which deteremines what
 // the graphics API is going to be for OpenGL
 #include "Renderer.hpp"
+#include "GeometryArena.hpp"
+#include "StreamBuffer.hpp"
+#include "GpuResource.hpp"
+#include "ShaderManager.hpp"
+#include "ProgramCache.hpp"
+#include "StaticBatch.hpp"
+#include "SceneNodePool.hpp"
 
 #include <iostream>
 #include <string>
@@ -61,6 +68,9 @@ SDLGraphicsProgram::SDLGraphicsProgram(int w, int h){
         std::cerr << "Failed to iniitalize GLAD\n";
         exit(EXIT_FAILURE);
     }
+    // glad only knows about OpenGL 3.3, newer functions are loaded here
+    StreamBuffer::LoadFunctions(SDL_GL_GetProcAddress);
+    ProgramCache::LoadFunctions(SDL_GL_GetProcAddress);
 
     // If initialization succeeds then print out a list of errors in the constructor.
     SDL_Log("SDLGraphicsProgram::SDLGraphicsProgram - No SDL, GLAD, or OpenGL errors detected during initialization\n\n");
@@ -72,6 +82,11 @@ SDLGraphicsProgram::SDLGraphicsProgram(int w, int h){
 
 // Proper shutdown of SDL and destroy initialized objects
 SDLGraphicsProgram::~SDLGraphicsProgram(){
+    // The shared mesh buffers outlive the scene, so free them
+    // while the OpenGL context is still around
+    GeometryArena::ReleaseAll();
+    // The scene is gone by now, so every GL object should have been freed
+    GpuResources::CheckLeaks();
     //Destroy window
 	SDL_DestroyWindow( m_window );
 	// Point m_window to NULL to ensure it points to nothing.
@@ -87,59 +102,56 @@ void SDLGraphicsProgram::SetLoopCallback(std::function<void(void)> callback){
     // Create a renderer
     std::shared_ptr<Renderer> renderer = std::make_shared<Renderer>(m_width,m_height);    
 
+    // Every node lives in the pool, and is destroyed with the root
+    // (the pointers stay valid until then)
+    SceneNodePool& nodes = SceneNodePool::Instance();
+
     // Create our terrain
     std::shared_ptr<Terrain> myTerrain = std::make_shared<Terrain>(512,512,"terrain3.ppm");
     myTerrain->LoadTextures("grass.ppm","grass.ppm");
 
     // Create a node for our terrain 
-    std::shared_ptr<SceneNode> terrainNode;
-    terrainNode = std::make_shared<SceneNode>(myTerrain,"./shaders/vert.glsl","./shaders/frag.glsl");
+    SceneNode* terrainNode = nodes.Get(nodes.Create(myTerrain,"./shaders/vert.glsl","./shaders/frag.glsl"));
     terrainNode->GetLocalTransform().Rotate(glm::radians(90.0f),0,1,0);
 
     // Create our "mirror"
     std::shared_ptr<Mirror> myMirror = std::make_shared<Mirror>("./shaders/defaultFrag.glsl", 0);
     myMirror->MakeTexturedQuad("cat3.ppm");
     myMirror->CreateBuffer(m_width, m_height);
-    std::shared_ptr<SceneNode> mirrorNode;
-    mirrorNode = std::make_shared<SceneNode>(myMirror,"./shaders/vert.glsl","./shaders/frag.glsl");
-    mirrorNode->is_mirror = true;
+    SceneNode* mirrorNode = nodes.Get(nodes.Create(myMirror,"./shaders/vert.glsl","./shaders/frag.glsl"));
+    mirrorNode->SetMirror(true);
 
     // the cat in the middle
     std::shared_ptr<Object> simpleQuad = std::make_shared<Object>();
     simpleQuad->MakeTexturedQuad("cat3.ppm");
-    std::shared_ptr<SceneNode> simpleQuadNode;
-    simpleQuadNode = std::make_shared<SceneNode>(simpleQuad,"./shaders/vert.glsl","./shaders/frag.glsl");
+    SceneNode* simpleQuadNode = nodes.Get(nodes.Create(simpleQuad,"./shaders/vert.glsl","./shaders/frag.glsl"));
 
     std::shared_ptr<Object> wall1 = std::make_shared<Object>();
     wall1->MakeTexturedQuad("cat3.ppm");
-    std::shared_ptr<SceneNode> wall1Node;
-    wall1Node = std::make_shared<SceneNode>(wall1,"./shaders/vert.glsl","./shaders/frag.glsl");
+    SceneNode* wall1Node = nodes.Get(nodes.Create(wall1,"./shaders/vert.glsl","./shaders/frag.glsl"));
 
     std::shared_ptr<Object> wall2 = std::make_shared<Object>();
     wall2->MakeTexturedQuad("cat3.ppm");
-    std::shared_ptr<SceneNode> wall2Node;
-    wall2Node = std::make_shared<SceneNode>(wall2,"./shaders/vert.glsl","./shaders/frag.glsl");
+    SceneNode* wall2Node = nodes.Get(nodes.Create(wall2,"./shaders/vert.glsl","./shaders/frag.glsl"));
 
     std::shared_ptr<Object> wall3 = std::make_shared<Object>();
     wall3->MakeTexturedQuad("cat3.ppm");
-    std::shared_ptr<SceneNode> wall3Node;
-    wall3Node = std::make_shared<SceneNode>(wall3,"./shaders/vert.glsl","./shaders/frag.glsl");
+    SceneNode* wall3Node = nodes.Get(nodes.Create(wall3,"./shaders/vert.glsl","./shaders/frag.glsl"));
 
     std::shared_ptr<Mirror> myQuad = std::make_shared<Mirror>("./shaders/defaultFrag.glsl", 0);
     myQuad->MakeTexturedQuad("cat3.ppm");
     myQuad->CreateBuffer(m_width, m_height);
-    std::shared_ptr<SceneNode> quadNode;
-    quadNode = std::make_shared<SceneNode>(myQuad,"./shaders/vert.glsl","./shaders/frag.glsl");
-    quadNode->is_mirror = true;
+    SceneNode* quadNode = nodes.Get(nodes.Create(myQuad,"./shaders/vert.glsl","./shaders/frag.glsl"));
+    quadNode->SetMirror(true);
 
     // Set our SceneTree up
-    terrainNode->AddChild(quadNode.get());
-    terrainNode->AddChild(simpleQuadNode.get());
-    terrainNode->AddChild(mirrorNode.get());
-    terrainNode->AddChild(wall1Node.get());
-    terrainNode->AddChild(wall2Node.get());
-    terrainNode->AddChild(wall3Node.get());
-    renderer->setRoot(terrainNode);
+    terrainNode->AddChild(quadNode->GetHandle());
+    terrainNode->AddChild(simpleQuadNode->GetHandle());
+    terrainNode->AddChild(mirrorNode->GetHandle());
+    terrainNode->AddChild(wall1Node->GetHandle());
+    terrainNode->AddChild(wall2Node->GetHandle());
+    terrainNode->AddChild(wall3Node->GetHandle());
+    renderer->setRoot(terrainNode->GetHandle());
 
     wall1Node->GetLocalTransform().Translate(95,16.5f,244);
     wall1Node->GetLocalTransform().Scale(15,15,0);
@@ -160,6 +172,13 @@ void SDLGraphicsProgram::SetLoopCallback(std::function<void(void)> callback){
     wall3Node->GetLocalTransform().Translate(135,16.5f,406);
     wall3Node->GetLocalTransform().Scale(15,15,0);
 
+    // The walls never move, so they are merged into one mesh and drawn
+    // together (the cat oscillates, so it stays a node of its own)
+    wall1Node->SetStatic(true);
+    wall2Node->SetStatic(true);
+    wall3Node->SetStatic(true);
+    StaticBatch::PrintStats(StaticBatch::Build(terrainNode, "./shaders/vert.glsl", "./shaders/frag.glsl"));
+
     // Set up the cameras for the mirrors, eventually we want to have the constructor be able to just set it up without any hardcoding.
     Camera * mirrorCamera = new Camera();
     mirrorCamera->SetCameraEyePosition(95,16.5f,245);
@@ -177,6 +196,13 @@ void SDLGraphicsProgram::SetLoopCallback(std::function<void(void)> callback){
     myQuad->forwards.y = 0;
     myQuad->forwards.z = -1;
 
+    // How full the shared mesh buffers are once the scene is loaded,
+    // and how much GPU memory everything takes
+    GeometryArena::PrintReports();
+    GpuResources::PrintReport();
+    ShaderManager::Instance().PrintStats();
+    ProgramCache::PrintStats();
+
     // Set a default position for our camera
     renderer->GetCamera(0)->SetCameraEyePosition(125.0f,50.0f,500.0f);
     renderer->GetCamera(1)->SetCameraEyePosition(renderer->GetCamera(0)->GetEyeXPosition(),renderer->GetCamera(0)->GetEyeYPosition(),renderer->GetCamera(0)->GetEyeZPosition());
@@ -284,6 +310,10 @@ void SDLGraphicsProgram::SetLoopCallback(std::function<void(void)> callback){
 	}
     //Disable text input
     SDL_StopTextInput();
+    GeometryArena::PrintReports();
+    // The whole scene goes with its root, while the OpenGL context is
+    // still around
+    nodes.Destroy(terrainNode->GetHandle());
 }
 
 
@@ -0,0 +1,70 @@
+#include "SceneComponents.hpp"
+#include "SceneNode.hpp"
+#include "Object.hpp"
+#include "Mesh.hpp"
+
+#include <algorithm>
+#include <iostream>
+
+SceneComponents& SceneComponents::Instance(){
+    static SceneComponents* instance = new SceneComponents();
+    return *instance;
+}
+
+void SceneComponents::RemoveAll(SceneNodePool::Handle node){
+    RenderableComponent* renderable = renderables.Get(node);
+    if(renderable != nullptr && renderable->proxy != AABBTree::kNullProxy){
+        AABBTree::Instance().Remove(renderable->proxy);
+    }
+    renderables.Remove(node);
+    mirrors.Remove(node);
+    lights.Remove(node);
+}
+
+// Only renderables whose world transform changed since last time are
+// moved, and most moves stay within the proxy's margin
+void SceneComponents::UpdateBounds(){
+    TransformHierarchy& transforms = TransformHierarchy::Instance();
+    AABBTree& tree = AABBTree::Instance();
+    for(RenderableComponent& renderable : renderables){
+        std::shared_ptr<Mesh> mesh = renderable.object->GetMesh();
+        if(mesh == nullptr || mesh->GetBounds().IsEmpty()){
+            continue;
+        }
+        const Transform& world = transforms.GetWorld(renderable.transform);
+        if(renderable.proxy != AABBTree::kNullProxy && world.GetVersion() == renderable.boundsVersion){
+            continue;
+        }
+        // A static node must not move once batched: its batch would keep
+        // drawing it where it was
+        if(!renderable.reportedBatchedMove && renderable.node->HasMovedSinceBatched()){
+            std::cout << "(SceneComponents.cpp) ERROR, static node " << renderable.node->GetHandle()
+                      << " moved after it was batched; its batch still draws it where it was\n";
+            renderable.reportedBatchedMove = true;
+        }
+        Bounds bounds = mesh->GetBounds().Transformed(world.GetInternalMatrix());
+        if(renderable.proxy == AABBTree::kNullProxy){
+            renderable.proxy = tree.Insert(bounds, renderable.node);
+        }else{
+            tree.Move(renderable.proxy, bounds);
+        }
+        renderable.boundsVersion = world.GetVersion();
+    }
+}
+
+// Unused entries are black, so they add nothing
+unsigned int SceneComponents::FillLights(LightBlock& block) const{
+    const TransformHierarchy& transforms = TransformHierarchy::Instance();
+    const unsigned int count = std::min<unsigned int>(lights.GetCount(), LightBlock::kPointLightCount);
+    for(unsigned int i=0; i < count; ++i){
+        const LightComponent& component = lights[i];
+        PointLightData& light = block.pointLights[i];
+        light = component.light;
+        light.lightPos = glm::vec3(transforms.GetWorld(component.transform).GetInternalMatrix() * glm::vec4(component.light.lightPos, 1.0f));
+    }
+    for(unsigned int i=count; i < LightBlock::kPointLightCount; ++i){
+        block.pointLights[i] = PointLightData{};
+        block.pointLights[i].constant = 1.0f;
+    }
+    return lights.GetCount();
+}
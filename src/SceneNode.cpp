@@ -1,6 +1,9 @@
 #include "SceneNode.hpp"
 #include "Mirror.hpp"
+#include "ShaderManager.hpp"
+#include "SceneComponents.hpp"
 
+#include <algorithm>
 #include <string>
 #include <iostream>
 #include <typeinfo>
@@ -11,119 +14,98 @@ SceneNode::SceneNode(std::shared_ptr<Object> ob, std::string vertShader, std::st
 	m_object = ob;
 
     // By default no parent.
-    m_parent = nullptr;
+    m_parent = SceneNodePool::kInvalidHandle;
+    m_transform = TransformHierarchy::Instance().Create();
 	
-    // Create shader
-    m_shader = std::make_shared<Shader>();
-	// Setup shaders for the node.
-	std::string vertexShader   = m_shader->LoadShader(vertShader);
-	std::string fragmentShader = m_shader->LoadShader(fragShader);
-
-	// Actually create our shader
-	m_shader->CreateShader(vertexShader,fragmentShader);       
+    // Get our shader. Nodes with the same shader files (and objects
+    // that need the same variant of them) share one program, which is
+    // only compiled for the first of them.
+    ShaderFeatures features;
+    if(m_object!=nullptr){
+        features = m_object->GetShaderFeatures();
+    }
+    m_shader = ShaderManager::Instance().Get(vertShader, fragShader, features.GetDefines());
 
-    // is mirror is false by default
-    is_mirror = false;
+    // The texture units never change, so they are set once here.
+    // For our object, we apply the texture in the following way
+    // Note that we set the value to 0, because we have bound
+    // our texture to slot 0.
+    m_shader->Bind();
+    m_shader->SetUniform1i(m_shader->GetUniform("u_DiffuseMap", GL_INT),0);  
+    if(features.detailMap){
+        m_shader->SetUniform1i(m_shader->GetUniform("u_DetailMap", GL_INT),1);
+    }
 }
 
-// The destructor 
+// The destructor. SceneNodePool has already destroyed our children.
 SceneNode::~SceneNode(){
-    // Remove all of the children
-    for(int i=0; i < m_children.size(); i++){
-        delete m_children[i];
+    SceneComponents::Instance().RemoveAll(m_handle);
+    TransformHierarchy::Instance().Destroy(m_transform);
+}
+
+// Every node with an object is drawn, and has bounds to keep up to date
+void SceneNode::OnCreated(){
+    if(m_object!=nullptr){
+        RenderableComponent renderable;
+        renderable.node = this;
+        renderable.object = m_object.get();
+        renderable.transform = m_transform;
+        SceneComponents::Instance().renderables.Add(m_handle, renderable);
     }
 }
 
 // Adds a child node to our current node.
-void SceneNode::AddChild(SceneNode* n){
+void SceneNode::AddChild(SceneNodePool::Handle child){
+	SceneNodePool& pool = SceneNodePool::Instance();
+	SceneNode* n = pool.Get(child);
+	if(n == nullptr){
+		std::cout << "(SceneNode.cpp) ERROR, adding a child that does not exist\n";
+		return;
+	}
+	// A node cannot be below itself
+	for(SceneNodePool::Handle above = m_handle; above != SceneNodePool::kInvalidHandle; above = pool.Get(above)->m_parent){
+		if(above == child){
+			std::cout << "(SceneNode.cpp) ERROR, a node cannot be its own ancestor\n";
+			return;
+		}
+	}
+	// Leave the old parent first
+	SceneNode* oldParent = pool.Get(n->m_parent);
+	if(oldParent != nullptr){
+		std::vector<SceneNodePool::Handle>& siblings = oldParent->m_children;
+		siblings.erase(std::remove(siblings.begin(), siblings.end(), child), siblings.end());
+	}
 	// For the node we have added, we can set
 	// it's parent now to our current node.
-	// 'this' is the current instance of our
-	// object, which is a pointer to our current
-	// SceneNode.
-	n->m_parent = this;
+	n->m_parent = m_handle;
 	// Add a child node into our SceneNode
-	m_children.push_back(n);
+	m_children.push_back(child);
+	// Our transform now applies to the child
+	TransformHierarchy::Instance().SetParent(n->m_transform, m_transform);
 }
 
-// Draw simply draws the current nodes
-// object and all of its children. This is done by calling directly
-// the objects draw method.
-void SceneNode::Draw(){
-	// Bind the shader for this node or series of nodes
-	m_shader->Bind();
-	// Render our object
-	if(m_object!=nullptr){
-		// Render our object
-		m_object->Render();
-		// For any 'child nodes' also call the drawing routine.
-		for(int i =0; i < m_children.size(); ++i){
-			m_children[i]->Draw();
-		}
-	}	
+SceneNodePool::Handle SceneNode::GetHandle() const{
+    return m_handle;
 }
 
-// Update simply updates the current nodes
-// object. This is done by calling directly
-// the objects update method.
-// TODO: Consider not passting projection and camera here
-void SceneNode::Update(glm::mat4 projectionMatrix, Camera* camera){
-    if(m_object!=nullptr){
-        // TODO: Implement here!
-    
-        if (m_parent) {
-			m_worldTransform = m_parent->m_worldTransform * m_localTransform;
-		}	
-		else {
-			m_worldTransform = m_localTransform;
-		}
-        m_object->Bind();
-    	// Now apply our shader 
-		m_shader->Bind();
-    	// Set the uniforms in our current shader
-
-        // For our object, we apply the texture in the following way
-        // Note that we set the value to 0, because we have bound
-        // our texture to slot 0.
-        m_shader->SetUniform1i("u_DiffuseMap",0);  
-        // TODO: This assumes every SceneNode is a 'Terrain' so this shader setup code
-        //       needs to be moved preferably to 'Object' or 'Terrain'
-        m_shader->SetUniform1i("u_DetailMap",1);  
-        // Set the MVP Matrix for our object
-        // Send it into our shader
-        m_shader->SetUniformMatrix4fv("model", &m_worldTransform.GetInternalMatrix()[0][0]);
-        m_shader->SetUniformMatrix4fv("view", &camera->GetWorldToViewmatrix()[0][0]);
-        m_shader->SetUniformMatrix4fv("projection", &projectionMatrix[0][0]);
-
-        // Create a 'light'
-        // Create a first 'light'
-        m_shader->SetUniform3f("pointLights[0].lightColor",1.0f,1.0f,1.0f);
-        m_shader->SetUniform3f("pointLights[0].lightPos",
-           camera->GetEyeXPosition() + camera->GetViewXDirection(),
-           camera->GetEyeYPosition() + camera->GetViewYDirection(),
-           camera->GetEyeZPosition() + camera->GetViewZDirection());
-        m_shader->SetUniform1f("pointLights[0].ambientIntensity",0.9f);
-        m_shader->SetUniform1f("pointLights[0].specularStrength",0.5f);
-        m_shader->SetUniform1f("pointLights[0].constant",1.0f);
-        m_shader->SetUniform1f("pointLights[0].linear",0.003f);
-        m_shader->SetUniform1f("pointLights[0].quadratic",0.0f);
-		
-		// Create a second light
-        m_shader->SetUniform3f("pointLights[1].lightColor",1.0f,0.0f,0.0f);
-        m_shader->SetUniform3f("pointLights[1].lightPos",
-           camera->GetEyeXPosition() + camera->GetViewXDirection(),
-           camera->GetEyeYPosition() + camera->GetViewYDirection(),
-           camera->GetEyeZPosition() + camera->GetViewZDirection());
-        m_shader->SetUniform1f("pointLights[1].ambientIntensity",0.9f);
-        m_shader->SetUniform1f("pointLights[1].specularStrength",0.5f);
-        m_shader->SetUniform1f("pointLights[1].constant",1.0f);
-        m_shader->SetUniform1f("pointLights[1].linear",0.09f);
-        m_shader->SetUniform1f("pointLights[1].quadratic",0.032f);
+SceneNodePool::Handle SceneNode::GetParent() const{
+    return m_parent;
+}
 
-	
-		// Iterate through all of the children
+// Enqueue collects what the current node's object needs to be drawn,
+// then does the same for all of its children. The scene graph is only
+// walked once per frame; every view draws from the queue.
+void SceneNode::Enqueue(RenderQueue& queue, uint32_t parent){
+	if(m_object!=nullptr){
+		// A batch draws our object for us
+		uint32_t packet = parent;
+		if(!m_batched){
+			packet = queue.Add(m_object.get(), m_shader.get(), m_transform, parent);
+		}
+		// For any 'child nodes' also add them
+		SceneNodePool& pool = SceneNodePool::Instance();
 		for(int i =0; i < m_children.size(); ++i){
-			m_children[i]->Update(projectionMatrix, camera);
+			pool.Get(m_children[i])->Enqueue(queue, packet);
 		}
 	}
 }
@@ -131,20 +113,78 @@ void SceneNode::Update(glm::mat4 projectionMatrix, Camera* camera){
 // Returns the actual local transform stored in our SceneNode
 // which can then be modified
 Transform& SceneNode::GetLocalTransform(){
-    return m_localTransform; 
+    return TransformHierarchy::Instance().GetLocal(m_transform); 
 }
 
-// Returns the worled  transform stored in our SceneNode
-// which can then be modified
-Transform& SceneNode::GetWorldTransform(){
-    return m_worldTransform; 
+// Returns the world transform stored in our SceneNode, as of the
+// last UpdateTransforms
+const Transform& SceneNode::GetWorldTransform() const{
+    return TransformHierarchy::Instance().GetWorld(m_transform); 
 }
 
-void SceneNode::FindMirrors(std::vector<Mirror *> & mirrors) {
-    if (is_mirror) {
-        mirrors.push_back((Mirror *) m_object.get());
+uint32_t SceneNode::GetWorldVersion() const{
+    return GetWorldTransform().GetVersion();
+}
+
+void SceneNode::SetStatic(bool isStatic){
+    m_static = isStatic;
+}
+
+bool SceneNode::IsStatic() const{
+    return m_static;
+}
+
+bool SceneNode::IsBatched() const{
+    return m_batched;
+}
+
+// Only called when our world transform changed, so the inverse is rare.
+// The batch sits under the root, so the root moving us is fine.
+bool SceneNode::HasMovedSinceBatched() const{
+    SceneNode* batch = SceneNodePool::Instance().Get(m_batch);
+    if(!m_batched || batch == nullptr){
+        return false;
     }
-    for (int i = 0; i < m_children.size(); i++) {
-        m_children[i]->FindMirrors(mirrors);
+    const glm::mat4 relative = glm::inverse(batch->GetWorldTransform().GetInternalMatrix()) * GetWorldTransform().GetInternalMatrix();
+    for(int column=0; column < 4; ++column){
+        const glm::vec4 difference = glm::abs(relative[column] - m_batchedTransform[column]);
+        if(glm::max(glm::max(difference.x, difference.y), glm::max(difference.z, difference.w)) > 1e-4f){
+            return true;
+        }
     }
-}
\ No newline at end of file
+    return false;
+}
+
+AABBTree::Proxy SceneNode::GetProxy() const{
+    RenderableComponent* renderable = SceneComponents::Instance().renderables.Get(m_handle);
+    return renderable != nullptr ? renderable->proxy : AABBTree::kNullProxy;
+}
+
+// The object is checked once here, so the renderer can use the Mirror
+// without casting
+bool SceneNode::SetMirror(bool isMirror){
+    SceneComponents& components = SceneComponents::Instance();
+    if(!isMirror){
+        components.mirrors.Remove(m_handle);
+        return true;
+    }
+    Mirror* mirror = dynamic_cast<Mirror*>(m_object.get());
+    if(mirror == nullptr){
+        std::cout << "(SceneNode.cpp) ERROR, only a node with a Mirror object can be a mirror\n";
+        return false;
+    }
+    components.mirrors.Add(m_handle, MirrorComponent{mirror});
+    return true;
+}
+
+bool SceneNode::IsMirror() const{
+    return SceneComponents::Instance().mirrors.Has(m_handle);
+}
+
+void SceneNode::SetLight(const PointLightData& light){
+    SceneComponents::Instance().lights.Add(m_handle, LightComponent{light, m_transform});
+}
+
+void SceneNode::RemoveLight(){
+    SceneComponents::Instance().lights.Remove(m_handle);
+}
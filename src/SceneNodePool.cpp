@@ -0,0 +1,99 @@
+#include "SceneNodePool.hpp"
+#include "SceneNode.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <new>
+
+struct SceneNodePool::Chunk{
+    alignas(SceneNode) unsigned char bytes[kChunkSize * sizeof(SceneNode)];
+};
+
+SceneNodePool& SceneNodePool::Instance(){
+    static SceneNodePool* instance = new SceneNodePool();
+    return *instance;
+}
+
+SceneNodePool::SceneNodePool(){
+}
+
+// Reuses the most recently freed slot, or the next one at the end
+SceneNodePool::Handle SceneNodePool::Create(std::shared_ptr<Object> object, const std::string& vertShader, const std::string& fragShader){
+    uint32_t slot;
+    if(!m_freeSlots.empty()){
+        slot = m_freeSlots.back();
+        m_freeSlots.pop_back();
+    }else{
+        slot = m_generations.size();
+        // The last slot would make kInvalidHandle
+        if(slot >= kSlotMask){
+            std::cout << "(SceneNodePool.cpp) ERROR, too many scene nodes\n";
+            return kInvalidHandle;
+        }
+        if(slot / kChunkSize >= m_chunks.size()){
+            m_chunks.push_back(new Chunk());
+        }
+        m_generations.push_back(0);
+        m_alive.push_back(0);
+    }
+    const Handle handle = ((Handle)m_generations[slot] << kSlotBits) | slot;
+    SceneNode* node = new (GetSlot(slot)) SceneNode(object, vertShader, fragShader);
+    node->m_handle = handle;
+    node->OnCreated();
+    m_alive[slot] = 1;
+    ++m_count;
+    return handle;
+}
+
+void SceneNodePool::Destroy(Handle node){
+    SceneNode* destroyed = Get(node);
+    if(destroyed == nullptr){
+        std::cout << "(SceneNodePool.cpp) ERROR, destroying a node that does not exist\n";
+        return;
+    }
+    SceneNode* parent = Get(destroyed->m_parent);
+    if(parent != nullptr){
+        std::vector<Handle>& siblings = parent->m_children;
+        siblings.erase(std::remove(siblings.begin(), siblings.end(), node), siblings.end());
+    }
+    DestroySubtree(node);
+}
+
+SceneNode* SceneNodePool::Get(Handle node) const{
+    const uint32_t slot = node & kSlotMask;
+    if(slot >= m_generations.size() || !m_alive[slot] || m_generations[slot] != (node >> kSlotBits)){
+        return nullptr;
+    }
+    return GetSlot(slot);
+}
+
+unsigned int SceneNodePool::GetCount() const{
+    return m_count;
+}
+
+unsigned int SceneNodePool::GetCapacity() const{
+    return m_chunks.size() * kChunkSize;
+}
+
+SceneNode* SceneNodePool::GetSlot(uint32_t slot) const{
+    return reinterpret_cast<SceneNode*>(m_chunks[slot / kChunkSize]->bytes + (slot % kChunkSize) * sizeof(SceneNode));
+}
+
+// Children first, so a child never outlives its parent
+void SceneNodePool::DestroySubtree(Handle node){
+    SceneNode* destroyed = Get(node);
+    if(destroyed == nullptr){
+        return;
+    }
+    std::vector<Handle> children;
+    children.swap(destroyed->m_children);
+    for(Handle child : children){
+        DestroySubtree(child);
+    }
+    destroyed->~SceneNode();
+    const uint32_t slot = node & kSlotMask;
+    m_alive[slot] = 0;
+    m_generations[slot] = (m_generations[slot] + 1) & kGenerationMask;
+    m_freeSlots.push_back(slot);
+    --m_count;
+}
@@ -1,7 +1,37 @@
 #include "Shader.hpp"
+#include "GLState.hpp"
+#include "UniformBlocks.hpp"
+#include "ProgramCache.hpp"
 
 #include <iostream>
 #include <fstream>
+#include <algorithm>
+#include <cstring>
+#include <chrono>
+
+namespace{
+    // Every uniform block any of our shaders may declare
+    struct UniformBlock{
+        const char* name;
+        GLuint binding;
+    };
+    const UniformBlock kUniformBlocks[] = {
+        {"ViewBlock", kViewBlockBinding},
+        {"LightBlock", kLightBlockBinding},
+        {"ObjectBlock", kObjectBlockBinding}
+    };
+
+    // Uniforms set with glUniform1i may be ints, bools or samplers
+    bool IsIntegerType(GLenum type){
+        switch(type){
+            case GL_INT: case GL_BOOL:
+            case GL_SAMPLER_1D: case GL_SAMPLER_2D: case GL_SAMPLER_3D: case GL_SAMPLER_CUBE:
+            case GL_SAMPLER_2D_SHADOW: case GL_SAMPLER_2D_ARRAY: case GL_SAMPLER_BUFFER:
+                return true;
+        }
+        return false;
+    }
+}
 
 // Constructor
 Shader::Shader(){}
@@ -10,17 +40,18 @@ Shader::Shader(){}
 Shader::~Shader(){
 	// Deallocate Program
 	glDeleteProgram(m_shaderID);
+	GLState::ForgetProgram(m_shaderID);
 }
 
-// Use our shader
+// Use our shader (nothing happens if it already is in use)
 void Shader::Bind() const{
-	glUseProgram(m_shaderID);
+	GLState::UseProgram(m_shaderID);
 }
 
 
 // Turns off our shader
 void Shader::Unbind() const{
-	glUseProgram(0);
+	GLState::UseProgram(0);
 }
 
 void Shader::Log(const char* system, const char* message){
@@ -50,10 +81,26 @@ std::string Shader::LoadShader(const std::string& fname){
 }
 
 
-void Shader::CreateShader(const std::string& vertexShaderSource, const std::string& fragmentShaderSource){
+void Shader::CreateShader(const std::string& vertexShaderSource, const std::string& fragmentShaderSource, uint64_t sourceKey){
+    using Clock = std::chrono::steady_clock;
+    Clock::time_point start = Clock::now();
 
     // Create a new program
     unsigned int program = glCreateProgram();
+
+    // A program linked by an earlier run skips compiling altogether
+    uint64_t key = ProgramCache::GetKey(sourceKey);
+    double compileMilliseconds = 0.0;
+    if(ProgramCache::Load(key, program, compileMilliseconds)){
+        double loadMilliseconds = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        ProgramCache::CountHit(loadMilliseconds, compileMilliseconds);
+        m_shaderID = program;
+        ReadUniforms();
+        BindUniformBlocks();
+        return;
+    }
+
+    ProgramCache::PrepareProgram(program);
     // Compile our shaders
     unsigned int myVertexShader = CompileShader(GL_VERTEX_SHADER, vertexShaderSource);
     unsigned int myFragmentShader = CompileShader(GL_FRAGMENT_SHADER, fragmentShaderSource);
@@ -63,7 +110,6 @@ void Shader::CreateShader(const std::string& vertexShaderSource, const std::stri
     glAttachShader(program,myFragmentShader);
     // Link our programs that have been 'attached'
     glLinkProgram(program);
-    glValidateProgram(program);
 
     // Once the shaders have been linked in, we can delete them.
     glDetachShader(program,myVertexShader);
@@ -74,9 +120,80 @@ void Shader::CreateShader(const std::string& vertexShaderSource, const std::stri
 
     if(!CheckLinkStatus(program)){
         Log("CreateShader","ERROR, shader did not link! Were there compile errors in the shader?");
+    }else{
+        compileMilliseconds = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        ProgramCache::CountMiss(compileMilliseconds);
+        ProgramCache::Save(key, program, compileMilliseconds);
     }
 
     m_shaderID = program;
+    ReadUniforms();
+    BindUniformBlocks();
+}
+
+void Shader::BindUniformBlocks(){
+    for(const UniformBlock& block : kUniformBlocks){
+        GLuint index = glGetUniformBlockIndex(m_shaderID, block.name);
+        if(index != GL_INVALID_INDEX){
+            glUniformBlockBinding(m_shaderID, index, block.binding);
+        }
+    }
+}
+
+// Asks the linked program for all of its uniforms, once.
+// Arrays of basic types are reported once as "name[0]" with their size,
+// so every element (and the plain name) is added separately. Members of
+// arrays of structs are already reported one by one.
+void Shader::ReadUniforms(){
+    m_uniforms.clear();
+    GLint count = 0;
+    GLint maxLength = 0;
+    glGetProgramiv(m_shaderID, GL_ACTIVE_UNIFORMS, &count);
+    glGetProgramiv(m_shaderID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+    std::vector<char> buffer(maxLength > 0 ? maxLength : 1);
+    for(GLint i=0; i < count; ++i){
+        GLsizei length = 0;
+        GLint size = 0;
+        GLenum type = 0;
+        glGetActiveUniform(m_shaderID, i, buffer.size(), &length, &size, &type, buffer.data());
+        std::string name(buffer.data(), length);
+        GLint location = glGetUniformLocation(m_shaderID, name.c_str());
+        // Uniforms inside uniform blocks have no location
+        if(location < 0){
+            continue;
+        }
+        if(size > 1 && name.size() > 3 && name.compare(name.size()-3, 3, "[0]") == 0){
+            std::string base = name.substr(0, name.size()-3);
+            m_uniforms.push_back({base, location, type});
+            for(GLint element=0; element < size; ++element){
+                std::string elementName = base + "[" + std::to_string(element) + "]";
+                m_uniforms.push_back({elementName, glGetUniformLocation(m_shaderID, elementName.c_str()), type});
+            }
+        }else{
+            m_uniforms.push_back({name, location, type});
+        }
+    }
+    std::sort(m_uniforms.begin(), m_uniforms.end(), [](const UniformInfo& a, const UniformInfo& b){
+        return a.name < b.name;
+    });
+}
+
+Shader::Uniform Shader::GetUniform(const char* name, GLenum type) const{
+    Uniform uniform;
+    auto found = std::lower_bound(m_uniforms.begin(), m_uniforms.end(), name, [](const UniformInfo& info, const char* key){
+        return std::strcmp(info.name.c_str(), key) < 0;
+    });
+    if(found == m_uniforms.end() || found->name != name){
+        return uniform;
+    }
+    if(found->type != type && !(type == GL_INT && IsIntegerType(found->type))){
+        std::cout << "(Shader.cpp) ERROR, uniform " << name << " has GL type 0x" << std::hex << found->type
+                  << ", not 0x" << type << std::dec << "\n";
+        return uniform;
+    }
+    uniform.location = found->location;
+    uniform.type = found->type;
+    return uniform;
 }
 
 
@@ -150,30 +267,50 @@ GLuint Shader::GetID() const{
 
 
 // Set our uniforms for our shader.
+// Note that we are now 'looking' inside the shader for a particular
+// variable. This means the name has to exactly match!
+// (Prefer GetUniform once and the Uniform versions below.)
 void Shader::SetUniformMatrix4fv(const GLchar* name, const GLfloat* value){
-    // Note that we are now 'looking' inside the shader for a particular
-    // variable. This means the name has to exactly match!
-    GLint location = glGetUniformLocation(m_shaderID,name);
-
-    // Now update this information through our uniforms.
-    // glUniformMatrix4v means a 4x4 matrix of floats
-    glUniformMatrix4fv(location, 1, GL_FALSE, value);
+    SetUniformMatrix4fv(GetUniform(name, GL_FLOAT_MAT4), value);
 }
 
 // Set our uniforms for our shader (Useful for a vec3).
 void Shader::SetUniform3f(const GLchar* name, float v0, float v1, float v2){
-    GLint location = glGetUniformLocation(m_shaderID,name);
-    glUniform3f(location, v0, v1, v2);
+    SetUniform3f(GetUniform(name, GL_FLOAT_VEC3), v0, v1, v2);
 }
 
 // Sets 1 int value in our uniform (That is why the suffix is 1i).
 void Shader::SetUniform1i(const GLchar* name, int value){
-    GLint location = glGetUniformLocation(m_shaderID,name);
-    glUniform1i(location, value);
+    SetUniform1i(GetUniform(name, GL_INT), value);
 }
 
 // Sets 1 float value in our uniform (That is why the suffix is 1f).
 void Shader::SetUniform1f(const GLchar* name, float value){
-    GLint location = glGetUniformLocation(m_shaderID,name);
-    glUniform1f(location, value);
+    SetUniform1f(GetUniform(name, GL_FLOAT), value);
+}
+
+// Now update this information through our uniforms.
+// glUniformMatrix4v means a 4x4 matrix of floats
+void Shader::SetUniformMatrix4fv(Uniform uniform, const GLfloat* value){
+    if(uniform.IsValid()){
+        glUniformMatrix4fv(uniform.location, 1, GL_FALSE, value);
+    }
+}
+
+void Shader::SetUniform3f(Uniform uniform, float v0, float v1, float v2){
+    if(uniform.IsValid()){
+        glUniform3f(uniform.location, v0, v1, v2);
+    }
+}
+
+void Shader::SetUniform1i(Uniform uniform, int value){
+    if(uniform.IsValid()){
+        glUniform1i(uniform.location, value);
+    }
+}
+
+void Shader::SetUniform1f(Uniform uniform, float value){
+    if(uniform.IsValid()){
+        glUniform1f(uniform.location, value);
+    }
 }
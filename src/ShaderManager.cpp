@@ -0,0 +1,81 @@
+#include "ShaderManager.hpp"
+#include "Hash.hpp"
+
+#include <iostream>
+
+ShaderManager& ShaderManager::Instance(){
+    static ShaderManager* instance = new ShaderManager();
+    return *instance;
+}
+
+// Find or build the program for these sources
+std::shared_ptr<Shader> ShaderManager::Get(const std::string& vertexPath, const std::string& fragmentPath,
+                                           const std::vector<std::string>& defines){
+    ++m_requests;
+    // Reading the files is cheap next to compiling them, and hashing the
+    // text (rather than the paths) means an edited file is never
+    // mistaken for the program built from the old one
+    std::string vertexSource = Preprocess(Shader::LoadShader(vertexPath), defines);
+    std::string fragmentSource = Preprocess(Shader::LoadShader(fragmentPath), defines);
+    uint64_t key = HashProgramSources(vertexSource, fragmentSource);
+
+    std::shared_ptr<Shader> shader = m_programs[key].lock();
+    if(shader != nullptr){
+        return shader;
+    }
+    std::cout << "(ShaderManager.cpp) Building program " << vertexPath << " + " << fragmentPath;
+    for(const std::string& define : defines){
+        std::cout << " " << define;
+    }
+    std::cout << "\n";
+    shader = std::make_shared<Shader>();
+    shader->CreateShader(vertexSource, fragmentSource, key);
+    m_programs[key] = shader;
+    ++m_compiles;
+    return shader;
+}
+
+// Count the programs that are still in use (and forget the others)
+unsigned int ShaderManager::GetProgramCount(){
+    unsigned int count = 0;
+    for(auto it = m_programs.begin(); it != m_programs.end();){
+        if(it->second.expired()){
+            it = m_programs.erase(it);
+        }else{
+            ++count;
+            ++it;
+        }
+    }
+    return count;
+}
+
+void ShaderManager::PrintStats(){
+    std::cout << "(ShaderManager.cpp) " << m_requests << " programs requested, "
+              << m_compiles << " compiled, " << GetProgramCount() << " alive\n";
+}
+
+// GLSL requires #version to come first, so the defines go after it
+std::string ShaderManager::Preprocess(const std::string& source, const std::vector<std::string>& defines){
+    if(defines.empty()){
+        return source;
+    }
+    std::string block;
+    for(const std::string& define : defines){
+        // "NAME=VALUE" becomes "#define NAME VALUE"
+        std::string line = define;
+        size_t equals = line.find('=');
+        if(equals != std::string::npos){
+            line[equals] = ' ';
+        }
+        block += "#define " + line + "\n";
+    }
+    size_t version = source.find("#version");
+    if(version == std::string::npos){
+        return block + source;
+    }
+    size_t lineEnd = source.find('\n', version);
+    if(lineEnd == std::string::npos){
+        return source + "\n" + block;
+    }
+    return source.substr(0, lineEnd + 1) + block + source.substr(lineEnd + 1);
+}
@@ -0,0 +1,130 @@
+#include "StaticBatch.hpp"
+#include "SceneNode.hpp"
+#include "Mesh.hpp"
+#include "VertexBufferLayout.hpp"
+
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <utility>
+
+namespace{
+    // Batches of fewer nodes would not save a draw
+    const size_t kMinNodesPerBatch = 2;
+}
+
+void StaticBatch::Collect(SceneNode* node, std::vector<SceneNode*>& nodes){
+    std::shared_ptr<Mesh> mesh = node->m_object != nullptr ? node->m_object->GetMesh() : nullptr;
+    if(node->m_static && !node->m_batched && !node->IsMirror() && mesh != nullptr
+       && node->m_object->CanInstance() && mesh->GetGeometry().GetBufferDataSize() > 0
+       && !node->m_object->GetDiffuseTexture().GetFilePath().empty()){
+        nodes.push_back(node);
+    }
+    for(SceneNodePool::Handle child : node->m_children){
+        Collect(SceneNodePool::Instance().Get(child), nodes);
+    }
+}
+
+// Vertices are in the VertexFormat::Normal layout: position, normal,
+// texture coordinate, tangent and bi-tangent
+StaticBatch::Stats StaticBatch::Build(SceneNode* root, const std::string& vertShader, const std::string& fragShader){
+    Stats stats{};
+    if(root == nullptr){
+        return stats;
+    }
+    TransformHierarchy::Instance().Update();
+
+    std::vector<SceneNode*> nodes;
+    for(SceneNodePool::Handle child : root->m_children){
+        Collect(SceneNodePool::Instance().Get(child), nodes);
+    }
+    // Nodes that can share a draw: same program, same texture file
+    std::map<std::pair<Shader*, std::string>, std::vector<SceneNode*>> groups;
+    for(SceneNode* node : nodes){
+        groups[std::make_pair(node->m_shader.get(), node->m_object->GetDiffuseTexture().GetFilePath())].push_back(node);
+    }
+
+    const unsigned int stride = VertexBufferLayout::GetStride(VertexFormat::Normal);
+    const glm::mat4 rootInverse = glm::inverse(root->GetWorldTransform().GetInternalMatrix());
+    for(auto& group : groups){
+        const std::vector<SceneNode*>& members = group.second;
+        if(members.size() < kMinNodesPerBatch){
+            continue;
+        }
+        std::vector<float> vertices;
+        std::vector<unsigned int> indices;
+        std::vector<Meshlet> meshlets;
+        for(SceneNode* node : members){
+            std::shared_ptr<Mesh> mesh = node->m_object->GetMesh();
+            Geometry& geometry = mesh->GetGeometry();
+            const glm::mat4 relative = rootInverse * node->GetWorldTransform().GetInternalMatrix();
+
+            const unsigned int baseVertex = vertices.size() / stride;
+            const float* source = geometry.GetBufferDataPtr();
+            const unsigned int vertexCount = geometry.GetBufferDataSize() / stride;
+            // Only positions are moved; the normals stay in the space
+            // vert.glsl expects (see StaticBatch.hpp)
+            for(unsigned int v=0; v < vertexCount; ++v){
+                const float* in = source + v*stride;
+                glm::vec3 position = glm::vec3(relative * glm::vec4(in[0], in[1], in[2], 1.0f));
+                vertices.insert(vertices.end(), in, in + stride);
+                float* out = &vertices[vertices.size() - stride];
+                out[0] = position.x;
+                out[1] = position.y;
+                out[2] = position.z;
+            }
+
+            // The node's own range, culled by its bounding sphere only
+            Bounds bounds = mesh->GetBounds().Transformed(relative);
+            Meshlet meshlet;
+            meshlet.center[0] = bounds.center.x;
+            meshlet.center[1] = bounds.center.y;
+            meshlet.center[2] = bounds.center.z;
+            meshlet.radius = bounds.radius;
+            meshlet.coneAxis[0] = 0.0f;
+            meshlet.coneAxis[1] = 0.0f;
+            meshlet.coneAxis[2] = 1.0f;
+            meshlet.coneCutoff = 1.0f;
+            meshlet.indexOffset = indices.size();
+            meshlet.indexCount = geometry.GetIndicesSize();
+            meshlets.push_back(meshlet);
+
+            const unsigned int* sourceIndices = geometry.GetIndicesDataPtr();
+            for(unsigned int i=0; i < geometry.GetIndicesSize(); ++i){
+                indices.push_back(baseVertex + sourceIndices[i]);
+            }
+        }
+
+        std::shared_ptr<Mesh> batchMesh = std::make_shared<Mesh>();
+        batchMesh->Upload(vertices, indices, meshlets);
+        std::shared_ptr<Object> batchObject = std::make_shared<Object>();
+        batchObject->SetMesh(batchMesh);
+        batchObject->LoadTexture(group.first.second);
+
+        // Destroyed with 'root'
+        SceneNodePool::Handle batchHandle = SceneNodePool::Instance().Create(batchObject, vertShader, fragShader);
+        SceneNode* batchNode = SceneNodePool::Instance().Get(batchHandle);
+        if(batchNode == nullptr){
+            continue;
+        }
+        batchNode->m_shader = members[0]->m_shader;
+        batchNode->m_static = true;
+        root->AddChild(batchHandle);
+        for(SceneNode* node : members){
+            node->m_batched = true;
+            node->m_batch = batchHandle;
+            node->m_batchedTransform = rootInverse * node->GetWorldTransform().GetInternalMatrix();
+        }
+
+        stats.nodes += members.size();
+        ++stats.batches;
+        stats.vertices += vertices.size() / stride;
+        stats.indices += indices.size();
+    }
+    return stats;
+}
+
+void StaticBatch::PrintStats(const Stats& stats){
+    std::printf("(StaticBatch.cpp) Merged %u static nodes into %u batches (%u vertices, %u indices)\n",
+                stats.nodes, stats.batches, stats.vertices, stats.indices);
+}
@@ -0,0 +1,220 @@
+#include "StreamBuffer.hpp"
+#include "GLState.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+// glad is generated for GL 3.3, which has none of the buffer storage
+// names, so they are declared here.
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#endif
+#ifndef GL_MAP_COHERENT_BIT
+#define GL_MAP_COHERENT_BIT 0x0080
+#endif
+typedef void (APIENTRYP PFNBUFFERSTORAGEPROC)(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags);
+
+namespace{
+    // Loaded by StreamBuffer::LoadFunctions (null if unsupported)
+    PFNBUFFERSTORAGEPROC s_bufferStorage = nullptr;
+
+    // All buffer work goes through this target. Unlike
+    // GL_ELEMENT_ARRAY_BUFFER it is not part of any vertex array state.
+    const GLenum kTarget = GL_COPY_WRITE_BUFFER;
+
+    // Every region starts on this boundary, which is at least the
+    // uniform buffer offset alignment of any GL implementation.
+    const unsigned int kRegionAlignment = 256;
+
+    unsigned int AlignUp(unsigned int value, unsigned int alignment){
+        return alignment > 1 ? (value + alignment - 1) / alignment * alignment : value;
+    }
+
+    const char* GetModeName(StreamBuffer::Mode mode){
+        switch(mode){
+            case StreamBuffer::Mode::Persistent: return "persistent";
+            case StreamBuffer::Mode::Unsynchronized: return "unsynchronized";
+            case StreamBuffer::Mode::Orphan: return "orphan";
+        }
+        return "";
+    }
+}
+
+// glBufferStorage is core in 4.4. On older contexts the extension
+// provides the same function.
+void StreamBuffer::LoadFunctions(GLADloadproc load){
+    bool supported = GLVersion.major > 4 || (GLVersion.major == 4 && GLVersion.minor >= 4);
+    if(!supported){
+        GLint count = 0;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+        for(GLint i=0; i < count && !supported; ++i){
+            const char* name = (const char*)glGetStringi(GL_EXTENSIONS, i);
+            supported = name != nullptr && std::strcmp(name, "GL_ARB_buffer_storage") == 0;
+        }
+    }
+    s_bufferStorage = supported ? (PFNBUFFERSTORAGEPROC)load("glBufferStorage") : nullptr;
+}
+
+bool StreamBuffer::HasBufferStorage(){
+    return s_bufferStorage != nullptr;
+}
+
+// Constructor
+StreamBuffer::StreamBuffer(){
+}
+
+// Destructor
+StreamBuffer::~StreamBuffer(){
+    Release();
+}
+
+void StreamBuffer::Release(){
+    for(unsigned int i=0; i < kRegionCount; ++i){
+        if(m_fences[i] != nullptr){
+            glDeleteSync(m_fences[i]);
+            m_fences[i] = nullptr;
+        }
+    }
+    if(m_buffer.IsValid() && (m_persistent != nullptr || m_mapped)){
+        GLState::BindBuffer(kTarget, m_buffer.Get());
+        glUnmapBuffer(kTarget);
+    }
+    m_buffer.Release();
+    m_persistent = nullptr;
+    m_mapped = false;
+}
+
+void StreamBuffer::Create(unsigned int regionSize, bool allowPersistent, Mode fallback){
+    Release();
+    m_regionSize = AlignUp(regionSize, kRegionAlignment);
+    m_region = kRegionCount - 1;
+    m_used = 0;
+    m_stats = Stats();
+    GLint uniformAlignment = 0;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uniformAlignment);
+    m_uniformAlignment = uniformAlignment > 0 ? uniformAlignment : kRegionAlignment;
+    const GLsizeiptr totalSize = (GLsizeiptr)m_regionSize * kRegionCount;
+
+    m_mode = allowPersistent && HasBufferStorage() ? Mode::Persistent
+                                                    : (fallback == Mode::Persistent ? Mode::Unsynchronized : fallback);
+    m_buffer.Create(GpuResourceType::Buffer, GetModeName(m_mode), "StreamBuffer");
+    GLState::BindBuffer(kTarget, m_buffer.Get());
+    if(m_mode == Mode::Persistent){
+        const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        s_bufferStorage(kTarget, totalSize, nullptr, flags);
+        m_persistent = static_cast<unsigned char*>(glMapBufferRange(kTarget, 0, totalSize, flags));
+        if(m_persistent == nullptr){
+            // Should not happen, but the other modes work everywhere
+            std::printf("(StreamBuffer.cpp) Persistent mapping failed, using unsynchronized maps\n");
+            m_mode = Mode::Unsynchronized;
+            m_buffer.Create(GpuResourceType::Buffer, GetModeName(m_mode), "StreamBuffer");
+            GLState::BindBuffer(kTarget, m_buffer.Get());
+        }
+    }
+    if(m_mode != Mode::Persistent){
+        glBufferData(kTarget, totalSize, nullptr, GL_STREAM_DRAW);
+    }
+    m_buffer.SetBytes(totalSize);
+}
+
+// Fences are only needed when we write without the driver's help
+void StreamBuffer::BeginFrame(){
+    m_region = (m_region + 1) % kRegionCount;
+    m_used = 0;
+    ++m_stats.frames;
+
+    if(m_mode == Mode::Orphan){
+        // Starting over at the front: give the old storage to the driver
+        if(m_region == 0){
+            GLState::BindBuffer(kTarget, m_buffer.Get());
+            glBufferData(kTarget, (GLsizeiptr)m_regionSize * kRegionCount, nullptr, GL_STREAM_DRAW);
+        }
+        return;
+    }
+
+    GLsync fence = m_fences[m_region];
+    if(fence == nullptr){
+        return;
+    }
+    // Polling with a timeout of 0 never blocks
+    GLenum result = glClientWaitSync(fence, 0, 0);
+    if(result == GL_TIMEOUT_EXPIRED){
+        auto start = std::chrono::high_resolution_clock::now();
+        do{
+            // Make sure the fence is submitted, then wait 1ms at a time
+            result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+        }while(result == GL_TIMEOUT_EXPIRED);
+        double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+        ++m_stats.stalls;
+        m_stats.stallMilliseconds += milliseconds;
+        m_stats.longestStallMilliseconds = milliseconds > m_stats.longestStallMilliseconds ? milliseconds : m_stats.longestStallMilliseconds;
+    }
+    glDeleteSync(fence);
+    m_fences[m_region] = nullptr;
+}
+
+void StreamBuffer::EndFrame(){
+    Unmap();
+    m_stats.peakBytes = m_used > m_stats.peakBytes ? m_used : m_stats.peakBytes;
+    if(m_mode != Mode::Orphan){
+        m_fences[m_region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+}
+
+void* StreamBuffer::Map(unsigned int size, unsigned int alignment, GLintptr& offset){
+    Unmap();
+    const unsigned int regionStart = m_region * m_regionSize;
+    const unsigned int start = AlignUp(regionStart + m_used, alignment);
+    if(!m_buffer.IsValid() || size == 0 || start + size > regionStart + m_regionSize){
+        ++m_stats.overflows;
+        return nullptr;
+    }
+    m_used = start + size - regionStart;
+    offset = start;
+    if(m_mode == Mode::Persistent){
+        return m_persistent + start;
+    }
+    // The fences (or the orphaning) already make sure the GPU is not
+    // reading this range, so the driver must not synchronize again
+    GLState::BindBuffer(kTarget, m_buffer.Get());
+    void* pointer = glMapBufferRange(kTarget, start, size,
+                                     GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+    m_mapped = pointer != nullptr;
+    return pointer;
+}
+
+void* StreamBuffer::MapUniforms(unsigned int size, GLintptr& offset){
+    return Map(size, m_uniformAlignment, offset);
+}
+
+unsigned int StreamBuffer::GetUniformAlignment() const{
+    return m_uniformAlignment;
+}
+
+void StreamBuffer::Unmap(){
+    if(m_mapped){
+        GLState::BindBuffer(kTarget, m_buffer.Get());
+        glUnmapBuffer(kTarget);
+        m_mapped = false;
+    }
+}
+
+GLuint StreamBuffer::GetBuffer() const{
+    return m_buffer.Get();
+}
+
+StreamBuffer::Mode StreamBuffer::GetMode() const{
+    return m_mode;
+}
+
+const StreamBuffer::Stats& StreamBuffer::GetStats() const{
+    return m_stats;
+}
+
+void StreamBuffer::PrintStats(const char* name) const{
+    std::printf("(StreamBuffer.cpp) %s: %s mode, %u x %u bytes, %u frames, peak %u bytes/frame\n",
+                name, GetModeName(m_mode), kRegionCount, m_regionSize, m_stats.frames, m_stats.peakBytes);
+    std::printf("    stalls %u (%.2f ms total, longest %.2f ms), overflows %u\n",
+                m_stats.stalls, m_stats.stallMilliseconds, m_stats.longestStallMilliseconds, m_stats.overflows);
+}
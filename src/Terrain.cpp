@@ -1,14 +1,64 @@
 #include "Terrain.hpp"
 #include "Image.hpp"
 
+#include "MeshFile.hpp"
+#include "Hash.hpp"
+
 #include <iostream>
+#include <filesystem>
 
 // Constructor for our object
 // Calls the initialization method
 Terrain::Terrain(unsigned int xSegs, unsigned int zSegs, std::string fileName) : 
-                m_xSegments(xSegs), m_zSegments(zSegs) {
+                m_xSegments(xSegs), m_zSegments(zSegs), m_heightData(nullptr) {
     std::cout << "(Terrain.cpp) Constructor called \n";
 
+    // If this terrain has been built before, a cooked copy of the
+    // finished mesh sits next to the heightmap and we are done.
+    std::string cookedPath = fileName + ".mesh";
+    uint64_t sourceKey = GetSourceKey(fileName);
+    if(LoadCooked(cookedPath, sourceKey)){
+        std::cout << "(Terrain.cpp) Loaded cooked mesh " << cookedPath << "\n";
+        return;
+    }
+
+    // Create height data
+    m_heightData = new int[m_xSegments*m_zSegments];
+    LoadHeights(fileName, m_xSegments, m_zSegments, m_heightData);
+
+    // Initialize the terrain
+    Init();
+
+    // Save the finished mesh so the next run can skip all of the above
+    if(MeshFile::Cook(m_mesh->GetGeometry(), cookedPath, sourceKey)){
+        std::cout << "(Terrain.cpp) Cooked mesh written to " << cookedPath << "\n";
+    }
+}
+
+// Destructor
+Terrain::~Terrain(){
+    // Delete our allocatted higheithmap data
+    if(m_heightData!=nullptr){
+        delete[] m_heightData;
+    }
+}
+
+
+// Builds the terrain mesh from the height data and uploads it
+void Terrain::Init(){
+    // Every terrain has its own mesh
+    m_mesh = std::make_shared<Mesh>();
+    BuildGeometry(m_mesh->GetGeometry(), m_heightData, m_xSegments, m_zSegments);
+
+   // Finally generate a simple 'array of bytes' that contains
+   // everything for our buffer to work with, and create our buffers.
+   m_mesh->Upload();
+}
+
+// Reads the heightmap into 'heightData'.
+// Kept separate from the constructor so tools (see Benchmark) can
+// build a terrain without an OpenGL context.
+void Terrain::LoadHeights(const std::string& fileName, unsigned int xSegs, unsigned int zSegs, int* heightData){
     // Load up some image data
     Image heightMap(fileName);
     heightMap.LoadPPM(true);
@@ -18,46 +68,32 @@ Terrain::Terrain(unsigned int xSegs, unsigned int zSegs, std::string fileName) :
     // than pixels. 
     float scale = 5.0f; // Note that this scales down the values to make
                         // the image a bit more flat.
-    // Create height data
-    m_heightData = new int[m_xSegments*m_zSegments];
     // Set the height data equal to the grayscale value of the heightmap
     // Because the R,G,B will all be equal in a grayscale iamge, then
     // we just grab one of the color components.
 
     // TODO: (Inclass) Implement populate heightData!
-    for(unsigned int z=0; z < m_zSegments; ++z){
-        for(unsigned int x=0; x < m_xSegments; ++x){
-            m_heightData[x+z*m_xSegments] = (float)heightMap.GetPixelR(z,x)/scale;
+    for(unsigned int z=0; z < zSegs; ++z){
+        for(unsigned int x=0; x < xSegs; ++x){
+            heightData[x+z*xSegs] = (float)heightMap.GetPixelR(z,x)/scale;
         }
     }
-
-    // Initialize the terrain
-    Init();
 }
 
-// Destructor
-Terrain::~Terrain(){
-    // Delete our allocatted higheithmap data
-    if(m_heightData!=nullptr){
-        delete m_heightData;
-    }
-}
-
-
 // Creates a grid of segments
 // This article has a pretty handy illustration here:
 // http://www.learnopengles.com/wordpress/wp-content/uploads/2012/05/vbo.png
 // of what we are trying to do.
-void Terrain::Init(){
+void Terrain::BuildGeometry(Geometry& geometry, const int* heightData, unsigned int xSegs, unsigned int zSegs){
     // Create the initial grid of vertices.
 
     // TODO: (Inclass) Build grid of vertices! 
-    for(unsigned int z=0; z < m_zSegments; ++z){
-        for(unsigned int x =0; x < m_xSegments; ++x){
-            float u = 1.0f - ((float)x/(float)m_xSegments);
-            float v = 1.0f - ((float)z/(float)m_zSegments);
+    for(unsigned int z=0; z < zSegs; ++z){
+        for(unsigned int x =0; x < xSegs; ++x){
+            float u = 1.0f - ((float)x/(float)xSegs);
+            float v = 1.0f - ((float)z/(float)zSegs);
             // Calculate the correct position and add the texture coordinates
-            m_geometry.AddVertex(x,m_heightData[x+z*m_xSegments],z,u,v);
+            geometry.AddVertex(x,heightData[x+z*xSegs],z,u,v);
         }
     }
     
@@ -66,38 +102,70 @@ void Terrain::Init(){
     // the pattern here. Note there is an offset.
     
     // TODO: (Inclass) Build triangle strip
-    for(unsigned int z=0; z < m_zSegments-1; ++z){
-        for(unsigned int x =0; x < m_xSegments-1; ++x){
-            m_geometry.AddIndex(x+(z*m_zSegments));
-            m_geometry.AddIndex(x+(z*m_zSegments)+m_xSegments);
-            m_geometry.AddIndex(x+(z*m_zSegments+1));
-
-            m_geometry.AddIndex(x+(z*m_zSegments)+1);
-            m_geometry.AddIndex(x+(z*m_zSegments)+m_xSegments);
-            m_geometry.AddIndex(x+(z*m_zSegments)+m_xSegments+1);
+    for(unsigned int z=0; z < zSegs-1; ++z){
+        for(unsigned int x =0; x < xSegs-1; ++x){
+            geometry.AddIndex(x+(z*zSegs));
+            geometry.AddIndex(x+(z*zSegs)+xSegs);
+            geometry.AddIndex(x+(z*zSegs+1));
+
+            geometry.AddIndex(x+(z*zSegs)+1);
+            geometry.AddIndex(x+(z*zSegs)+xSegs);
+            geometry.AddIndex(x+(z*zSegs)+xSegs+1);
         }
     }
 
-
-   // Finally generate a simple 'array of bytes' that contains
-   // everything for our buffer to work with.
-   m_geometry.Gen();  
-   // Create a buffer and set the stride of information
-   m_vertexBufferLayout.CreateNormalBufferLayout(m_geometry.GetBufferDataSize(),
-                                        m_geometry.GetIndicesSize(),
-                                        m_geometry.GetBufferDataPtr(),
-                                        m_geometry.GetIndicesDataPtr());
+   // Split the terrain into meshlets so that the parts behind or
+   // outside of the camera can be skipped when drawing.
+   // This reorders the indices, so it must happen before the upload.
+   geometry.BuildMeshlets();
 }
 
+// A cooked terrain is only valid for the heightmap and segment counts
+// it was built from, so all of them go into the key. The heightmap's
+// size and modification time are used to notice when it is edited.
+uint64_t Terrain::GetSourceKey(const std::string& fileName) const{
+    uint64_t key = HashString(fileName);
+    key = HashBytes(&m_xSegments, sizeof(m_xSegments), key);
+    key = HashBytes(&m_zSegments, sizeof(m_zSegments), key);
+
+    std::error_code error;
+    uint64_t fileSize = std::filesystem::file_size(fileName, error);
+    if(!error){
+        key = HashBytes(&fileSize, sizeof(fileSize), key);
+    }
+    auto writeTime = std::filesystem::last_write_time(fileName, error);
+    if(!error){
+        int64_t ticks = writeTime.time_since_epoch().count();
+        key = HashBytes(&ticks, sizeof(ticks), key);
+    }
+    return key;
+}
 
+// Maps a cooked terrain and hands the data straight to OpenGL.
+// Nothing is parsed or copied on the CPU, and the mapping is released
+// as soon as the buffers have been created.
+bool Terrain::LoadCooked(const std::string& cookedPath, uint64_t sourceKey){
+    MeshFile cooked;
+    if(!cooked.Load(cookedPath, sourceKey)){
+        return false;
+    }
+    m_mesh = std::make_shared<Mesh>();
+    m_mesh->Upload(cooked);
+    return true;
+}
 
 // Loads an image and uses it to set the heights of the terrain.
 void Terrain::LoadHeightMap(Image image){
 
 }
 
-void Terrain::LoadTextures(std::string colormap, std::string detailmap){ 
+void Terrain::LoadTextures(std::string colormap, std::string detailmap, bool sampleDetailMap){ 
         // Load our actual textures
         m_textureDiffuse.LoadTexture(colormap); // Found in object
         m_detailMap.LoadTexture(detailmap);     // Found in object
+        // Only sampled when asked for: it costs a second texture fetch,
+        // and only looks right for a detail map centered on grey
+        m_shaderFeatures.detailMap = sampleDetailMap;
+        // Grass is not shiny
+        m_shaderFeatures.specular = false;
 }
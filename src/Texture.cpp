@@ -6,6 +6,7 @@
 
 
 #include "Texture.hpp"
+#include "GLState.hpp"
 
 #include <stdio.h>
 #include <string.h>
@@ -14,6 +15,13 @@
 #include <iostream>
 #include <glad/glad.h>
 #include <memory>
+#include <unordered_map>
+
+namespace{
+    // Textures loaded so far, by file. Only weak references, so a
+    // texture is freed with the last Texture using it.
+    std::unordered_map<std::string, std::weak_ptr<GpuResource>> s_loaded;
+}
 
 // Default Constructor
 Texture::Texture(){
@@ -23,8 +31,7 @@ Texture::Texture(){
 
 // Default Destructor
 Texture::~Texture(){
-	// Delete our texture from the GPU
-	glDeleteTextures(1,&m_textureID);
+	// m_texture deletes our texture from the GPU
 
     // Delete our image
     if(m_image != nullptr){
@@ -36,18 +43,24 @@ Texture::~Texture(){
 void Texture::LoadTexture(const std::string filepath){
 	// Set member variable
     m_filepath = filepath;
+    // Someone already loaded this file
+    m_texture = s_loaded[filepath].lock();
+    if(m_texture != nullptr){
+        return;
+    }
+    m_texture = std::make_shared<GpuResource>();
+    s_loaded[filepath] = m_texture;
     // Load our actual image data
     // This method loads .ppm files of pixel data
     m_image = new Image(filepath);
     m_image->LoadPPM(true);
 
-    glEnable(GL_TEXTURE_2D); 
 	// Generate a buffer for our texture
-    glGenTextures(1,&m_textureID);
+    m_texture->Create(GpuResourceType::Texture, filepath, "Texture");
     // Similar to our vertex buffers, we now 'select'
     // a texture we want to bind to.
     // Note the type of data is 'GL_TEXTURE_2D'
-    glBindTexture(GL_TEXTURE_2D, m_textureID);
+    GLState::BindTexture(0, GL_TEXTURE_2D, m_texture->Get());
 	// Now we are going to setup some information about
 	// our textures.
 	// There are four parameters that must be set.
@@ -71,8 +84,9 @@ void Texture::LoadTexture(const std::string filepath){
     // We are done with our texture data so we can unbind.
     // Generate a mipmap
     glGenerateMipmap(GL_TEXTURE_2D);                        
+    m_texture->SetBytes(GpuResources::GetImageBytes(GL_RGB, m_image->GetWidth(), m_image->GetHeight(), true));
 	// We are done with our texture data so we can unbind.    
-	glBindTexture(GL_TEXTURE_2D, 0);
+	GLState::BindTexture(0, GL_TEXTURE_2D, 0);
 }
 
 
@@ -85,13 +99,21 @@ void Texture::Bind(unsigned int slot) const{
 	// be multiple at once.
 	// At the time of writing, OpenGL supports 8-32 depending
 	// on your hardware.
-    glEnable(GL_TEXTURE_2D);
-	glActiveTexture(GL_TEXTURE0+slot);
-	glBindTexture(GL_TEXTURE_2D, m_textureID);
+	// (glEnable(GL_TEXTURE_2D) is not needed, and is an error in the core
+	// profile. Nothing is called if the texture is already in place.)
+	GLState::BindTexture(slot, GL_TEXTURE_2D, GetId());
 }
 
 void Texture::Unbind(){
-	glBindTexture(GL_TEXTURE_2D, 0);
+	GLState::BindTexture(0, GL_TEXTURE_2D, 0);
+}
+
+GLuint Texture::GetId() const{
+    return m_texture != nullptr ? m_texture->Get() : 0;
+}
+
+const std::string& Texture::GetFilePath() const{
+    return m_filepath;
 }
 
 
@@ -0,0 +1,234 @@
+#include "TransformHierarchy.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define TRANSFORMHIERARCHY_SSE 1
+#endif
+
+namespace{
+    // out = a * b for column major 4x4 matrices. Every column of the
+    // result is a sum of the columns of 'a', weighted by a column of 'b'.
+    // All three must be 16 byte aligned (Transform is).
+    void MultiplyMatrices(const float* a, const float* b, float* out){
+#ifdef TRANSFORMHIERARCHY_SSE
+        const __m128 a0 = _mm_load_ps(a);
+        const __m128 a1 = _mm_load_ps(a + 4);
+        const __m128 a2 = _mm_load_ps(a + 8);
+        const __m128 a3 = _mm_load_ps(a + 12);
+        for(int column=0; column < 4; ++column){
+            const float* bc = b + column*4;
+            __m128 result = _mm_mul_ps(a0, _mm_set1_ps(bc[0]));
+            result = _mm_add_ps(result, _mm_mul_ps(a1, _mm_set1_ps(bc[1])));
+            result = _mm_add_ps(result, _mm_mul_ps(a2, _mm_set1_ps(bc[2])));
+            result = _mm_add_ps(result, _mm_mul_ps(a3, _mm_set1_ps(bc[3])));
+            _mm_store_ps(out + column*4, result);
+        }
+#else
+        for(int column=0; column < 4; ++column){
+            const float* bc = b + column*4;
+            for(int row=0; row < 4; ++row){
+                out[column*4 + row] = a[row]*bc[0] + a[4 + row]*bc[1] + a[8 + row]*bc[2] + a[12 + row]*bc[3];
+            }
+        }
+#endif
+    }
+}
+
+TransformHierarchy& TransformHierarchy::Instance(){
+    static TransformHierarchy* instance = new TransformHierarchy();
+    return *instance;
+}
+
+// New nodes go at the end, which is always a valid place for a root
+TransformHierarchy::Handle TransformHierarchy::Create(){
+    Handle handle;
+    if(!m_freeHandles.empty()){
+        handle = m_freeHandles.back();
+        m_freeHandles.pop_back();
+    }else{
+        handle = m_slots.size();
+        m_slots.push_back(0);
+    }
+    uint32_t slot = m_parents.size();
+    m_slots[handle] = slot;
+    m_parents.push_back(kNoParent);
+    m_locals.emplace_back();
+    m_worlds.emplace_back();
+    m_localVersions.push_back(m_locals.back().GetVersion());
+    m_dirty.push_back(1);
+    m_changed.push_back(0);
+    m_alive.push_back(1);
+    m_handles.push_back(handle);
+    MarkDirty(slot);
+    ++m_count;
+    return handle;
+}
+
+// The slot is dropped (and the children made roots) by the next Sort
+void TransformHierarchy::Destroy(Handle node){
+    if(node >= m_slots.size() || m_slots[node] == kNoParent){
+        std::cout << "(TransformHierarchy.cpp) ERROR, destroying a node that does not exist\n";
+        return;
+    }
+    m_alive[m_slots[node]] = 0;
+    m_slots[node] = kNoParent;
+    m_freeHandles.push_back(node);
+    m_needsSort = true;
+    --m_count;
+}
+
+void TransformHierarchy::SetParent(Handle node, Handle parent){
+    uint32_t slot = m_slots[node];
+    uint32_t parentSlot = parent != kInvalidHandle ? m_slots[parent] : kNoParent;
+    // Walk up from the new parent; finding the node means a cycle
+    for(uint32_t ancestor = parentSlot; ancestor != kNoParent; ancestor = m_parents[ancestor]){
+        if(ancestor == slot){
+            std::cout << "(TransformHierarchy.cpp) ERROR, a node cannot be its own ancestor\n";
+            return;
+        }
+    }
+    m_parents[slot] = parentSlot;
+    m_dirty[slot] = 1;
+    MarkDirty(slot);
+    if(parentSlot != kNoParent && parentSlot > slot){
+        m_needsSort = true;
+    }
+}
+
+Transform& TransformHierarchy::GetLocal(Handle node){
+    uint32_t slot = m_slots[node];
+    MarkDirty(slot);
+    return m_locals[slot];
+}
+
+const Transform& TransformHierarchy::GetWorld(Handle node) const{
+    return m_worlds[m_slots[node]];
+}
+
+// Parents come first, so by the time we get to a slot its parent's
+// world transform is final. A slot changes if its local transform was
+// modified, or its parent changed earlier in this same pass.
+void TransformHierarchy::Update(){
+    if(m_needsSort){
+        Sort();
+    }
+    const uint32_t count = m_parents.size();
+    const uint32_t first = m_firstDirty;
+    unsigned int recomputed = 0;
+    for(uint32_t i = first; i < count; ++i){
+        const uint32_t parent = m_parents[i];
+        const bool parentChanged = parent != kNoParent && parent >= first && m_changed[parent];
+        const bool changed = m_alive[i] && (parentChanged || m_dirty[i] || m_locals[i].GetVersion() != m_localVersions[i]);
+        m_changed[i] = changed;
+        if(!changed){
+            continue;
+        }
+        const float* local = &m_locals[i].GetInternalMatrix()[0][0];
+        if(parent == kNoParent){
+            std::memcpy(m_worlds[i].GetTransformMatrix(), local, sizeof(float)*16);
+        }else{
+            MultiplyMatrices(&m_worlds[parent].GetInternalMatrix()[0][0], local, m_worlds[i].GetTransformMatrix());
+        }
+        m_localVersions[i] = m_locals[i].GetVersion();
+        m_dirty[i] = 0;
+        ++recomputed;
+    }
+    m_firstDirty = count;
+    m_lastUpdateCount = recomputed;
+}
+
+unsigned int TransformHierarchy::GetCount() const{
+    return m_count;
+}
+
+unsigned int TransformHierarchy::GetLastUpdateCount() const{
+    return m_lastUpdateCount;
+}
+
+// Slots are ordered by their depth in the tree, which puts every parent
+// before its children. Nodes at the same depth keep their order.
+void TransformHierarchy::Sort(){
+    const uint32_t count = m_parents.size();
+    // Children of destroyed nodes become roots
+    for(uint32_t i=0; i < count; ++i){
+        if(m_parents[i] != kNoParent && !m_alive[m_parents[i]]){
+            m_parents[i] = kNoParent;
+        }
+    }
+
+    // Depth of every slot, filling in the chain above it as we go
+    const uint32_t kUnknown = 0xffffffff;
+    std::vector<uint32_t> depths(count, kUnknown);
+    std::vector<uint32_t> chain;
+    uint32_t maxDepth = 0;
+    for(uint32_t i=0; i < count; ++i){
+        uint32_t slot = i;
+        while(slot != kNoParent && depths[slot] == kUnknown){
+            chain.push_back(slot);
+            slot = m_parents[slot];
+        }
+        uint32_t depth = slot == kNoParent ? 0 : depths[slot] + 1;
+        while(!chain.empty()){
+            depths[chain.back()] = depth++;
+            chain.pop_back();
+        }
+        maxDepth = std::max(maxDepth, depths[i]);
+    }
+
+    // Counting sort by depth (stable), skipping destroyed slots
+    std::vector<uint32_t> starts(maxDepth + 2, 0);
+    for(uint32_t i=0; i < count; ++i){
+        if(m_alive[i]){
+            ++starts[depths[i] + 1];
+        }
+    }
+    for(uint32_t d=1; d < starts.size(); ++d){
+        starts[d] += starts[d-1];
+    }
+    const uint32_t aliveCount = starts.back();
+    std::vector<uint32_t> newSlots(count, kNoParent);
+    std::vector<uint32_t> order(aliveCount);
+    for(uint32_t i=0; i < count; ++i){
+        if(m_alive[i]){
+            newSlots[i] = starts[depths[i]]++;
+            order[newSlots[i]] = i;
+        }
+    }
+
+    // Transforms are copy constructed so they keep their versions
+    std::vector<uint32_t> parents(aliveCount);
+    std::vector<Transform> locals;
+    std::vector<Transform> worlds;
+    locals.reserve(aliveCount);
+    worlds.reserve(aliveCount);
+    std::vector<uint32_t> localVersions(aliveCount);
+    std::vector<Handle> handles(aliveCount);
+    for(uint32_t slot=0; slot < aliveCount; ++slot){
+        uint32_t old = order[slot];
+        parents[slot] = m_parents[old] != kNoParent ? newSlots[m_parents[old]] : kNoParent;
+        locals.push_back(m_locals[old]);
+        worlds.push_back(m_worlds[old]);
+        localVersions[slot] = m_localVersions[old];
+        handles[slot] = m_handles[old];
+        m_slots[handles[slot]] = slot;
+    }
+    m_parents.swap(parents);
+    m_locals.swap(locals);
+    m_worlds.swap(worlds);
+    m_localVersions.swap(localVersions);
+    m_handles.swap(handles);
+    // Everything moved, so everything is recomputed once
+    m_dirty.assign(aliveCount, 1);
+    m_changed.assign(aliveCount, 0);
+    m_alive.assign(aliveCount, 1);
+    m_firstDirty = 0;
+    m_needsSort = false;
+}
+
+void TransformHierarchy::MarkDirty(uint32_t slot){
+    m_firstDirty = std::min(m_firstDirty, slot);
+}
@@ -1,70 +1,62 @@
 #include "VertexBufferLayout.hpp"
+#include "GLState.hpp"
 #include <iostream>
 
 
 VertexBufferLayout::VertexBufferLayout(){
 }
 
+// The vertex array and buffers are GpuResources, which delete themselves
 VertexBufferLayout::~VertexBufferLayout(){
-    // Delete our buffers that we have previously allocated
-    // http://docs.gl/gl3/glDeleteBuffers
-    glDeleteBuffers(1,&m_vertexPositionBuffer);
-    glDeleteBuffers(1,&m_indexBufferObject);
 }
 
 
 void VertexBufferLayout::Bind(){
     // Bind to our vertex array
-    glBindVertexArray(m_VAOId);
+    GLState::BindVertexArray(m_vertexArray.Get());
     // Bind to our vertex information
-    glBindBuffer(GL_ARRAY_BUFFER, m_vertexPositionBuffer);
+    GLState::BindBuffer(GL_ARRAY_BUFFER, m_vertexPositionBuffer.Get());
     // Bind to the elements we are drawing
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexBufferObject);
+    GLState::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexBufferObject.Get());
 }
 
 // Note: Calling Unbind is rarely done, if you need
 // to draw something else then just bind to new buffer.
 void VertexBufferLayout::Unbind(){
         // Bind to our vertex array
-        glBindVertexArray(0);
+        GLState::BindVertexArray(0);
         // Bind to our vertex information
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        GLState::BindBuffer(GL_ARRAY_BUFFER, 0);
         // Bind to the elements we are drawing
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+        GLState::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 }
 
 
-void VertexBufferLayout::CreatePositionBufferLayout(unsigned int vcount,unsigned int icount, float* vdata, unsigned int* idata ){
-        // Because this layout is only
-        m_stride = 3;
-        
+// Number of floats per vertex in each format
+unsigned int VertexBufferLayout::GetStride(VertexFormat format){
+    switch(format){
+        case VertexFormat::Position: return 3;
+        case VertexFormat::Texture:  return 5;
+        case VertexFormat::Normal:   return 14;
+    }
+    return 0;
+}
+
+// Describes 'format' to the currently bound vertex array, reading from
+// the buffer currently bound to GL_ARRAY_BUFFER.
+void VertexBufferLayout::SetAttributes(VertexFormat format){
         static_assert(sizeof(GLfloat)==sizeof(float),
             "GLFloat and gloat are not the same size on this architecture");
-       
-        // VertexArrays
-        glGenVertexArrays(1, &m_VAOId);
-
-        glBindVertexArray(m_VAOId);
-
-        // Vertex Buffer Object (VBO)
-        // Create a buffer (note we’ll see this pattern of code often in OpenGL)
-        // TODO: Read this and understand what is going on
-        glGenBuffers(1, &m_vertexPositionBuffer); // selecting the buffer is
-                                                // done by binding in OpenGL
-                                                // We tell OpenGL then how we want to 
-                                                // use our selected(or binded)
-                                                //  buffer with the arguments passed 
-                                                // into the function.
-        glBindBuffer(GL_ARRAY_BUFFER, m_vertexPositionBuffer);
-        glBufferData(GL_ARRAY_BUFFER, vcount*sizeof(float), vdata, GL_STATIC_DRAW);
+        const unsigned int stride = GetStride(format);
 
+        // Every format starts with a position
         glEnableVertexAttribArray(0);
         // Finally pass in our vertex data
         glVertexAttribPointer(  0,   // Attribute 0, which will match layout in shader
                                 3,   // size (Number of components (2=x,y)  (3=x,y,z), etc.)
                                 GL_FLOAT, // Type of data
                                 GL_FALSE, // Is the data normalized
-                                sizeof(float)*m_stride, // Stride - Amount of bytes between each vertex.
+                                sizeof(float)*stride, // Stride - Amount of bytes between each vertex.
                                                 // If we only have vertex data, then
                                                 // this is sizeof(float)*3 (or as a
                                                 // shortcut 0).
@@ -90,92 +82,79 @@ void VertexBufferLayout::CreatePositionBufferLayout(unsigned int vcount,unsigned
                                                 // 3*sizeof(GL_FLOAT) for example
         );
 
-        // Another Vertex Buffer Object (VBO)
-        // This time for your index buffer.
-        // TODO: put these static_asserts somewhere
-        static_assert(sizeof(unsigned int)==sizeof(GLuint),"Gluint not same size!");
-
-        glGenBuffers(1, &m_indexBufferObject);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexBufferObject);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, icount*sizeof(unsigned int), idata,GL_STATIC_DRAW);
-    }
+        if(format == VertexFormat::Texture){
+            // Adding a new glVertexAttrib here. Make sure to enable it first
+            // - Make sure you use a new attribute(i.e. 0 is already used for position data!)
+            // - Make sure the correct offset is set (i.e. the starting point of the color data)
+
+            // Add two floats for texture coordinates
+            glEnableVertexAttribArray(1);
+            glVertexAttribPointer(1,2,GL_FLOAT, GL_TRUE,sizeof(float)*stride,(char*)(sizeof(float)*3));
+        }
+
+        if(format == VertexFormat::Normal){
+            // Add three floats for normal coordinates
+            glEnableVertexAttribArray(1);
+            glVertexAttribPointer(1,3,GL_FLOAT, GL_FALSE,sizeof(float)*stride,(char*)(sizeof(float)*3));
+
+            // Add two floats for texture coordinates
+            glEnableVertexAttribArray(2);
+            glVertexAttribPointer(2,2,GL_FLOAT, GL_FALSE,sizeof(float)*stride,(char*)(sizeof(float)*6));
+
+            // Add three floats for tangent coordinates
+            glEnableVertexAttribArray(3);
+            glVertexAttribPointer(3,3,GL_FLOAT, GL_FALSE,sizeof(float)*stride,(char*)(sizeof(float)*8));
+
+            // Add three floats for bi-tangent coordinates
+            glEnableVertexAttribArray(4);
+            glVertexAttribPointer(4,3,GL_FLOAT, GL_FALSE,sizeof(float)*stride,(char*)(sizeof(float)*11));
+        }
+}
 
+// Creates the vertex array, vertex buffer and index buffer for 'format'
+void VertexBufferLayout::Create(VertexFormat format, unsigned int vcount,unsigned int icount, const float* vdata, const unsigned int* idata ){
+        m_stride = GetStride(format);
 
-void VertexBufferLayout::CreateTextureBufferLayout(unsigned int vcount,unsigned int icount, float* vdata, unsigned int* idata ){
-        // This layout uses x,y,z, and s,t
-        m_stride = 5;
-        
-        static_assert(sizeof(GLfloat)==sizeof(float),
-            "GLFloat and gloat are not the same size on this architecture");
-       
         // VertexArrays
-        glGenVertexArrays(1, &m_VAOId);
+        m_vertexArray.Create(GpuResourceType::VertexArray, "VertexBufferLayout", "Mesh");
 
-        glBindVertexArray(m_VAOId);
+        GLState::BindVertexArray(m_vertexArray.Get());
 
-        // Vertex VertexBufferLayout Object (VBO)
+        // Vertex Buffer Object (VBO)
         // Create a buffer (note we’ll see this pattern of code often in OpenGL)
         // TODO: Read this and understand what is going on
-        glGenBuffers(1, &m_vertexPositionBuffer); // selecting the buffer is
+        m_vertexPositionBuffer.Create(GpuResourceType::Buffer, "VertexBufferLayout", "Mesh"); // selecting the buffer is
                                                 // done by binding in OpenGL
                                                 // We tell OpenGL then how we want to 
                                                 // use our selected(or binded)
                                                 //  buffer with the arguments passed 
                                                 // into the function.
-        glBindBuffer(GL_ARRAY_BUFFER, m_vertexPositionBuffer);
+        GLState::BindBuffer(GL_ARRAY_BUFFER, m_vertexPositionBuffer.Get());
         glBufferData(GL_ARRAY_BUFFER, vcount*sizeof(float), vdata, GL_STATIC_DRAW);
+        m_vertexPositionBuffer.SetBytes(vcount*sizeof(float));
 
-        glEnableVertexAttribArray(0);
-        // Finally pass in our vertex data
-        glVertexAttribPointer(  0,   // Attribute 0, which will match layout in shader
-                                3,   // size (Number of components (2=x,y)  (3=x,y,z), etc.)
-                                GL_FLOAT, // Type of data
-                                GL_FALSE, // Is the data normalized
-                                sizeof(float)*m_stride, // Stride - Amount of bytes between each vertex.
-                                                // If we only have vertex data, then
-                                                // this is sizeof(float)*3 (or as a
-                                                // shortcut 0).
-                                                // That means our vertices(or whatever data) 
-                                                // is tightly packed, one after the other.
-                                                // If we add in vertex color information(3 more floats), 
-                                                // then this becomes 6, as we
-                                                // move 6*sizeof(float)
-                                                // to get to the next chunk of data.
-                                                // If we have normals, then we
-                                                // need to jump 3*sizeof(GL_FLOAT)
-                                                // bytes to get to our next vertex.
-                                0               // Pointer to the starting point of our
-                                                // data. If we are just grabbing vertices, 
-                                                // this is 0. But if we have
-                                                // some other attribute,
-                                                // (stored in the same data structure),
-                                                // this may vary if the very
-                                                // first element is some different attribute.
-                                                // If we had some data after
-                                                // (say normals), then we 
-                                                // would have an offset of 
-                                                // 3*sizeof(GL_FLOAT) for example
-        );
-
-        // Adding a new glVertexAttrib here. Make sure to enable it first
-        // - Make sure you use a new attribute(i.e. 0 is already used for position data!)
-        // - Make sure the correct offset is set (i.e. the starting point of the color data)
-
-        // Add two floats for texture coordinates
-        glEnableVertexAttribArray(1);
-        glVertexAttribPointer(1,2,GL_FLOAT, GL_TRUE,sizeof(float)*m_stride,(char*)(sizeof(float)*3));
+        SetAttributes(format);
 
-
-        // Another Vertex VertexBufferLayout Object (VBO)
+        // Another Vertex Buffer Object (VBO)
         // This time for your index buffer.
         // TODO: put these static_asserts somewhere
         static_assert(sizeof(unsigned int)==sizeof(GLuint),"Gluint not same size!");
 
-        glGenBuffers(1, &m_indexBufferObject);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexBufferObject);
+		// Setup an index buffer
+        m_indexBufferObject.Create(GpuResourceType::Buffer, "VertexBufferLayout", "Mesh");
+        GLState::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexBufferObject.Get());
         glBufferData(GL_ELEMENT_ARRAY_BUFFER, icount*sizeof(unsigned int), idata,GL_STATIC_DRAW);
-    }
+        m_indexBufferObject.SetBytes(icount*sizeof(unsigned int));
+        m_indexCount = icount;
+}
+
+void VertexBufferLayout::CreatePositionBufferLayout(unsigned int vcount,unsigned int icount, const float* vdata, const unsigned int* idata ){
+        Create(VertexFormat::Position, vcount, icount, vdata, idata);
+}
 
+void VertexBufferLayout::CreateTextureBufferLayout(unsigned int vcount,unsigned int icount, const float* vdata, const unsigned int* idata ){
+        Create(VertexFormat::Texture, vcount, icount, vdata, idata);
+}
 
 // A normal map layout needs the following attributes
 //
@@ -184,84 +163,11 @@ void VertexBufferLayout::CreateTextureBufferLayout(unsigned int vcount,unsigned
 // texcoords: s,t
 // tangent: t_x,t_y,t_z
 // bitangent b_x,b_y,b_z
-void VertexBufferLayout::CreateNormalBufferLayout(unsigned int vcount,unsigned int icount, float* vdata, unsigned int* idata ){
-		m_stride = 14;
-        
-        
-        static_assert(sizeof(GLfloat)==sizeof(float), "GLFloat and gloat are not the same size on this architecture");
-       
-        // VertexArrays
-        glGenVertexArrays(1, &m_VAOId);
-
-        glBindVertexArray(m_VAOId);
-
-        // Vertex Buffer Object (VBO)
-        // Create a buffer (note we’ll see this pattern of code often in OpenGL)
-        // TODO: Read this and understand what is going on
-        glGenBuffers(1, &m_vertexPositionBuffer); // selecting the buffer is
-                                                // done by binding in OpenGL
-                                                // We tell OpenGL then how we want to 
-                                                // use our selected(or binded)
-                                                //  buffer with the arguments passed 
-                                                // into the function.
-        glBindBuffer(GL_ARRAY_BUFFER, m_vertexPositionBuffer);
-        glBufferData(GL_ARRAY_BUFFER, vcount*sizeof(float), vdata, GL_STATIC_DRAW);
-
-        glEnableVertexAttribArray(0);
-        // Finally pass in our vertex data
-        glVertexAttribPointer(  0,   // Attribute 0, which will match layout in shader
-                                3,   // size (Number of components (2=x,y)  (3=x,y,z), etc.)
-                                GL_FLOAT, // Type of data
-                                GL_FALSE, // Is the data normalized
-                                sizeof(float)*m_stride, // Stride - Amount of bytes between each vertex.
-                                                // If we only have vertex data, then
-                                                // this is sizeof(float)*3 (or as a
-                                                // shortcut 0).
-                                                // That means our vertices(or whatever data) 
-                                                // is tightly packed, one after the other.
-                                                // If we add in vertex color information(3 more floats), 
-                                                // then this becomes 6, as we
-                                                // move 6*sizeof(float)
-                                                // to get to the next chunk of data.
-                                                // If we have normals, then we
-                                                // need to jump 3*sizeof(GL_FLOAT)
-                                                // bytes to get to our next vertex.
-                                0               // Pointer to the starting point of our
-                                                // data. If we are just grabbing vertices, 
-                                                // this is 0. But if we have
-                                                // some other attribute,
-                                                // (stored in the same data structure),
-                                                // this may vary if the very
-                                                // first element is some different attribute.
-                                                // If we had some data after
-                                                // (say normals), then we 
-                                                // would have an offset of 
-                                                // 3*sizeof(GL_FLOAT) for example
-        );
-
-        // Add three floats for normal coordinates
-        glEnableVertexAttribArray(1);
-        glVertexAttribPointer(1,3,GL_FLOAT, GL_FALSE,sizeof(float)*m_stride,(char*)(sizeof(float)*3));
-
-        // Add two floats for texture coordinates
-        glEnableVertexAttribArray(2);
-        glVertexAttribPointer(2,2,GL_FLOAT, GL_FALSE,sizeof(float)*m_stride,(char*)(sizeof(float)*6));
-
-        // Add three floats for tangent coordinates
-        glEnableVertexAttribArray(3);
-        glVertexAttribPointer(3,3,GL_FLOAT, GL_FALSE,sizeof(float)*m_stride,(char*)(sizeof(float)*8));
-
-        // Add three floats for bi-tangent coordinates
-        glEnableVertexAttribArray(4);
-        glVertexAttribPointer(4,3,GL_FLOAT, GL_FALSE,sizeof(float)*m_stride,(char*)(sizeof(float)*11));
-        
-		// Another Vertex Buffer Object (VBO)
-        // This time for your index buffer.
-        // TODO: put these static_asserts somewhere
-        static_assert(sizeof(unsigned int)==sizeof(GLuint),"Gluint not same size!");
+void VertexBufferLayout::CreateNormalBufferLayout(unsigned int vcount,unsigned int icount, const float* vdata, const unsigned int* idata ){
+        Create(VertexFormat::Normal, vcount, icount, vdata, idata);
+}
 
-		// Setup an index buffer
-        glGenBuffers(1, &m_indexBufferObject);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexBufferObject);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, icount*sizeof(unsigned int), idata,GL_STATIC_DRAW);
-    }
+// Retrieve how many indices were placed in the index buffer
+unsigned int VertexBufferLayout::GetIndexCount() const{
+    return m_indexCount;
+}
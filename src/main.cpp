@@ -4,6 +4,9 @@
 
 // Functionality that we created
 #include "SDLGraphicsProgram.hpp"
+#include "Benchmark.hpp"
+
+#include <cstring>
 
 
 // The main application loop
@@ -19,6 +22,11 @@ void preloop(){
 
 int main(int argc, char** argv){
 
+	// './lab --bench' runs the benchmarks instead of the demo
+	if(argc > 1 && std::strcmp(argv[1],"--bench")==0){
+		return Benchmark::Run();
+	}
+
 	// Create an instance of an object for a SDLGraphicsProgram
 	SDLGraphicsProgram mySDLGraphicsProgram(1280,720);
 	// Run our program forever